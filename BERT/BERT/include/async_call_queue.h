@@ -0,0 +1,85 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+/** number of completion threads (BERT adds one per language process) */
+#define ASYNC_COMPLETION_THREADS 4
+
+/** how long Stop waits for the threads (ms) */
+#define ASYNC_QUEUE_STOP_TIMEOUT 1000
+
+/**
+ * completion queue for async functions. an async function posts its call
+ * to the language service and returns to excel; the completion (the 
+ * xlAsyncReturn) runs here, along with the task that reads responses for
+ * a process when nobody else is reading it.
+ *
+ * there are several threads, so one slow task doesn't hold up the others. 
+ * these are not excel's main thread, so async functions can't use 
+ * callbacks (same as thread-safe functions). the threads are in the COM
+ * multithreaded apartment, so tasks can unmarshal interface pointers.
+ */
+class AsyncCallQueue {
+
+public:
+  typedef std::function<void()> Task;
+
+private:
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Task> tasks_;
+
+  std::vector<HANDLE> thread_handles_;
+  bool running_;
+
+private:
+
+  /** thread start routine */
+  static unsigned __stdcall StartThread(void *data);
+
+  /** instance thread routine */
+  void Run();
+
+public:
+  AsyncCallQueue();
+  ~AsyncCallQueue();
+
+public:
+
+  /** start threads */
+  void Start(uint32_t thread_count = ASYNC_COMPLETION_THREADS);
+
+  /** 
+   * stop threads and wait for them to exit. tasks that haven't started 
+   * are dropped; the calls they were waiting on are abandoned.
+   */
+  void Stop();
+
+  /** queue a task. thread safe */
+  void Post(Task task);
+
+};
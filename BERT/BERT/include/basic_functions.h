@@ -135,3 +135,49 @@ LPXLOPER12 BERTFunctionCall ## num ( \
 	, LPXLOPER12 input_15 = 0 \
 	){ return BERTFunctionCall( num-1000, input_0, input_1, input_2, input_3, input_4, input_5, input_6, input_7, input_8, input_9, input_10, input_11, input_12, input_13, input_14, input_15 ); }
 
+/**
+ * dispatcher for async functions (FUNCTION_FLAG_ASYNC). the last argument
+ * is excel's async handle; the result is returned later via xlAsyncReturn.
+ */
+__inline void BERTAsyncFunctionCall(
+  int findex,
+  LPXLOPER12 input_0
+  , LPXLOPER12 input_1
+  , LPXLOPER12 input_2
+  , LPXLOPER12 input_3
+  , LPXLOPER12 input_4
+  , LPXLOPER12 input_5
+  , LPXLOPER12 input_6
+  , LPXLOPER12 input_7
+  , LPXLOPER12 input_8
+  , LPXLOPER12 input_9
+  , LPXLOPER12 input_10
+  , LPXLOPER12 input_11
+  , LPXLOPER12 input_12
+  , LPXLOPER12 input_13
+  , LPXLOPER12 input_14
+  , LPXLOPER12 input_15
+  , LPXLOPER12 async_handle
+);
+
+#define BFCA(num) \
+void BERTAsyncFunctionCall ## num ( \
+	LPXLOPER12 input_0 \
+	, LPXLOPER12 input_1 \
+	, LPXLOPER12 input_2 \
+	, LPXLOPER12 input_3 \
+	, LPXLOPER12 input_4 \
+	, LPXLOPER12 input_5 \
+	, LPXLOPER12 input_6 \
+	, LPXLOPER12 input_7 \
+	, LPXLOPER12 input_8 \
+	, LPXLOPER12 input_9 \
+	, LPXLOPER12 input_10 \
+	, LPXLOPER12 input_11 \
+	, LPXLOPER12 input_12 \
+	, LPXLOPER12 input_13 \
+	, LPXLOPER12 input_14 \
+	, LPXLOPER12 input_15 \
+	, LPXLOPER12 async_handle \
+	){ BERTAsyncFunctionCall( num-1000, input_0, input_1, input_2, input_3, input_4, input_5, input_6, input_7, input_8, input_9, input_10, input_11, input_12, input_13, input_14, input_15, async_handle ); }
+
@@ -33,6 +33,9 @@
 #include "language_service.h"
 #include "callback_info.h"
 #include "file_change_watcher.h"
+#include "io_reactor.h"
+#include "async_call_queue.h"
+#include "frame_reader.h"
 #include "user_button.h"
 
 #define CONFIG_FILE_NAME "bert-config.json"
@@ -89,6 +92,26 @@ private:
   /** pipe name for talking to console */
   std::string console_pipe_name_;
 
+  /** console management pipe. this is run by the reactor */
+  HANDLE console_pipe_handle_;
+  OVERLAPPED console_read_io_;
+  OVERLAPPED console_write_io_;
+  FrameReader console_reader_;
+  bool console_pipe_reading_;
+  bool console_pipe_connected_;
+
+  /** single thread for language callback pipes and the console pipe */
+  IOReactor reactor_;
+
+  /** completion threads for async functions */
+  AsyncCallQueue async_calls_;
+
+  /** 
+   * excel's main thread (where we're initialized). only this thread can
+   * use the excel API; thread-safe functions run on other threads too.
+   */
+  DWORD main_thread_id_;
+
   /** some dev flags that get passed around */
   DWORD dev_flags_;
 
@@ -134,11 +157,20 @@ private:
 
 protected:
 
-  /** thread for running console pipe */
-  static unsigned __stdcall ConsoleThreadFunction(void *param);
+  /** create the console pipe and register with the reactor. reactor thread */
+  void OpenConsolePipe();
+
+  /** reactor handler: connect or read on the console pipe */
+  void ConsolePipeEvent();
+
+  /** reactor handler: notifications to send to the console */
+  void ConsoleNotificationEvent();
 
-  /** instance function for console pipe thread */
-  unsigned InstanceConsoleThreadFunction();
+  /** start a read on the console pipe, if we're connected and not reading */
+  void StartConsoleRead();
+
+  /** unregister and close the console pipe. reactor thread */
+  void CloseConsolePipe();
 
   /** starts the console process. this can be delayed until needed. */
   int StartConsoleProcess();
@@ -168,6 +200,12 @@ public:
 
   /** update (rebuild) function list; this must be done on the main thread */
   int UpdateFunctions();
+
+  /** 
+   * ask excel to run UpdateFunctions. this goes through COM, which gets 
+   * it onto the main thread, so don't call it from the main thread.
+   */
+  void RequestFunctionUpdate();
   
   void RegisterLanguageCalls();
 
@@ -181,6 +219,18 @@ public:
   /** single static instance of this class */
   static BERT* Instance();
 
+  /** accessor */
+  IOReactor &reactor() { return reactor_; }
+
+  /** accessor */
+  AsyncCallQueue &async_calls() { return async_calls_; }
+
+  /** accessor */
+  HANDLE job_handle() { return job_handle_; }
+
+  /** check if we're on excel's main thread */
+  bool on_main_thread() { return GetCurrentThreadId() == main_thread_id_; }
+
 public:
 
   /** sets COM pointers */
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "variable.pb.h"
+#include <vector>
+#include <string>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <functional>
+
+/** default batch size limit (calls); a full batch is sent at once */
+#define MAX_BATCH_SIZE 1024
+
+/** how long Stop waits for the thread (ms) */
+#define CALL_BATCHER_STOP_TIMEOUT 1000
+
+/** called with the response to an async call */
+typedef std::function<void(BERTBuffers::CallResponse&)> AsyncCompletion;
+
+/**
+ * collects async calls to the same function for a short window and sends
+ * them as one batch call (FUNCTION_FLAG_BATCH); the results are fanned out 
+ * to the individual completions. in a recalc wave of async cells this 
+ * turns thousands of round trips into a few.
+ *
+ * a batch goes out when the window expires (from the batcher's thread) or
+ * when it reaches the size limit (from the submitting thread). a batch of 
+ * one is sent as a regular call.
+ */
+class CallBatcher {
+
+public:
+
+  /** sends a call (batched or not); this is LanguageService::PostAsync */
+  typedef std::function<void(BERTBuffers::CallResponse &call, AsyncCompletion completion)> Sender;
+
+private:
+
+  typedef struct {
+    BERTBuffers::CallResponse call;
+    std::vector<AsyncCompletion> completions;
+    uint64_t deadline;
+  }
+  Batch;
+
+  /** open batches, by function name */
+  std::unordered_map<std::string, Batch> batches_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+
+  HANDLE thread_handle_;
+  bool running_;
+
+  uint32_t window_;
+  uint32_t max_size_;
+  Sender sender_;
+
+private:
+
+  /** thread start routine */
+  static unsigned __stdcall StartThread(void *data);
+
+  /** instance thread routine: send batches as their windows expire */
+  void Run();
+
+  /** send a batch and set up the fan-out */
+  void Send(Batch &batch);
+
+public:
+  CallBatcher();
+  ~CallBatcher();
+
+public:
+
+  /** start the thread. window is in ms */
+  void Start(uint32_t window, uint32_t max_size, Sender sender);
+
+  /** send anything pending, then stop the thread */
+  void Stop();
+
+  /** accessor */
+  bool running() { return running_; }
+
+  /** 
+   * add a call to the batch for its function. the call's arguments are
+   * moved into the batch. thread safe.
+   */
+  void Submit(BERTBuffers::CallResponse &call, AsyncCompletion completion);
+
+};
@@ -22,6 +22,9 @@
 /** */
 void RegisterFunctions();
 
+/** free an XLOPER12 we allocated (strings and arrays), and set it to nil */
+void resetXlOper(LPXLOPER12 x);
+
 /**
  * removes registered functions. this should be called before re-registering.
  *
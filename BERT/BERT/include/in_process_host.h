@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "variable.pb.h"
+#include "rhost_api.h"
+#include <string>
+#include <atomic>
+
+/**
+ * in-process language host (see rhost_api.h). the library runs the 
+ * language core in Excel's process, so a call is a function call instead 
+ * of a pipe round trip. it's a second instance of the language, with the 
+ * same startup code and source files as the process; the language service
+ * sends it waited calls to thread-safe functions, and everything else 
+ * still goes to the process.
+ *
+ * the library can't be unloaded, so once loaded it stays loaded. if 
+ * loading or starting fails, the host is just not available.
+ */
+class InProcessHost {
+
+private:
+  HMODULE module_;
+  RHostCallProcedure call_;
+  RHostReleaseProcedure release_;
+  RHostShutdownProcedure shutdown_;
+  bool available_;
+
+  /** calls run here, and time spent in them (microseconds), for the log */
+  std::atomic<uint64_t> call_count_;
+  std::atomic<uint64_t> call_time_;
+
+public:
+  InProcessHost();
+
+public:
+
+  /**
+   * load the library and start the language. the prepend path is added
+   * to PATH while we load (so the language's own libraries are found), 
+   * the same way we do when starting the process.
+   */
+  bool Load(const std::string &library_path, const std::string &prepend_path, const std::string &language_home, const std::string &bert_home);
+
+  /** 
+   * run a call. returns false if the host couldn't take it (not loaded, 
+   * or the message failed); then the caller should use the process.
+   */
+  bool Call(BERTBuffers::CallResponse &response, const BERTBuffers::CallResponse &call);
+
+  /** stop the language. no more calls after this. */
+  void Shutdown();
+
+  /** call count and average time, for the log */
+  std::string Report();
+
+  bool available() { return available_; }
+
+};
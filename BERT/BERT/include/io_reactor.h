@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <functional>
+
+/** how long Stop waits for the thread (ms) */
+#define IO_REACTOR_STOP_TIMEOUT 1000
+
+/** 
+ * the reactor waits on all its handles at once, so this is the most it 
+ * can hold (including its own wake event)
+ */
+#define IO_REACTOR_MAX_HANDLES MAXIMUM_WAIT_OBJECTS
+
+/**
+ * single thread for pipe i/o in BERT. this owns the callback pipe for 
+ * each language service and the console management pipe: each registers 
+ * an event handle (from an OVERLAPPED struct) with a handler, and the 
+ * reactor waits on all of them and dispatches completions.
+ *
+ * that keeps thread count (and wakeups) constant as languages are added.
+ * the thread is a COM STA, like the per-pipe threads it replaces.
+ *
+ * Add/Remove must be called on the reactor thread (from a handler, or 
+ * a task passed to Post). overlapped i/o should also be started on the 
+ * reactor thread, because pending i/o is cancelled when the issuing 
+ * thread exits. Post is safe from any thread.
+ *
+ * there's a hard limit on handles (IO_REACTOR_MAX_HANDLES). owners reserve
+ * what they need when they read their config (see Reserve), so that they
+ * can scale down (fewer workers) instead of failing later; Add refuses 
+ * anything past the limit.
+ */
+class IOReactor {
+
+public:
+  typedef std::function<void()> Handler;
+
+private:
+
+  /** signaled when there are posted tasks (or on stop) */
+  HANDLE wake_event_;
+
+  CRITICAL_SECTION critical_section_;
+
+  /** tasks posted from other threads */
+  std::vector<Handler> tasks_;
+
+  /** registered handles; the wake event is always first */
+  std::vector<HANDLE> handles_;
+  std::vector<Handler> handlers_;
+
+  /** handles promised by Reserve, including the wake event */
+  size_t reserved_;
+
+  uintptr_t thread_handle_;
+  DWORD thread_id_;
+  bool running_;
+
+private:
+
+  /** thread start routine */
+  static unsigned __stdcall StartThread(void *data);
+
+  /** instance thread routine */
+  void Run();
+
+  /** run posted tasks */
+  void RunTasks();
+
+  /** 
+   * after a failed wait, drop any handles that can't be waited on (closed 
+   * without being removed). returns the number dropped.
+   */
+  size_t RemoveInvalidHandles();
+
+public:
+  IOReactor();
+  ~IOReactor();
+
+public:
+
+  /** start the thread */
+  void Start();
+
+  /** stop the thread and wait for it to exit */
+  void Stop();
+
+  /** run a task on the reactor thread. thread safe */
+  void Post(Handler task);
+
+  /** 
+   * register an event handle. the handler is called when it's signaled. 
+   * returns false (and doesn't register) if the reactor is full.
+   */
+  bool Add(HANDLE handle, Handler handler);
+
+  /** 
+   * reserve room for up to count handles. returns the number reserved, 
+   * which is less than count if that would go over the limit. thread safe.
+   */
+  size_t Reserve(size_t count);
+
+  /** unregister a handle. safe to call from that handle's handler */
+  void Remove(HANDLE handle);
+
+  /** true if we're on the reactor thread */
+  bool on_thread() { return GetCurrentThreadId() == thread_id_; }
+
+  /** accessor */
+  bool running() { return running_; }
+
+};
@@ -36,11 +36,14 @@ public:
   std::string prepend_path_;
   uint32_t startup_resource_;
   std::string startup_resource_path_;
+  std::string sysimage_path_;
+  std::string host_library_path_;
   std::string home_;
 
   std::vector < std::string > home_candidates_;
 
   bool named_arguments_;
+  bool shared_server_;
   int32_t priority_;
 
 public:
@@ -66,9 +69,10 @@ public:
     , startup_resource_(startup_resource)
     , startup_resource_path_(startup_resource_path)
     , named_arguments_(named_arguments)
+    , shared_server_(false)
   {}
 
-  LanguageDescriptor() : priority_(0), named_arguments_(false) {}
+  LanguageDescriptor() : priority_(0), named_arguments_(false), shared_server_(false) {}
 
   LanguageDescriptor(const LanguageDescriptor &rhs)
     : name_(rhs.name_)
@@ -82,7 +86,10 @@ public:
     , home_(rhs.home_)
     , startup_resource_(rhs.startup_resource_)
     , startup_resource_path_(rhs.startup_resource_path_)
+    , sysimage_path_(rhs.sysimage_path_)
+    , host_library_path_(rhs.host_library_path_)
     , named_arguments_(rhs.named_arguments_)
+    , shared_server_(rhs.shared_server_)
     , home_candidates_(rhs.home_candidates_)
   {}
 
@@ -21,19 +21,78 @@
 
 #include "variable.pb.h"
 #include "message_utilities.h"
+#include "frame_reader.h"
+#include "result_stream.h"
 #include "function_descriptor.h"
 #include "callback_info.h"
+#include "call_batcher.h"
 #include <vector>
 #include <string>
 #include <regex>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <thread>
 
 #include "windows_api_functions.h"
 #include "process_exit_codes.h"
 
 #include "json11/json11.hpp"
 #include "language_desc.h"
+#include "in_process_host.h"
 
-#define PIPE_BUFFER_SIZE (1024*8)
+
+/** most worker processes per language (see LanguageService::workers_) */
+#define MAX_WORKER_COUNT 64
+
+/** how long to wait for the child process to create its pipe, in ms */
+#define CHILD_CONNECT_TIMEOUT 3000
+
+/** 
+ * how long to wait for another excel instance that's starting the shared
+ * server (see LanguageService::shared_), in ms
+ */
+#define SHARED_LAUNCH_TIMEOUT 10000
+
+/** 
+ * at shutdown we log memory telemetry from a language's processes; this 
+ * is how long we wait for all of them (ms). a busy process is skipped.
+ */
+#define MEMORY_REPORT_TIMEOUT 500
+
+/**
+ * startup phases, in ms (GetTickCount64, so ~15ms resolution). the 
+ * startup code isn't waited on, so it runs during the first function 
+ * listing, and shows up there.
+ */
+typedef struct {
+  uint64_t spawn;
+  uint64_t connect;
+  uint64_t initialize;
+  uint64_t list_functions;
+}
+StartupTiming;
+
+/** 
+ * if a call has a deadline or can be aborted, we check this often while
+ * waiting on it (ms). calls without either wait on the pipe only.
+ */
+#define CALL_POLL_INTERVAL 100
+
+/** 
+ * after we cancel a call, how long to wait for the child process to 
+ * respond before we give up on it (ms)
+ */
+#define CANCEL_GRACE_PERIOD 2000
+
+/** 
+ * polled while waiting on a call; return true to cancel it (for example
+ * if the user has pressed escape in Excel)
+ */
+typedef std::function<bool()> AbortCheck;
 
 /**
  * class abstracts common language service features
@@ -43,22 +102,17 @@ class LanguageService {
 private:
 
   /** ID generator */
-  static uint32_t transaction_id_;
+  static std::atomic<uint32_t> transaction_id_;
 
 protected:
 
-  /** get next id */
-  static uint32_t transaction_id() { return transaction_id_++; }
-
-  /** FIXME: unify threads, move to BERT */
-  static unsigned __stdcall CallbackThreadFunction(void *param) {
-    HRESULT hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
-    auto language_service = reinterpret_cast<LanguageService*>(param);
-    language_service->RunCallbackThread();
-    CoUninitialize();
-    return 0;
+  /** get next id. skips 0, which we don't use (see below) */
+  static uint32_t transaction_id() { 
+    uint32_t id = transaction_id_++;
+    if (!id) id = transaction_id_++;
+    return id;
   }
-  
+
 protected:
 
   LanguageDescriptor language_descriptor_;
@@ -72,6 +126,18 @@ protected:
   /** comms pipe */
   HANDLE pipe_handle_;
 
+  /** 
+   * the child process sets this once its pipe exists (see 
+   * APIFunctions::SignalReady), so we don't have to poll for it
+   */
+  HANDLE ready_event_;
+
+  /** when we started the child process (GetTickCount64) */
+  uint64_t launch_time_;
+
+  /** startup phases, for reporting */
+  StartupTiming startup_timing_;
+
   /** file extensions (lowercase) */
   //std::vector< std::string > file_extensions_;
 
@@ -84,6 +150,76 @@ protected:
   /** overlapped structure for nonblocking io */
   OVERLAPPED io_;
 
+  /** separate overlapped structure for writes, so we can write with a read pending */
+  OVERLAPPED write_io_;
+
+  /** serializes writes */
+  std::mutex write_mutex_;
+
+  /** 
+   * responses that arrived while we were reading for a different transaction, 
+   * by id. the reader stashes them here and wakes waiters. 
+   */
+  std::unordered_map<uint32_t, BERTBuffers::CallResponse> pending_responses_;
+
+  /** protects pending responses and the reader flag */
+  std::mutex pending_mutex_;
+
+  /** signaled when a response is stashed or the reader is released */
+  std::condition_variable pending_condition_;
+
+  /** set while some thread owns the read side of the pipe */
+  bool reader_active_;
+
+  /** 
+   * calls we gave up on (cancelled, and the child didn't respond in time).
+   * if the response turns up later, we drop it. protected by pending mutex.
+   */
+  std::unordered_set<uint32_t> abandoned_calls_;
+
+  /** 
+   * state for a call we're waiting on. deadline is in GetTickCount64 
+   * time, 0 for none. cancelled is the time we sent a cancel, 0 if we
+   * haven't. callbacks is set if we're on excel's main thread, and so 
+   * can handle callbacks while we wait. if abandon is set we don't cancel
+   * at the deadline, we just stop waiting.
+   */
+  typedef struct {
+    uint32_t id;
+    uint64_t deadline;
+    AbortCheck abort;
+    uint64_t cancelled;
+    const char *reason;
+    bool callbacks;
+    bool abandon;
+  }
+  CallWait;
+
+  /** an async call waiting for its response (see PostAsync) */
+  typedef struct {
+    AsyncCompletion completion;
+    CallWait wait;
+  }
+  AsyncCall;
+
+  /** 
+   * async calls waiting for a response, by id. there's no thread per 
+   * call: whichever thread is reading the pipe hands the response to 
+   * the completion, and if nobody is, a reader task runs on the async 
+   * queue until these are done. protected by pending mutex.
+   */
+  std::unordered_map<uint32_t, AsyncCall> async_pending_;
+
+  /** set while the async reader task is queued or running */
+  bool async_reader_;
+
+  /** 
+   * management pipe, for cancelling calls. this is opened the first time 
+   * we need it and written synchronously.
+   */
+  HANDLE management_pipe_handle_;
+  std::mutex management_mutex_;
+
   /** child process */
   DWORD child_process_id_;
     
@@ -93,8 +229,40 @@ protected:
   /** flag */
   bool configured_;
 
-  /** read/write buffer */
-  char *buffer_;
+  /** 
+   * lazy start: don't start the child process until the language is
+   * used (see EnsureStarted). ready is set once it's been started (or 
+   * we tried), or from the outset if it's not lazy. starting is set 
+   * while EnsureStarted is running.
+   */
+  bool lazy_start_;
+  std::atomic<bool> ready_;
+  std::atomic<bool> starting_;
+  std::recursive_mutex start_mutex_;
+
+  /** 
+   * held for a lazy language until it starts: source files to read and
+   * the application pointer. protected by the start mutex.
+   */
+  std::vector<std::string> pending_files_;
+  LPDISPATCH application_pointer_;
+
+  /** 
+   * set if we registered a lazy language's functions from the cached 
+   * list (see ReadFunctionCache), so they're refreshed when it starts
+   */
+  bool cached_functions_;
+
+  /** read buffer (sized from the frame prefix, reused) */
+  FrameReader reader_;
+
+  /** 
+   * callback pipe. this is run by the BERT i/o reactor (one thread for 
+   * all languages), so these are only touched on that thread.
+   */
+  HANDLE callback_pipe_handle_;
+  OVERLAPPED callback_io_;
+  FrameReader callback_reader_;
     
   /** path to executable */
   std::string child_path_;
@@ -102,6 +270,115 @@ protected:
   /** some dev flags that get passed around */
   DWORD dev_flags_;
 
+  /** shared ring size from config, in bytes. 0 means don't use a ring */
+  uint64_t shared_ring_size_;
+
+  /** chunk size for streamed results, in cells. 0 means don't stream */
+  uint32_t stream_chunk_cells_;
+
+  /** compress frames at least this big, in bytes. 0 means don't compress */
+  uint32_t compression_threshold_;
+
+  /** timeout for function calls, in ms. 0 means no timeout */
+  uint32_t call_timeout_;
+
+  /** 
+   * batching window for async calls, in ms (0 means don't batch), and the
+   * largest batch. batching runs on the first worker only; batches are 
+   * routed like any other call.
+   */
+  uint32_t batch_window_;
+  uint32_t batch_size_;
+  CallBatcher batcher_;
+
+  /** 
+   * worker pool. the service in BERT's language list is the first worker,
+   * and it owns the rest. function calls are spread over the pool; code,
+   * shell and system calls go to the first worker (which is also the one
+   * the console talks to). startup code and source files go to all of 
+   * them. workers have the same config; pipe names have a suffix.
+   */
+  std::vector<std::shared_ptr<LanguageService>> workers_;
+
+  /** pool size from config (including this one) */
+  uint32_t worker_count_;
+
+  /** route by function name instead of by load */
+  bool affinity_routing_;
+
+  /** rotates the starting point for least-loaded routing */
+  std::atomic<uint32_t> next_worker_;
+
+  /** calls in progress on this worker */
+  std::atomic<uint32_t> outstanding_calls_;
+
+  /** set on a pipe error; we stop routing calls here */
+  std::atomic<bool> failed_;
+
+  /** 
+   * warm standby: a spare process that has run the startup code and read
+   * the same source files, but takes no calls. if a worker (or this one)
+   * fails, the standby takes its place and we start another in the 
+   * background. if this one fails, the standby becomes the replacement,
+   * and everything we would have sent here goes there instead. failed 
+   * workers are retired, not released; there may still be threads 
+   * waiting on them.
+   *
+   * with standby on, the standby mutex protects the pool (workers_, 
+   * replacement, standby, retired) and the source file list. without it
+   * the pool doesn't change after startup, and we don't lock.
+   */
+  std::atomic<bool> standby_enabled_;
+  std::shared_ptr<LanguageService> standby_;
+  std::shared_ptr<LanguageService> replacement_;
+  std::vector<std::shared_ptr<LanguageService>> retired_;
+  std::mutex standby_mutex_;
+
+  /** source files read so far, in order, for the next standby */
+  std::vector<std::string> source_files_;
+
+  /** standby processes started, for pipe names */
+  uint32_t standby_count_;
+
+  /** runs PrepareStandby (see StartStandby) */
+  std::thread standby_thread_;
+
+  /** 
+   * in-process host (from config). waited calls to thread-safe functions
+   * run there, without the pipe; the host gets the same startup code and
+   * source files as the process. only the first worker has a host. calls
+   * in the host can't time out or be cancelled.
+   */
+  bool in_process_;
+  InProcessHost host_;
+
+  /**
+   * shared server (from config, if the language supports it). one process
+   * per user serves every excel instance; the first one to start it
+   * launches it, outside our job, and the rest connect to it. we register
+   * as a client and get our own callback pipe (and environment). there's
+   * no pool, standby or shared memory, and we don't shut it down; it exits
+   * on its own once the last client goes. the mutex covers checking for 
+   * the server, launching it and connecting (Launch to Connect).
+   */
+  bool shared_;
+  HANDLE launch_mutex_;
+
+  /** callback pipe, if the child process assigned one (shared server) */
+  std::string callback_pipe_name_;
+
+  /** kept so we can create workers with the same settings */
+  json11::Json config_;
+  json11::Json descriptor_json_;
+  std::string home_directory_;
+
+  /** streamed responses for other transactions, being assembled (by id) */
+  std::unordered_map<uint32_t, BERTBuffers::CallResponse> partial_responses_;
+
+  /** shared memory rings for large messages: calls (to child) and responses (from child) */
+  SharedRing call_ring_;
+  SharedRing response_ring_;
+
   /** single reference. FIXME: why? */
   CallbackInfo &callback_info_;
 
@@ -128,7 +405,9 @@ public:
   LanguageService(CallbackInfo &callback_info, COMObjectMap &object_map, DWORD dev_flags, const json11::Json &config, const std::string &home_directory, const json11::Json &descriptor);
 
   /** preferentially use the shutdown method instead of destructor */
-  ~LanguageService() {}
+  ~LanguageService() {
+    if (standby_thread_.joinable()) standby_thread_.join();
+  }
 
 public:
 
@@ -155,6 +434,55 @@ public:
   /** accessor */
   bool named_arguments() { return language_descriptor_.named_arguments_;  }
 
+  /** 
+   * can we send calls here? connected, no pipe errors, and the process is
+   * still running.
+   */
+  bool healthy();
+
+  /** workers including this one */
+  size_t worker_count() { return workers_.size() + 1; }
+
+  /** 
+   * reactor handles we need as configured: one callback pipe for each 
+   * worker and for the standby.
+   */
+  size_t reactor_handles() { return worker_count_ + (standby_enabled_ ? 1 : 0); }
+
+  /** 
+   * scale down to fit in the given number of reactor handles (see 
+   * IOReactor::Reserve): drop workers first, then the standby. call 
+   * before Launch.
+   */
+  void LimitReactorHandles(size_t available);
+
+  /** lazy start, from config */
+  bool lazy_start() { return lazy_start_; }
+
+  /** lazy, and not started (or starting) yet */
+  bool deferred() { return !ready_ && !starting_; }
+
+  /** we were connected, but the pipe failed or the process exited */
+  bool failed() { return connected_ && !healthy(); }
+
+  /** 
+   * log memory telemetry from each process in the pool (RSS, and what its
+   * memory policy has done; see MemoryPolicy). the requests all go out 
+   * first, and we wait at most timeout_ms in total; a process that's busy
+   * is skipped.
+   */
+  void LogMemoryReports(uint32_t timeout_ms);
+
+  /** ask the child process for memory telemetry. returns the call id */
+  uint32_t RequestMemoryReport();
+
+  /** 
+   * the response to RequestMemoryReport. empty if it doesn't report, or 
+   * it doesn't answer within timeout_ms (then the call is abandoned, not 
+   * cancelled).
+   */
+  std::string WaitMemoryReport(uint32_t id, uint32_t timeout_ms);
+
 protected:
 
   /** abstracts process launch (we use common properties) */
@@ -182,10 +510,27 @@ public:
   virtual int StartChildProcess(HANDLE job_handle);
 
   /**
-   * connects to child process. this part is generic. language-specific parts
-   * are now in the Initialize() method.
+   * start the child process, and any other workers, without waiting for 
+   * them. BERT launches every language before connecting to any, so the
+   * processes start in parallel.
+   */
+  void Launch(HANDLE job_handle);
+
+  /**
+   * connects to child process (see Launch). this part is generic. 
+   * language-specific parts are now in the Initialize() method. if 
+   * there's a worker pool, this connects the other workers as well; 
+   * workers that fail to connect are dropped.
+   */
+  void Connect();
+
+  /**
+   * start a lazy language, if it hasn't been started: launch, connect,
+   * initialize, then read any source files we were holding and ask BERT
+   * to update functions. this blocks the caller while the language
+   * starts. returns true if the language is connected.
    */
-  void Connect(HANDLE job_handle);
+  bool EnsureStarted();
 
   /** 
    * second of two-part connect/initialize. abstract. 
@@ -193,18 +538,56 @@ public:
    */
   void Initialize();
 
+  /**
+   * create shared memory rings and ask the child process to attach. if
+   * the child doesn't support rings (or it fails), we close them and 
+   * everything goes over the pipe as before.
+   */
+  void OpenSharedRings();
+
+  /**
+   * ask the child process to stream large results. this is optional; if
+   * the child doesn't support it, results come in one piece.
+   */
+  void EnableStreaming();
+
+  /**
+   * ask the child process to accept (and send) compressed frames. if it 
+   * doesn't support it, frames aren't compressed.
+   */
+  void EnableCompression();
+
+  /**
+   * check that the child process understands batched calls, and if so 
+   * start the batcher. otherwise async calls go one at a time.
+   */
+  void EnableBatching();
+
+  /** 
+   * register with a shared server, which gives us a callback pipe. this 
+   * has to be the first call.
+   */
+  void RegisterClient();
+
+  /** is there a shared server running (does the pipe exist)? */
+  bool SharedServerRunning();
+
   /**
    * clean up processes, pipes, resources
    */
   virtual void Shutdown();
 
   /**
-   * FIXME: we don't need to run separate threads for each client, just
-   * use a single thread (with mutliple pipes, of course). note that
-   * this may require either (1) splitting init in two, or (2) some 
-   * jujitsu on the running thread to insert a read handle.
+   * connect to the callback pipe, start a read and register with the 
+   * reactor. this has to run on the reactor thread (see IOReactor).
    */
-  void RunCallbackThread();
+  void OpenCallbackPipe();
+
+  /** reactor handler: a callback pipe read completed (or failed) */
+  void CallbackPipeEvent();
+
+  /** unregister and close the callback pipe. reactor thread */
+  void CloseCallbackPipe();
 
   /**
    * set COM pointer
@@ -221,8 +604,150 @@ public:
    * to assign an ID for transaction management.
    *
    * function call is based on class fields only, so the default should be generally usable.
+   *
+   * this is PostCall + WaitResponse (if the call wants a response).
+   *
+   * if stream is set and the result is streamed, the data goes to the 
+   * stream as it arrives and the response only holds the header. 
+   *
+   * function calls get the configured timeout (if any). if the timeout
+   * expires, or abort returns true, the call is cancelled and the response
+   * is an error.
+   */
+  void Call(BERTBuffers::CallResponse &response, BERTBuffers::CallResponse &call, ResultStream *stream = 0, AbortCheck abort = nullptr);
+
+  /**
+   * send a call without waiting. assigns and returns the transaction id. 
+   * you can post several calls and then collect the responses with 
+   * WaitResponse, in any order; responses are matched by id.
+   */
+  uint32_t PostCall(BERTBuffers::CallResponse &call);
+
+  /**
+   * make a function call without blocking. the call is routed and sent 
+   * like Call; when the response comes in, it's passed to completion on 
+   * BERT's async queue. the timeout applies, but 
+   * there's no abort check: excel cancels async functions by dropping 
+   * the handle, and the result is discarded.
+   *
+   * if batching is on, the call goes to the batcher first.
+   */
+  void CallAsync(BERTBuffers::CallResponse &call, AsyncCompletion completion);
+
+  /**
+   * wait for the response to a posted call. callbacks from the child 
+   * process are handled while waiting. responses for other transactions
+   * are held until somebody asks for them.
+   *
+   * if there's a timeout (ms) or an abort check, we cancel the call when 
+   * either one fires. if the child process doesn't respond to the cancel
+   * (within CANCEL_GRACE_PERIOD), we stop waiting and return an error.
+   * with cancel false, we stop waiting right away instead.
+   */
+  void WaitResponse(BERTBuffers::CallResponse &response, uint32_t id, ResultStream *stream = 0, uint32_t timeout_ms = 0, AbortCheck abort = nullptr, bool cancel = true);
+
+  /**
+   * ask the child process to cancel a call, via the management pipe. 
+   * this is out of band, so it works while the child is busy. we send our
+   * process id as well, which a shared server uses to find the call.
+   */
+  void CancelCall(uint32_t id);
+
+protected:
+
+  /** route and send an async call (see CallAsync), bypassing the batcher */
+  void PostAsync(BERTBuffers::CallResponse &call, AsyncCompletion completion);
+
+  /** 
+   * async queue task: read the pipe while there are async calls pending 
+   * and no other thread is reading. 
+   */
+  void ReadAsyncResponses();
+
+  /** 
+   * check async call timeouts: cancel calls that expired, and give up on
+   * (and complete with an error) calls that didn't respond to the cancel.
+   */
+  void PollAsyncCalls();
+
+  /** queue the completion for an async call. takes the response */
+  void CompleteAsync(AsyncCompletion completion, BERTBuffers::CallResponse &response);
+
+  /** complete all pending async calls with an error */
+  void FailAsyncCalls(const char *reason);
+
+  /** write a framed message (blocking until the write completes) */
+  void WriteFrame(const std::string &framed_message);
+
+  /** create (but don't start) a pool worker with the same settings */
+  std::shared_ptr<LanguageService> CreateWorker(uint32_t index);
+
+  /** 
+   * function list cache for lazy start. each time a lazy language lists 
+   * its functions we keep the response (in BERT_HOME\cache), so the next
+   * session can register them before the process is started. returns 
+   * false if there's no cached list.
+   */
+  bool ReadFunctionCache(BERTBuffers::CallResponse &response);
+
+  /** save a list-functions response (see ReadFunctionCache) */
+  void WriteFunctionCache(const BERTBuffers::CallResponse &response);
+
+  /** path for the function list cache */
+  std::string FunctionCachePath();
+
+  /** 
+   * start and initialize a standby, replay the source files into it, and 
+   * then make it available. this blocks, so it runs on its own thread 
+   * (see StartStandby).
+   */
+  void PrepareStandby();
+
+  /** run PrepareStandby in the background. one at a time */
+  void StartStandby();
+
+  /** 
+   * put the standby in a pool slot (0 is this process). returns false if
+   * there's no standby ready. call with the standby mutex held.
+   */
+  bool PromoteStandby(size_t index);
+
+  /** 
+   * the process handling calls for this one: this, or the replacement 
+   * if we failed. if we (or the replacement) failed and there's a 
+   * standby, it's promoted here.
+   */
+  LanguageService* Primary();
+
+  /** copy of the worker list (safe if a standby is promoted meanwhile) */
+  std::vector<std::shared_ptr<LanguageService>> Workers();
+
+  /** 
+   * pick a worker for a function call: least loaded (with ties rotating)
+   * or by function name, skipping workers that aren't healthy.
+   */
+  LanguageService* SelectWorker(const BERTBuffers::CallResponse &call);
+
+  /** read loop: read until we get the response for the call */
+  void ReadResponses(BERTBuffers::CallResponse &response, CallWait &wait, ResultStream *stream);
+
+  /** 
+   * check deadline and abort for a call, and cancel it if necessary. 
+   * returns true if we've cancelled and the grace period has passed, or
+   * (abandon) at the deadline.
    */
-  void Call(BERTBuffers::CallResponse &response, BERTBuffers::CallResponse &call);
+  bool PollCancel(CallWait &wait);
+
+  /** 
+   * cancel the pending read on the main pipe. returns false if the read
+   * completed anyway, in which case the data is still there to handle.
+   */
+  bool CancelRead();
+
+  /** check stashed responses. call with pending mutex held */
+  bool TakePendingResponse(BERTBuffers::CallResponse &response, uint32_t id);
+
+public:
 
   /**
    * replace tokens in string. FIXME: make more generic
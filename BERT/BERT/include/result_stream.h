@@ -0,0 +1,42 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "variable.pb.h"
+
+/**
+ * receiver for a streamed result (see FRAME_FLAG_STREAM). the header has 
+ * the array shape and names; chunks follow with the data, in column-major
+ * order. pass one to Call to build the result while chunks are still 
+ * arriving; otherwise the chunks are assembled into the response.
+ */
+class ResultStream {
+public:
+
+  /** the first frame: shape and names, no data */
+  virtual void Begin(const BERTBuffers::Array &header) = 0;
+
+  /** the next chunk of data */
+  virtual void Append(const BERTBuffers::Array &chunk) = 0;
+
+  /** called after the last chunk */
+  virtual void End() = 0;
+
+};
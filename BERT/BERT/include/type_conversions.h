@@ -21,6 +21,8 @@
 
 #include <iomanip>
 
+#include "result_stream.h"
+
 /**
  * conversion utilities. converting between Excel/COM/PB types.
  *
@@ -39,22 +41,16 @@ public:
    */
   static std::string WideStringToUtf8(const WCHAR *source, int len) {
 
-    // FIXME: static buffer -- not thread safe. lock, use TLS 
-    // storage, or allocate on each call
-
-    static char *buffer = 0;
-    static int buffer_length = 0;
+    // convert directly into the result, so this is safe to call from 
+    // multiple threads (thread-safe functions).
 
     int u8_length = WideCharToMultiByte(CP_UTF8, 0, source, len, 0, 0, 0, 0);
 
-    if (buffer_length < u8_length) {
-      if (buffer) delete buffer;
-      buffer_length = ((u8_length / 1024) + 1) * 1024;
-      buffer = new char[buffer_length];
+    std::string u8;
+    if (u8_length > 0) {
+      u8.resize(u8_length);
+      WideCharToMultiByte(CP_UTF8, 0, source, len, &(u8[0]), u8_length, 0, 0);
     }
-
-    WideCharToMultiByte(CP_UTF8, 0, source, len, buffer, buffer_length, 0, 0);
-    std::string u8(buffer, u8_length);
     return u8;
 
   }
@@ -627,3 +623,105 @@ public:
   }
 
 };
+
+/**
+ * builds an xltypeMulti from a streamed result as the chunks arrive, so we 
+ * never hold the whole result as PB data. the layout matches VariableToXLOPER 
+ * (names in the first row/column, data column-major). cells are #N/A until 
+ * they're filled, so a short stream still returns a valid array.
+ */
+class XLOPERResultStream : public ResultStream {
+
+public:
+  XLOPERResultStream(LPXLOPER12 x)
+    : x_(x)
+    , rows_(0)
+    , cols_(0)
+    , r_offset_(0)
+    , c_offset_(0)
+    , index_(0)
+    , count_(0)
+    , started_(false)
+  {}
+
+public:
+
+  /** accessor: true if we got a stream (and the result is in the xloper) */
+  bool started() { return started_; }
+
+  virtual void Begin(const BERTBuffers::Array &header) {
+
+    started_ = true;
+
+    int rows = header.rows();
+    int cols = header.cols();
+    count_ = rows * cols;
+
+    if (count_ <= 0) {
+      x_->xltype = xltypeErr;
+      x_->val.err = xlerrValue;
+      return;
+    }
+
+    bool col_names = (header.colnames_size() == cols);
+    bool row_names = (header.rownames_size() == rows);
+
+    r_offset_ = col_names ? 1 : 0;
+    c_offset_ = row_names ? 1 : 0;
+    rows_ = rows + r_offset_;
+    cols_ = cols + c_offset_;
+
+    x_->xltype = xltypeMulti | xlbitDLLFree;
+    x_->val.array.rows = rows_;
+    x_->val.array.columns = cols_;
+    x_->val.array.lparray = new XLOPER12[rows_ * cols_];
+
+    for (int i = 0; i < rows_ * cols_; i++) {
+      x_->val.array.lparray[i].xltype = xltypeErr;
+      x_->val.array.lparray[i].val.err = xlerrNA;
+    }
+
+    if (col_names && row_names) Convert::StringToXLOPER(&(x_->val.array.lparray[0]), "");
+    if (col_names) {
+      for (int c = 0; c < cols; c++) Convert::StringToXLOPER(&(x_->val.array.lparray[c + c_offset_]), header.colnames(c));
+    }
+    if (row_names) {
+      for (int r = 0; r < rows; r++) Convert::StringToXLOPER(&(x_->val.array.lparray[(r + r_offset_) * cols_]), header.rownames(r));
+    }
+
+  }
+
+  virtual void Append(const BERTBuffers::Array &chunk) {
+    if (!(x_->xltype & xltypeMulti)) return;
+    int data_rows = rows_ - r_offset_;
+    for (const auto &element : chunk.data()) {
+      if (index_ >= count_) break;
+      int r = (index_ % data_rows) + r_offset_;
+      int c = (index_ / data_rows) + c_offset_;
+      Convert::VariableToXLOPER(&(x_->val.array.lparray[r * cols_ + c]), element);
+      index_++;
+    }
+  }
+
+  virtual void End() {
+    if (index_ != count_) std::cerr << "WARNING: streamed result has " << index_ << " of " << count_ << " values" << std::endl;
+  }
+
+private:
+  LPXLOPER12 x_;
+
+  /** dimensions of the xloper, including names */
+  int rows_;
+  int cols_;
+
+  /** offsets for names */
+  int r_offset_;
+  int c_offset_;
+
+  /** next data cell, and data cell count */
+  int index_;
+  int count_;
+
+  bool started_;
+
+};
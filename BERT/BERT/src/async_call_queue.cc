@@ -0,0 +1,94 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+#include "async_call_queue.h"
+
+AsyncCallQueue::AsyncCallQueue()
+  : running_(false)
+{}
+
+AsyncCallQueue::~AsyncCallQueue() {
+  Stop();
+}
+
+unsigned __stdcall AsyncCallQueue::StartThread(void *data) {
+
+  // tasks can use COM (RequestFunctionUpdate unmarshals the application
+  // pointer). these threads block on the queue rather than pumping 
+  // messages, so they join the MTA instead of creating an STA each.
+
+  HRESULT hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+  AsyncCallQueue *queue = reinterpret_cast<AsyncCallQueue*>(data);
+  queue->Run();
+  if (SUCCEEDED(hr)) CoUninitialize();
+  return 0;
+}
+
+void AsyncCallQueue::Start(uint32_t thread_count) {
+  if (running_) return;
+  running_ = true;
+  for (uint32_t i = 0; i < thread_count; i++) {
+    uintptr_t thread_handle = _beginthreadex(0, 0, StartThread, this, 0, 0);
+    if (thread_handle) thread_handles_.push_back((HANDLE)thread_handle);
+  }
+}
+
+void AsyncCallQueue::Stop() {
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) return;
+    running_ = false;
+    tasks_.clear();
+  }
+  condition_.notify_all();
+
+  if (thread_handles_.size()) {
+    if (WaitForMultipleObjects((DWORD)thread_handles_.size(), thread_handles_.data(), TRUE, ASYNC_QUEUE_STOP_TIMEOUT) == WAIT_TIMEOUT) {
+      DebugOut("async completion threads did not exit\n");
+    }
+    for (auto thread_handle : thread_handles_) CloseHandle(thread_handle);
+    thread_handles_.clear();
+  }
+
+}
+
+void AsyncCallQueue::Post(Task task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) return;
+    tasks_.push_back(task);
+  }
+  condition_.notify_one();
+}
+
+void AsyncCallQueue::Run() {
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (running_ && tasks_.empty()) condition_.wait(lock);
+      if (!running_) return;
+      task = tasks_.front();
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
@@ -25,6 +25,50 @@
 #include "basic_functions.h"
 #include "type_conversions.h"
 #include "string_utilities.h"
+#include "excel_api_functions.h"
+
+/**
+ * check if the user has pressed escape to stop the recalc. this is polled
+ * while we wait on a function call, so we can cancel it.
+ */
+static bool ExcelAbort() {
+  XLOPER12 result;
+  if (Excel12(xlAbort, &result, 0) != xlretSuccess) return false;
+  return (result.xltype == xltypeBool && result.val.xbool);
+}
+
+/**
+ * build a function call from excel arguments. returns the function 
+ * descriptor, or null if there's no function at this index.
+ */
+static FunctionDescriptor* CreateFunctionCall(BERTBuffers::CallResponse &call, int index, LPXLOPER12 *arglist) {
+
+	BERT *bert = BERT::Instance();
+
+	if (index < 0 || index >= bert->function_list_.size()) return 0;
+
+	call.set_wait(true);
+	auto function_call = call.mutable_function_call();
+
+  auto function_descriptor = bert->function_list_[index];
+
+  function_call->set_function(function_descriptor->name_);
+  function_call->set_flags(function_descriptor->flags_);
+
+	int argcount = 16;
+	for (; argcount && arglist[argcount - 1]->xltype == xltypeMissing; argcount--);
+
+  int function_arguments = function_descriptor->language_service_->named_arguments() ? 
+    function_descriptor->arguments_.size() : 0;
+
+	for (int i = 0; i < argcount; i++) {
+		auto argument = function_call->add_arguments();
+		Convert::XLOPERToVariable(argument, arglist[i]);
+    if(i < function_arguments) argument->set_name(function_descriptor->arguments_[i]->name_);
+	}
+
+  return function_descriptor.get();
+}
 
 LPXLOPER12 BERTFunctionCall(
 	int index
@@ -45,45 +89,32 @@ LPXLOPER12 BERTFunctionCall(
 	, LPXLOPER12 input_14
 	, LPXLOPER12 input_15
 ) {
-	static XLOPER12 rslt;
+	// excel may call this on several threads at once (thread-safe functions), 
+	// so the result is per-thread. excel copies it and then calls xlAutoFree12.
+
+	thread_local XLOPER12 rslt;
 
 	rslt.xltype = xltypeErr;
 	rslt.val.err = xlerrName;
 
-	BERT *bert = BERT::Instance();
-
-	if (index < 0 || index >= bert->function_list_.size()) return &rslt;
-
 	LPXLOPER12 arglist[16] = {
 		input_0, input_1, input_2, input_3, input_4, input_5, input_6, input_7,
 		input_8, input_9, input_10, input_11, input_12, input_13, input_14, input_15
 	};
 
 	BERTBuffers::CallResponse call, response;
-	call.set_wait(true);
-	auto function_call = call.mutable_function_call();
 
-  auto function_descriptor = bert->function_list_[index];
+  auto function_descriptor = CreateFunctionCall(call, index, arglist);
+  if (!function_descriptor) return &rslt;
 
-  function_call->set_function(function_descriptor->name_);
-  function_call->set_flags(function_descriptor->flags_);
+  // large results may be streamed, in which case the stream builds the 
+  // result as it arrives (and the response only has the header).
 
-	int argcount = 16;
-	for (; argcount && arglist[argcount - 1]->xltype == xltypeMissing; argcount--);
+  XLOPERResultStream stream(&rslt);
+  function_descriptor->language_service_->Call(response, call, &stream, ExcelAbort);
 
-  int function_arguments = function_descriptor->language_service_->named_arguments() ? 
-    function_descriptor->arguments_.size() : 0;
-
-	for (int i = 0; i < argcount; i++) {
-		auto argument = function_call->add_arguments();
-		Convert::XLOPERToVariable(argument, arglist[i]);
-    if(i < function_arguments) argument->set_name(function_descriptor->arguments_[i]->name_);
-	}
-
-  //bert->CallLanguage(function_descriptor->language_key_, response, call);
-  function_descriptor->language_service_->Call(response, call);
-
-  if (response.operation_case() == BERTBuffers::CallResponse::OperationCase::kResult) {
+  if (stream.started()) {}
+  else if (response.operation_case() == BERTBuffers::CallResponse::OperationCase::kResult) {
     Convert::VariableToXLOPER(&rslt, response.result());
   }
   else {
@@ -94,9 +125,67 @@ LPXLOPER12 BERTFunctionCall(
 	return &rslt;
 }
 
+void BERTAsyncFunctionCall(
+	int index
+	, LPXLOPER12 input_0
+	, LPXLOPER12 input_1
+	, LPXLOPER12 input_2
+	, LPXLOPER12 input_3
+	, LPXLOPER12 input_4
+	, LPXLOPER12 input_5
+	, LPXLOPER12 input_6
+	, LPXLOPER12 input_7
+	, LPXLOPER12 input_8
+	, LPXLOPER12 input_9
+	, LPXLOPER12 input_10
+	, LPXLOPER12 input_11
+	, LPXLOPER12 input_12
+	, LPXLOPER12 input_13
+	, LPXLOPER12 input_14
+	, LPXLOPER12 input_15
+	, LPXLOPER12 async_handle
+) {
+	LPXLOPER12 arglist[16] = {
+		input_0, input_1, input_2, input_3, input_4, input_5, input_6, input_7,
+		input_8, input_9, input_10, input_11, input_12, input_13, input_14, input_15
+	};
+
+	// the handle is only valid for this call, so keep a copy. the result 
+	// goes back with xlAsyncReturn (from the completion thread); excel 
+	// copies it, so we free it ourselves.
+
+	XLOPER12 handle = *async_handle;
+	BERTBuffers::CallResponse call;
+
+	auto function_descriptor = CreateFunctionCall(call, index, arglist);
+	if (!function_descriptor) {
+		XLOPER12 rslt;
+		rslt.xltype = xltypeErr;
+		rslt.val.err = xlerrName;
+		Excel12(xlAsyncReturn, 0, 2, &handle, &rslt);
+		return;
+	}
+
+  function_descriptor->language_service_->CallAsync(call, [handle](BERTBuffers::CallResponse &response) mutable {
+    XLOPER12 rslt;
+    if (response.operation_case() == BERTBuffers::CallResponse::OperationCase::kResult) {
+      Convert::VariableToXLOPER(&rslt, response.result());
+    }
+    else {
+      rslt.xltype = xltypeErr;
+      rslt.val.err = xlerrValue;
+    }
+    if (Excel12(xlAsyncReturn, 0, 2, &handle, &rslt) != xlretSuccess) {
+      DebugOut("xlAsyncReturn failed (recalc cancelled?)\n");
+    }
+    resetXlOper(&rslt);
+  });
+
+}
+
 LPXLOPER12 BERT_Exec_Generic(uint32_t language_key, LPXLOPER12 code) {
  
-  static XLOPER12 rslt; // TLS?
+  thread_local XLOPER12 rslt;
 
   if (code->xltype != xltypeStr) {
     rslt.xltype = xltypeErr;
@@ -134,7 +223,7 @@ LPXLOPER12 BERT_Call_Generic(uint32_t language_key, LPXLOPER12 func,
   LPXLOPER12 arg8, LPXLOPER12 arg9, LPXLOPER12 arg10, LPXLOPER12 arg11,
   LPXLOPER12 arg12, LPXLOPER12 arg13, LPXLOPER12 arg14, LPXLOPER12 arg15) {
 
-  static XLOPER12 rslt; // TLS?
+  thread_local XLOPER12 rslt;
 
   if (func->xltype != xltypeStr) {
     rslt.xltype = xltypeErr;
@@ -2278,3 +2367,2053 @@ BFC(3045);
 BFC(3046);
 BFC(3047);
 
+// async placeholders (same indexes as above)
+
+BFCA(1000);
+BFCA(1001);
+BFCA(1002);
+BFCA(1003);
+BFCA(1004);
+BFCA(1005);
+BFCA(1006);
+BFCA(1007);
+BFCA(1008);
+BFCA(1009);
+BFCA(1010);
+BFCA(1011);
+BFCA(1012);
+BFCA(1013);
+BFCA(1014);
+BFCA(1015);
+BFCA(1016);
+BFCA(1017);
+BFCA(1018);
+BFCA(1019);
+BFCA(1020);
+BFCA(1021);
+BFCA(1022);
+BFCA(1023);
+BFCA(1024);
+BFCA(1025);
+BFCA(1026);
+BFCA(1027);
+BFCA(1028);
+BFCA(1029);
+BFCA(1030);
+BFCA(1031);
+BFCA(1032);
+BFCA(1033);
+BFCA(1034);
+BFCA(1035);
+BFCA(1036);
+BFCA(1037);
+BFCA(1038);
+BFCA(1039);
+BFCA(1040);
+BFCA(1041);
+BFCA(1042);
+BFCA(1043);
+BFCA(1044);
+BFCA(1045);
+BFCA(1046);
+BFCA(1047);
+BFCA(1048);
+BFCA(1049);
+BFCA(1050);
+BFCA(1051);
+BFCA(1052);
+BFCA(1053);
+BFCA(1054);
+BFCA(1055);
+BFCA(1056);
+BFCA(1057);
+BFCA(1058);
+BFCA(1059);
+BFCA(1060);
+BFCA(1061);
+BFCA(1062);
+BFCA(1063);
+BFCA(1064);
+BFCA(1065);
+BFCA(1066);
+BFCA(1067);
+BFCA(1068);
+BFCA(1069);
+BFCA(1070);
+BFCA(1071);
+BFCA(1072);
+BFCA(1073);
+BFCA(1074);
+BFCA(1075);
+BFCA(1076);
+BFCA(1077);
+BFCA(1078);
+BFCA(1079);
+BFCA(1080);
+BFCA(1081);
+BFCA(1082);
+BFCA(1083);
+BFCA(1084);
+BFCA(1085);
+BFCA(1086);
+BFCA(1087);
+BFCA(1088);
+BFCA(1089);
+BFCA(1090);
+BFCA(1091);
+BFCA(1092);
+BFCA(1093);
+BFCA(1094);
+BFCA(1095);
+BFCA(1096);
+BFCA(1097);
+BFCA(1098);
+BFCA(1099);
+BFCA(1100);
+BFCA(1101);
+BFCA(1102);
+BFCA(1103);
+BFCA(1104);
+BFCA(1105);
+BFCA(1106);
+BFCA(1107);
+BFCA(1108);
+BFCA(1109);
+BFCA(1110);
+BFCA(1111);
+BFCA(1112);
+BFCA(1113);
+BFCA(1114);
+BFCA(1115);
+BFCA(1116);
+BFCA(1117);
+BFCA(1118);
+BFCA(1119);
+BFCA(1120);
+BFCA(1121);
+BFCA(1122);
+BFCA(1123);
+BFCA(1124);
+BFCA(1125);
+BFCA(1126);
+BFCA(1127);
+BFCA(1128);
+BFCA(1129);
+BFCA(1130);
+BFCA(1131);
+BFCA(1132);
+BFCA(1133);
+BFCA(1134);
+BFCA(1135);
+BFCA(1136);
+BFCA(1137);
+BFCA(1138);
+BFCA(1139);
+BFCA(1140);
+BFCA(1141);
+BFCA(1142);
+BFCA(1143);
+BFCA(1144);
+BFCA(1145);
+BFCA(1146);
+BFCA(1147);
+BFCA(1148);
+BFCA(1149);
+BFCA(1150);
+BFCA(1151);
+BFCA(1152);
+BFCA(1153);
+BFCA(1154);
+BFCA(1155);
+BFCA(1156);
+BFCA(1157);
+BFCA(1158);
+BFCA(1159);
+BFCA(1160);
+BFCA(1161);
+BFCA(1162);
+BFCA(1163);
+BFCA(1164);
+BFCA(1165);
+BFCA(1166);
+BFCA(1167);
+BFCA(1168);
+BFCA(1169);
+BFCA(1170);
+BFCA(1171);
+BFCA(1172);
+BFCA(1173);
+BFCA(1174);
+BFCA(1175);
+BFCA(1176);
+BFCA(1177);
+BFCA(1178);
+BFCA(1179);
+BFCA(1180);
+BFCA(1181);
+BFCA(1182);
+BFCA(1183);
+BFCA(1184);
+BFCA(1185);
+BFCA(1186);
+BFCA(1187);
+BFCA(1188);
+BFCA(1189);
+BFCA(1190);
+BFCA(1191);
+BFCA(1192);
+BFCA(1193);
+BFCA(1194);
+BFCA(1195);
+BFCA(1196);
+BFCA(1197);
+BFCA(1198);
+BFCA(1199);
+BFCA(1200);
+BFCA(1201);
+BFCA(1202);
+BFCA(1203);
+BFCA(1204);
+BFCA(1205);
+BFCA(1206);
+BFCA(1207);
+BFCA(1208);
+BFCA(1209);
+BFCA(1210);
+BFCA(1211);
+BFCA(1212);
+BFCA(1213);
+BFCA(1214);
+BFCA(1215);
+BFCA(1216);
+BFCA(1217);
+BFCA(1218);
+BFCA(1219);
+BFCA(1220);
+BFCA(1221);
+BFCA(1222);
+BFCA(1223);
+BFCA(1224);
+BFCA(1225);
+BFCA(1226);
+BFCA(1227);
+BFCA(1228);
+BFCA(1229);
+BFCA(1230);
+BFCA(1231);
+BFCA(1232);
+BFCA(1233);
+BFCA(1234);
+BFCA(1235);
+BFCA(1236);
+BFCA(1237);
+BFCA(1238);
+BFCA(1239);
+BFCA(1240);
+BFCA(1241);
+BFCA(1242);
+BFCA(1243);
+BFCA(1244);
+BFCA(1245);
+BFCA(1246);
+BFCA(1247);
+BFCA(1248);
+BFCA(1249);
+BFCA(1250);
+BFCA(1251);
+BFCA(1252);
+BFCA(1253);
+BFCA(1254);
+BFCA(1255);
+BFCA(1256);
+BFCA(1257);
+BFCA(1258);
+BFCA(1259);
+BFCA(1260);
+BFCA(1261);
+BFCA(1262);
+BFCA(1263);
+BFCA(1264);
+BFCA(1265);
+BFCA(1266);
+BFCA(1267);
+BFCA(1268);
+BFCA(1269);
+BFCA(1270);
+BFCA(1271);
+BFCA(1272);
+BFCA(1273);
+BFCA(1274);
+BFCA(1275);
+BFCA(1276);
+BFCA(1277);
+BFCA(1278);
+BFCA(1279);
+BFCA(1280);
+BFCA(1281);
+BFCA(1282);
+BFCA(1283);
+BFCA(1284);
+BFCA(1285);
+BFCA(1286);
+BFCA(1287);
+BFCA(1288);
+BFCA(1289);
+BFCA(1290);
+BFCA(1291);
+BFCA(1292);
+BFCA(1293);
+BFCA(1294);
+BFCA(1295);
+BFCA(1296);
+BFCA(1297);
+BFCA(1298);
+BFCA(1299);
+BFCA(1300);
+BFCA(1301);
+BFCA(1302);
+BFCA(1303);
+BFCA(1304);
+BFCA(1305);
+BFCA(1306);
+BFCA(1307);
+BFCA(1308);
+BFCA(1309);
+BFCA(1310);
+BFCA(1311);
+BFCA(1312);
+BFCA(1313);
+BFCA(1314);
+BFCA(1315);
+BFCA(1316);
+BFCA(1317);
+BFCA(1318);
+BFCA(1319);
+BFCA(1320);
+BFCA(1321);
+BFCA(1322);
+BFCA(1323);
+BFCA(1324);
+BFCA(1325);
+BFCA(1326);
+BFCA(1327);
+BFCA(1328);
+BFCA(1329);
+BFCA(1330);
+BFCA(1331);
+BFCA(1332);
+BFCA(1333);
+BFCA(1334);
+BFCA(1335);
+BFCA(1336);
+BFCA(1337);
+BFCA(1338);
+BFCA(1339);
+BFCA(1340);
+BFCA(1341);
+BFCA(1342);
+BFCA(1343);
+BFCA(1344);
+BFCA(1345);
+BFCA(1346);
+BFCA(1347);
+BFCA(1348);
+BFCA(1349);
+BFCA(1350);
+BFCA(1351);
+BFCA(1352);
+BFCA(1353);
+BFCA(1354);
+BFCA(1355);
+BFCA(1356);
+BFCA(1357);
+BFCA(1358);
+BFCA(1359);
+BFCA(1360);
+BFCA(1361);
+BFCA(1362);
+BFCA(1363);
+BFCA(1364);
+BFCA(1365);
+BFCA(1366);
+BFCA(1367);
+BFCA(1368);
+BFCA(1369);
+BFCA(1370);
+BFCA(1371);
+BFCA(1372);
+BFCA(1373);
+BFCA(1374);
+BFCA(1375);
+BFCA(1376);
+BFCA(1377);
+BFCA(1378);
+BFCA(1379);
+BFCA(1380);
+BFCA(1381);
+BFCA(1382);
+BFCA(1383);
+BFCA(1384);
+BFCA(1385);
+BFCA(1386);
+BFCA(1387);
+BFCA(1388);
+BFCA(1389);
+BFCA(1390);
+BFCA(1391);
+BFCA(1392);
+BFCA(1393);
+BFCA(1394);
+BFCA(1395);
+BFCA(1396);
+BFCA(1397);
+BFCA(1398);
+BFCA(1399);
+BFCA(1400);
+BFCA(1401);
+BFCA(1402);
+BFCA(1403);
+BFCA(1404);
+BFCA(1405);
+BFCA(1406);
+BFCA(1407);
+BFCA(1408);
+BFCA(1409);
+BFCA(1410);
+BFCA(1411);
+BFCA(1412);
+BFCA(1413);
+BFCA(1414);
+BFCA(1415);
+BFCA(1416);
+BFCA(1417);
+BFCA(1418);
+BFCA(1419);
+BFCA(1420);
+BFCA(1421);
+BFCA(1422);
+BFCA(1423);
+BFCA(1424);
+BFCA(1425);
+BFCA(1426);
+BFCA(1427);
+BFCA(1428);
+BFCA(1429);
+BFCA(1430);
+BFCA(1431);
+BFCA(1432);
+BFCA(1433);
+BFCA(1434);
+BFCA(1435);
+BFCA(1436);
+BFCA(1437);
+BFCA(1438);
+BFCA(1439);
+BFCA(1440);
+BFCA(1441);
+BFCA(1442);
+BFCA(1443);
+BFCA(1444);
+BFCA(1445);
+BFCA(1446);
+BFCA(1447);
+BFCA(1448);
+BFCA(1449);
+BFCA(1450);
+BFCA(1451);
+BFCA(1452);
+BFCA(1453);
+BFCA(1454);
+BFCA(1455);
+BFCA(1456);
+BFCA(1457);
+BFCA(1458);
+BFCA(1459);
+BFCA(1460);
+BFCA(1461);
+BFCA(1462);
+BFCA(1463);
+BFCA(1464);
+BFCA(1465);
+BFCA(1466);
+BFCA(1467);
+BFCA(1468);
+BFCA(1469);
+BFCA(1470);
+BFCA(1471);
+BFCA(1472);
+BFCA(1473);
+BFCA(1474);
+BFCA(1475);
+BFCA(1476);
+BFCA(1477);
+BFCA(1478);
+BFCA(1479);
+BFCA(1480);
+BFCA(1481);
+BFCA(1482);
+BFCA(1483);
+BFCA(1484);
+BFCA(1485);
+BFCA(1486);
+BFCA(1487);
+BFCA(1488);
+BFCA(1489);
+BFCA(1490);
+BFCA(1491);
+BFCA(1492);
+BFCA(1493);
+BFCA(1494);
+BFCA(1495);
+BFCA(1496);
+BFCA(1497);
+BFCA(1498);
+BFCA(1499);
+BFCA(1500);
+BFCA(1501);
+BFCA(1502);
+BFCA(1503);
+BFCA(1504);
+BFCA(1505);
+BFCA(1506);
+BFCA(1507);
+BFCA(1508);
+BFCA(1509);
+BFCA(1510);
+BFCA(1511);
+BFCA(1512);
+BFCA(1513);
+BFCA(1514);
+BFCA(1515);
+BFCA(1516);
+BFCA(1517);
+BFCA(1518);
+BFCA(1519);
+BFCA(1520);
+BFCA(1521);
+BFCA(1522);
+BFCA(1523);
+BFCA(1524);
+BFCA(1525);
+BFCA(1526);
+BFCA(1527);
+BFCA(1528);
+BFCA(1529);
+BFCA(1530);
+BFCA(1531);
+BFCA(1532);
+BFCA(1533);
+BFCA(1534);
+BFCA(1535);
+BFCA(1536);
+BFCA(1537);
+BFCA(1538);
+BFCA(1539);
+BFCA(1540);
+BFCA(1541);
+BFCA(1542);
+BFCA(1543);
+BFCA(1544);
+BFCA(1545);
+BFCA(1546);
+BFCA(1547);
+BFCA(1548);
+BFCA(1549);
+BFCA(1550);
+BFCA(1551);
+BFCA(1552);
+BFCA(1553);
+BFCA(1554);
+BFCA(1555);
+BFCA(1556);
+BFCA(1557);
+BFCA(1558);
+BFCA(1559);
+BFCA(1560);
+BFCA(1561);
+BFCA(1562);
+BFCA(1563);
+BFCA(1564);
+BFCA(1565);
+BFCA(1566);
+BFCA(1567);
+BFCA(1568);
+BFCA(1569);
+BFCA(1570);
+BFCA(1571);
+BFCA(1572);
+BFCA(1573);
+BFCA(1574);
+BFCA(1575);
+BFCA(1576);
+BFCA(1577);
+BFCA(1578);
+BFCA(1579);
+BFCA(1580);
+BFCA(1581);
+BFCA(1582);
+BFCA(1583);
+BFCA(1584);
+BFCA(1585);
+BFCA(1586);
+BFCA(1587);
+BFCA(1588);
+BFCA(1589);
+BFCA(1590);
+BFCA(1591);
+BFCA(1592);
+BFCA(1593);
+BFCA(1594);
+BFCA(1595);
+BFCA(1596);
+BFCA(1597);
+BFCA(1598);
+BFCA(1599);
+BFCA(1600);
+BFCA(1601);
+BFCA(1602);
+BFCA(1603);
+BFCA(1604);
+BFCA(1605);
+BFCA(1606);
+BFCA(1607);
+BFCA(1608);
+BFCA(1609);
+BFCA(1610);
+BFCA(1611);
+BFCA(1612);
+BFCA(1613);
+BFCA(1614);
+BFCA(1615);
+BFCA(1616);
+BFCA(1617);
+BFCA(1618);
+BFCA(1619);
+BFCA(1620);
+BFCA(1621);
+BFCA(1622);
+BFCA(1623);
+BFCA(1624);
+BFCA(1625);
+BFCA(1626);
+BFCA(1627);
+BFCA(1628);
+BFCA(1629);
+BFCA(1630);
+BFCA(1631);
+BFCA(1632);
+BFCA(1633);
+BFCA(1634);
+BFCA(1635);
+BFCA(1636);
+BFCA(1637);
+BFCA(1638);
+BFCA(1639);
+BFCA(1640);
+BFCA(1641);
+BFCA(1642);
+BFCA(1643);
+BFCA(1644);
+BFCA(1645);
+BFCA(1646);
+BFCA(1647);
+BFCA(1648);
+BFCA(1649);
+BFCA(1650);
+BFCA(1651);
+BFCA(1652);
+BFCA(1653);
+BFCA(1654);
+BFCA(1655);
+BFCA(1656);
+BFCA(1657);
+BFCA(1658);
+BFCA(1659);
+BFCA(1660);
+BFCA(1661);
+BFCA(1662);
+BFCA(1663);
+BFCA(1664);
+BFCA(1665);
+BFCA(1666);
+BFCA(1667);
+BFCA(1668);
+BFCA(1669);
+BFCA(1670);
+BFCA(1671);
+BFCA(1672);
+BFCA(1673);
+BFCA(1674);
+BFCA(1675);
+BFCA(1676);
+BFCA(1677);
+BFCA(1678);
+BFCA(1679);
+BFCA(1680);
+BFCA(1681);
+BFCA(1682);
+BFCA(1683);
+BFCA(1684);
+BFCA(1685);
+BFCA(1686);
+BFCA(1687);
+BFCA(1688);
+BFCA(1689);
+BFCA(1690);
+BFCA(1691);
+BFCA(1692);
+BFCA(1693);
+BFCA(1694);
+BFCA(1695);
+BFCA(1696);
+BFCA(1697);
+BFCA(1698);
+BFCA(1699);
+BFCA(1700);
+BFCA(1701);
+BFCA(1702);
+BFCA(1703);
+BFCA(1704);
+BFCA(1705);
+BFCA(1706);
+BFCA(1707);
+BFCA(1708);
+BFCA(1709);
+BFCA(1710);
+BFCA(1711);
+BFCA(1712);
+BFCA(1713);
+BFCA(1714);
+BFCA(1715);
+BFCA(1716);
+BFCA(1717);
+BFCA(1718);
+BFCA(1719);
+BFCA(1720);
+BFCA(1721);
+BFCA(1722);
+BFCA(1723);
+BFCA(1724);
+BFCA(1725);
+BFCA(1726);
+BFCA(1727);
+BFCA(1728);
+BFCA(1729);
+BFCA(1730);
+BFCA(1731);
+BFCA(1732);
+BFCA(1733);
+BFCA(1734);
+BFCA(1735);
+BFCA(1736);
+BFCA(1737);
+BFCA(1738);
+BFCA(1739);
+BFCA(1740);
+BFCA(1741);
+BFCA(1742);
+BFCA(1743);
+BFCA(1744);
+BFCA(1745);
+BFCA(1746);
+BFCA(1747);
+BFCA(1748);
+BFCA(1749);
+BFCA(1750);
+BFCA(1751);
+BFCA(1752);
+BFCA(1753);
+BFCA(1754);
+BFCA(1755);
+BFCA(1756);
+BFCA(1757);
+BFCA(1758);
+BFCA(1759);
+BFCA(1760);
+BFCA(1761);
+BFCA(1762);
+BFCA(1763);
+BFCA(1764);
+BFCA(1765);
+BFCA(1766);
+BFCA(1767);
+BFCA(1768);
+BFCA(1769);
+BFCA(1770);
+BFCA(1771);
+BFCA(1772);
+BFCA(1773);
+BFCA(1774);
+BFCA(1775);
+BFCA(1776);
+BFCA(1777);
+BFCA(1778);
+BFCA(1779);
+BFCA(1780);
+BFCA(1781);
+BFCA(1782);
+BFCA(1783);
+BFCA(1784);
+BFCA(1785);
+BFCA(1786);
+BFCA(1787);
+BFCA(1788);
+BFCA(1789);
+BFCA(1790);
+BFCA(1791);
+BFCA(1792);
+BFCA(1793);
+BFCA(1794);
+BFCA(1795);
+BFCA(1796);
+BFCA(1797);
+BFCA(1798);
+BFCA(1799);
+BFCA(1800);
+BFCA(1801);
+BFCA(1802);
+BFCA(1803);
+BFCA(1804);
+BFCA(1805);
+BFCA(1806);
+BFCA(1807);
+BFCA(1808);
+BFCA(1809);
+BFCA(1810);
+BFCA(1811);
+BFCA(1812);
+BFCA(1813);
+BFCA(1814);
+BFCA(1815);
+BFCA(1816);
+BFCA(1817);
+BFCA(1818);
+BFCA(1819);
+BFCA(1820);
+BFCA(1821);
+BFCA(1822);
+BFCA(1823);
+BFCA(1824);
+BFCA(1825);
+BFCA(1826);
+BFCA(1827);
+BFCA(1828);
+BFCA(1829);
+BFCA(1830);
+BFCA(1831);
+BFCA(1832);
+BFCA(1833);
+BFCA(1834);
+BFCA(1835);
+BFCA(1836);
+BFCA(1837);
+BFCA(1838);
+BFCA(1839);
+BFCA(1840);
+BFCA(1841);
+BFCA(1842);
+BFCA(1843);
+BFCA(1844);
+BFCA(1845);
+BFCA(1846);
+BFCA(1847);
+BFCA(1848);
+BFCA(1849);
+BFCA(1850);
+BFCA(1851);
+BFCA(1852);
+BFCA(1853);
+BFCA(1854);
+BFCA(1855);
+BFCA(1856);
+BFCA(1857);
+BFCA(1858);
+BFCA(1859);
+BFCA(1860);
+BFCA(1861);
+BFCA(1862);
+BFCA(1863);
+BFCA(1864);
+BFCA(1865);
+BFCA(1866);
+BFCA(1867);
+BFCA(1868);
+BFCA(1869);
+BFCA(1870);
+BFCA(1871);
+BFCA(1872);
+BFCA(1873);
+BFCA(1874);
+BFCA(1875);
+BFCA(1876);
+BFCA(1877);
+BFCA(1878);
+BFCA(1879);
+BFCA(1880);
+BFCA(1881);
+BFCA(1882);
+BFCA(1883);
+BFCA(1884);
+BFCA(1885);
+BFCA(1886);
+BFCA(1887);
+BFCA(1888);
+BFCA(1889);
+BFCA(1890);
+BFCA(1891);
+BFCA(1892);
+BFCA(1893);
+BFCA(1894);
+BFCA(1895);
+BFCA(1896);
+BFCA(1897);
+BFCA(1898);
+BFCA(1899);
+BFCA(1900);
+BFCA(1901);
+BFCA(1902);
+BFCA(1903);
+BFCA(1904);
+BFCA(1905);
+BFCA(1906);
+BFCA(1907);
+BFCA(1908);
+BFCA(1909);
+BFCA(1910);
+BFCA(1911);
+BFCA(1912);
+BFCA(1913);
+BFCA(1914);
+BFCA(1915);
+BFCA(1916);
+BFCA(1917);
+BFCA(1918);
+BFCA(1919);
+BFCA(1920);
+BFCA(1921);
+BFCA(1922);
+BFCA(1923);
+BFCA(1924);
+BFCA(1925);
+BFCA(1926);
+BFCA(1927);
+BFCA(1928);
+BFCA(1929);
+BFCA(1930);
+BFCA(1931);
+BFCA(1932);
+BFCA(1933);
+BFCA(1934);
+BFCA(1935);
+BFCA(1936);
+BFCA(1937);
+BFCA(1938);
+BFCA(1939);
+BFCA(1940);
+BFCA(1941);
+BFCA(1942);
+BFCA(1943);
+BFCA(1944);
+BFCA(1945);
+BFCA(1946);
+BFCA(1947);
+BFCA(1948);
+BFCA(1949);
+BFCA(1950);
+BFCA(1951);
+BFCA(1952);
+BFCA(1953);
+BFCA(1954);
+BFCA(1955);
+BFCA(1956);
+BFCA(1957);
+BFCA(1958);
+BFCA(1959);
+BFCA(1960);
+BFCA(1961);
+BFCA(1962);
+BFCA(1963);
+BFCA(1964);
+BFCA(1965);
+BFCA(1966);
+BFCA(1967);
+BFCA(1968);
+BFCA(1969);
+BFCA(1970);
+BFCA(1971);
+BFCA(1972);
+BFCA(1973);
+BFCA(1974);
+BFCA(1975);
+BFCA(1976);
+BFCA(1977);
+BFCA(1978);
+BFCA(1979);
+BFCA(1980);
+BFCA(1981);
+BFCA(1982);
+BFCA(1983);
+BFCA(1984);
+BFCA(1985);
+BFCA(1986);
+BFCA(1987);
+BFCA(1988);
+BFCA(1989);
+BFCA(1990);
+BFCA(1991);
+BFCA(1992);
+BFCA(1993);
+BFCA(1994);
+BFCA(1995);
+BFCA(1996);
+BFCA(1997);
+BFCA(1998);
+BFCA(1999);
+BFCA(2000);
+BFCA(2001);
+BFCA(2002);
+BFCA(2003);
+BFCA(2004);
+BFCA(2005);
+BFCA(2006);
+BFCA(2007);
+BFCA(2008);
+BFCA(2009);
+BFCA(2010);
+BFCA(2011);
+BFCA(2012);
+BFCA(2013);
+BFCA(2014);
+BFCA(2015);
+BFCA(2016);
+BFCA(2017);
+BFCA(2018);
+BFCA(2019);
+BFCA(2020);
+BFCA(2021);
+BFCA(2022);
+BFCA(2023);
+BFCA(2024);
+BFCA(2025);
+BFCA(2026);
+BFCA(2027);
+BFCA(2028);
+BFCA(2029);
+BFCA(2030);
+BFCA(2031);
+BFCA(2032);
+BFCA(2033);
+BFCA(2034);
+BFCA(2035);
+BFCA(2036);
+BFCA(2037);
+BFCA(2038);
+BFCA(2039);
+BFCA(2040);
+BFCA(2041);
+BFCA(2042);
+BFCA(2043);
+BFCA(2044);
+BFCA(2045);
+BFCA(2046);
+BFCA(2047);
+BFCA(2048);
+BFCA(2049);
+BFCA(2050);
+BFCA(2051);
+BFCA(2052);
+BFCA(2053);
+BFCA(2054);
+BFCA(2055);
+BFCA(2056);
+BFCA(2057);
+BFCA(2058);
+BFCA(2059);
+BFCA(2060);
+BFCA(2061);
+BFCA(2062);
+BFCA(2063);
+BFCA(2064);
+BFCA(2065);
+BFCA(2066);
+BFCA(2067);
+BFCA(2068);
+BFCA(2069);
+BFCA(2070);
+BFCA(2071);
+BFCA(2072);
+BFCA(2073);
+BFCA(2074);
+BFCA(2075);
+BFCA(2076);
+BFCA(2077);
+BFCA(2078);
+BFCA(2079);
+BFCA(2080);
+BFCA(2081);
+BFCA(2082);
+BFCA(2083);
+BFCA(2084);
+BFCA(2085);
+BFCA(2086);
+BFCA(2087);
+BFCA(2088);
+BFCA(2089);
+BFCA(2090);
+BFCA(2091);
+BFCA(2092);
+BFCA(2093);
+BFCA(2094);
+BFCA(2095);
+BFCA(2096);
+BFCA(2097);
+BFCA(2098);
+BFCA(2099);
+BFCA(2100);
+BFCA(2101);
+BFCA(2102);
+BFCA(2103);
+BFCA(2104);
+BFCA(2105);
+BFCA(2106);
+BFCA(2107);
+BFCA(2108);
+BFCA(2109);
+BFCA(2110);
+BFCA(2111);
+BFCA(2112);
+BFCA(2113);
+BFCA(2114);
+BFCA(2115);
+BFCA(2116);
+BFCA(2117);
+BFCA(2118);
+BFCA(2119);
+BFCA(2120);
+BFCA(2121);
+BFCA(2122);
+BFCA(2123);
+BFCA(2124);
+BFCA(2125);
+BFCA(2126);
+BFCA(2127);
+BFCA(2128);
+BFCA(2129);
+BFCA(2130);
+BFCA(2131);
+BFCA(2132);
+BFCA(2133);
+BFCA(2134);
+BFCA(2135);
+BFCA(2136);
+BFCA(2137);
+BFCA(2138);
+BFCA(2139);
+BFCA(2140);
+BFCA(2141);
+BFCA(2142);
+BFCA(2143);
+BFCA(2144);
+BFCA(2145);
+BFCA(2146);
+BFCA(2147);
+BFCA(2148);
+BFCA(2149);
+BFCA(2150);
+BFCA(2151);
+BFCA(2152);
+BFCA(2153);
+BFCA(2154);
+BFCA(2155);
+BFCA(2156);
+BFCA(2157);
+BFCA(2158);
+BFCA(2159);
+BFCA(2160);
+BFCA(2161);
+BFCA(2162);
+BFCA(2163);
+BFCA(2164);
+BFCA(2165);
+BFCA(2166);
+BFCA(2167);
+BFCA(2168);
+BFCA(2169);
+BFCA(2170);
+BFCA(2171);
+BFCA(2172);
+BFCA(2173);
+BFCA(2174);
+BFCA(2175);
+BFCA(2176);
+BFCA(2177);
+BFCA(2178);
+BFCA(2179);
+BFCA(2180);
+BFCA(2181);
+BFCA(2182);
+BFCA(2183);
+BFCA(2184);
+BFCA(2185);
+BFCA(2186);
+BFCA(2187);
+BFCA(2188);
+BFCA(2189);
+BFCA(2190);
+BFCA(2191);
+BFCA(2192);
+BFCA(2193);
+BFCA(2194);
+BFCA(2195);
+BFCA(2196);
+BFCA(2197);
+BFCA(2198);
+BFCA(2199);
+BFCA(2200);
+BFCA(2201);
+BFCA(2202);
+BFCA(2203);
+BFCA(2204);
+BFCA(2205);
+BFCA(2206);
+BFCA(2207);
+BFCA(2208);
+BFCA(2209);
+BFCA(2210);
+BFCA(2211);
+BFCA(2212);
+BFCA(2213);
+BFCA(2214);
+BFCA(2215);
+BFCA(2216);
+BFCA(2217);
+BFCA(2218);
+BFCA(2219);
+BFCA(2220);
+BFCA(2221);
+BFCA(2222);
+BFCA(2223);
+BFCA(2224);
+BFCA(2225);
+BFCA(2226);
+BFCA(2227);
+BFCA(2228);
+BFCA(2229);
+BFCA(2230);
+BFCA(2231);
+BFCA(2232);
+BFCA(2233);
+BFCA(2234);
+BFCA(2235);
+BFCA(2236);
+BFCA(2237);
+BFCA(2238);
+BFCA(2239);
+BFCA(2240);
+BFCA(2241);
+BFCA(2242);
+BFCA(2243);
+BFCA(2244);
+BFCA(2245);
+BFCA(2246);
+BFCA(2247);
+BFCA(2248);
+BFCA(2249);
+BFCA(2250);
+BFCA(2251);
+BFCA(2252);
+BFCA(2253);
+BFCA(2254);
+BFCA(2255);
+BFCA(2256);
+BFCA(2257);
+BFCA(2258);
+BFCA(2259);
+BFCA(2260);
+BFCA(2261);
+BFCA(2262);
+BFCA(2263);
+BFCA(2264);
+BFCA(2265);
+BFCA(2266);
+BFCA(2267);
+BFCA(2268);
+BFCA(2269);
+BFCA(2270);
+BFCA(2271);
+BFCA(2272);
+BFCA(2273);
+BFCA(2274);
+BFCA(2275);
+BFCA(2276);
+BFCA(2277);
+BFCA(2278);
+BFCA(2279);
+BFCA(2280);
+BFCA(2281);
+BFCA(2282);
+BFCA(2283);
+BFCA(2284);
+BFCA(2285);
+BFCA(2286);
+BFCA(2287);
+BFCA(2288);
+BFCA(2289);
+BFCA(2290);
+BFCA(2291);
+BFCA(2292);
+BFCA(2293);
+BFCA(2294);
+BFCA(2295);
+BFCA(2296);
+BFCA(2297);
+BFCA(2298);
+BFCA(2299);
+BFCA(2300);
+BFCA(2301);
+BFCA(2302);
+BFCA(2303);
+BFCA(2304);
+BFCA(2305);
+BFCA(2306);
+BFCA(2307);
+BFCA(2308);
+BFCA(2309);
+BFCA(2310);
+BFCA(2311);
+BFCA(2312);
+BFCA(2313);
+BFCA(2314);
+BFCA(2315);
+BFCA(2316);
+BFCA(2317);
+BFCA(2318);
+BFCA(2319);
+BFCA(2320);
+BFCA(2321);
+BFCA(2322);
+BFCA(2323);
+BFCA(2324);
+BFCA(2325);
+BFCA(2326);
+BFCA(2327);
+BFCA(2328);
+BFCA(2329);
+BFCA(2330);
+BFCA(2331);
+BFCA(2332);
+BFCA(2333);
+BFCA(2334);
+BFCA(2335);
+BFCA(2336);
+BFCA(2337);
+BFCA(2338);
+BFCA(2339);
+BFCA(2340);
+BFCA(2341);
+BFCA(2342);
+BFCA(2343);
+BFCA(2344);
+BFCA(2345);
+BFCA(2346);
+BFCA(2347);
+BFCA(2348);
+BFCA(2349);
+BFCA(2350);
+BFCA(2351);
+BFCA(2352);
+BFCA(2353);
+BFCA(2354);
+BFCA(2355);
+BFCA(2356);
+BFCA(2357);
+BFCA(2358);
+BFCA(2359);
+BFCA(2360);
+BFCA(2361);
+BFCA(2362);
+BFCA(2363);
+BFCA(2364);
+BFCA(2365);
+BFCA(2366);
+BFCA(2367);
+BFCA(2368);
+BFCA(2369);
+BFCA(2370);
+BFCA(2371);
+BFCA(2372);
+BFCA(2373);
+BFCA(2374);
+BFCA(2375);
+BFCA(2376);
+BFCA(2377);
+BFCA(2378);
+BFCA(2379);
+BFCA(2380);
+BFCA(2381);
+BFCA(2382);
+BFCA(2383);
+BFCA(2384);
+BFCA(2385);
+BFCA(2386);
+BFCA(2387);
+BFCA(2388);
+BFCA(2389);
+BFCA(2390);
+BFCA(2391);
+BFCA(2392);
+BFCA(2393);
+BFCA(2394);
+BFCA(2395);
+BFCA(2396);
+BFCA(2397);
+BFCA(2398);
+BFCA(2399);
+BFCA(2400);
+BFCA(2401);
+BFCA(2402);
+BFCA(2403);
+BFCA(2404);
+BFCA(2405);
+BFCA(2406);
+BFCA(2407);
+BFCA(2408);
+BFCA(2409);
+BFCA(2410);
+BFCA(2411);
+BFCA(2412);
+BFCA(2413);
+BFCA(2414);
+BFCA(2415);
+BFCA(2416);
+BFCA(2417);
+BFCA(2418);
+BFCA(2419);
+BFCA(2420);
+BFCA(2421);
+BFCA(2422);
+BFCA(2423);
+BFCA(2424);
+BFCA(2425);
+BFCA(2426);
+BFCA(2427);
+BFCA(2428);
+BFCA(2429);
+BFCA(2430);
+BFCA(2431);
+BFCA(2432);
+BFCA(2433);
+BFCA(2434);
+BFCA(2435);
+BFCA(2436);
+BFCA(2437);
+BFCA(2438);
+BFCA(2439);
+BFCA(2440);
+BFCA(2441);
+BFCA(2442);
+BFCA(2443);
+BFCA(2444);
+BFCA(2445);
+BFCA(2446);
+BFCA(2447);
+BFCA(2448);
+BFCA(2449);
+BFCA(2450);
+BFCA(2451);
+BFCA(2452);
+BFCA(2453);
+BFCA(2454);
+BFCA(2455);
+BFCA(2456);
+BFCA(2457);
+BFCA(2458);
+BFCA(2459);
+BFCA(2460);
+BFCA(2461);
+BFCA(2462);
+BFCA(2463);
+BFCA(2464);
+BFCA(2465);
+BFCA(2466);
+BFCA(2467);
+BFCA(2468);
+BFCA(2469);
+BFCA(2470);
+BFCA(2471);
+BFCA(2472);
+BFCA(2473);
+BFCA(2474);
+BFCA(2475);
+BFCA(2476);
+BFCA(2477);
+BFCA(2478);
+BFCA(2479);
+BFCA(2480);
+BFCA(2481);
+BFCA(2482);
+BFCA(2483);
+BFCA(2484);
+BFCA(2485);
+BFCA(2486);
+BFCA(2487);
+BFCA(2488);
+BFCA(2489);
+BFCA(2490);
+BFCA(2491);
+BFCA(2492);
+BFCA(2493);
+BFCA(2494);
+BFCA(2495);
+BFCA(2496);
+BFCA(2497);
+BFCA(2498);
+BFCA(2499);
+BFCA(2500);
+BFCA(2501);
+BFCA(2502);
+BFCA(2503);
+BFCA(2504);
+BFCA(2505);
+BFCA(2506);
+BFCA(2507);
+BFCA(2508);
+BFCA(2509);
+BFCA(2510);
+BFCA(2511);
+BFCA(2512);
+BFCA(2513);
+BFCA(2514);
+BFCA(2515);
+BFCA(2516);
+BFCA(2517);
+BFCA(2518);
+BFCA(2519);
+BFCA(2520);
+BFCA(2521);
+BFCA(2522);
+BFCA(2523);
+BFCA(2524);
+BFCA(2525);
+BFCA(2526);
+BFCA(2527);
+BFCA(2528);
+BFCA(2529);
+BFCA(2530);
+BFCA(2531);
+BFCA(2532);
+BFCA(2533);
+BFCA(2534);
+BFCA(2535);
+BFCA(2536);
+BFCA(2537);
+BFCA(2538);
+BFCA(2539);
+BFCA(2540);
+BFCA(2541);
+BFCA(2542);
+BFCA(2543);
+BFCA(2544);
+BFCA(2545);
+BFCA(2546);
+BFCA(2547);
+BFCA(2548);
+BFCA(2549);
+BFCA(2550);
+BFCA(2551);
+BFCA(2552);
+BFCA(2553);
+BFCA(2554);
+BFCA(2555);
+BFCA(2556);
+BFCA(2557);
+BFCA(2558);
+BFCA(2559);
+BFCA(2560);
+BFCA(2561);
+BFCA(2562);
+BFCA(2563);
+BFCA(2564);
+BFCA(2565);
+BFCA(2566);
+BFCA(2567);
+BFCA(2568);
+BFCA(2569);
+BFCA(2570);
+BFCA(2571);
+BFCA(2572);
+BFCA(2573);
+BFCA(2574);
+BFCA(2575);
+BFCA(2576);
+BFCA(2577);
+BFCA(2578);
+BFCA(2579);
+BFCA(2580);
+BFCA(2581);
+BFCA(2582);
+BFCA(2583);
+BFCA(2584);
+BFCA(2585);
+BFCA(2586);
+BFCA(2587);
+BFCA(2588);
+BFCA(2589);
+BFCA(2590);
+BFCA(2591);
+BFCA(2592);
+BFCA(2593);
+BFCA(2594);
+BFCA(2595);
+BFCA(2596);
+BFCA(2597);
+BFCA(2598);
+BFCA(2599);
+BFCA(2600);
+BFCA(2601);
+BFCA(2602);
+BFCA(2603);
+BFCA(2604);
+BFCA(2605);
+BFCA(2606);
+BFCA(2607);
+BFCA(2608);
+BFCA(2609);
+BFCA(2610);
+BFCA(2611);
+BFCA(2612);
+BFCA(2613);
+BFCA(2614);
+BFCA(2615);
+BFCA(2616);
+BFCA(2617);
+BFCA(2618);
+BFCA(2619);
+BFCA(2620);
+BFCA(2621);
+BFCA(2622);
+BFCA(2623);
+BFCA(2624);
+BFCA(2625);
+BFCA(2626);
+BFCA(2627);
+BFCA(2628);
+BFCA(2629);
+BFCA(2630);
+BFCA(2631);
+BFCA(2632);
+BFCA(2633);
+BFCA(2634);
+BFCA(2635);
+BFCA(2636);
+BFCA(2637);
+BFCA(2638);
+BFCA(2639);
+BFCA(2640);
+BFCA(2641);
+BFCA(2642);
+BFCA(2643);
+BFCA(2644);
+BFCA(2645);
+BFCA(2646);
+BFCA(2647);
+BFCA(2648);
+BFCA(2649);
+BFCA(2650);
+BFCA(2651);
+BFCA(2652);
+BFCA(2653);
+BFCA(2654);
+BFCA(2655);
+BFCA(2656);
+BFCA(2657);
+BFCA(2658);
+BFCA(2659);
+BFCA(2660);
+BFCA(2661);
+BFCA(2662);
+BFCA(2663);
+BFCA(2664);
+BFCA(2665);
+BFCA(2666);
+BFCA(2667);
+BFCA(2668);
+BFCA(2669);
+BFCA(2670);
+BFCA(2671);
+BFCA(2672);
+BFCA(2673);
+BFCA(2674);
+BFCA(2675);
+BFCA(2676);
+BFCA(2677);
+BFCA(2678);
+BFCA(2679);
+BFCA(2680);
+BFCA(2681);
+BFCA(2682);
+BFCA(2683);
+BFCA(2684);
+BFCA(2685);
+BFCA(2686);
+BFCA(2687);
+BFCA(2688);
+BFCA(2689);
+BFCA(2690);
+BFCA(2691);
+BFCA(2692);
+BFCA(2693);
+BFCA(2694);
+BFCA(2695);
+BFCA(2696);
+BFCA(2697);
+BFCA(2698);
+BFCA(2699);
+BFCA(2700);
+BFCA(2701);
+BFCA(2702);
+BFCA(2703);
+BFCA(2704);
+BFCA(2705);
+BFCA(2706);
+BFCA(2707);
+BFCA(2708);
+BFCA(2709);
+BFCA(2710);
+BFCA(2711);
+BFCA(2712);
+BFCA(2713);
+BFCA(2714);
+BFCA(2715);
+BFCA(2716);
+BFCA(2717);
+BFCA(2718);
+BFCA(2719);
+BFCA(2720);
+BFCA(2721);
+BFCA(2722);
+BFCA(2723);
+BFCA(2724);
+BFCA(2725);
+BFCA(2726);
+BFCA(2727);
+BFCA(2728);
+BFCA(2729);
+BFCA(2730);
+BFCA(2731);
+BFCA(2732);
+BFCA(2733);
+BFCA(2734);
+BFCA(2735);
+BFCA(2736);
+BFCA(2737);
+BFCA(2738);
+BFCA(2739);
+BFCA(2740);
+BFCA(2741);
+BFCA(2742);
+BFCA(2743);
+BFCA(2744);
+BFCA(2745);
+BFCA(2746);
+BFCA(2747);
+BFCA(2748);
+BFCA(2749);
+BFCA(2750);
+BFCA(2751);
+BFCA(2752);
+BFCA(2753);
+BFCA(2754);
+BFCA(2755);
+BFCA(2756);
+BFCA(2757);
+BFCA(2758);
+BFCA(2759);
+BFCA(2760);
+BFCA(2761);
+BFCA(2762);
+BFCA(2763);
+BFCA(2764);
+BFCA(2765);
+BFCA(2766);
+BFCA(2767);
+BFCA(2768);
+BFCA(2769);
+BFCA(2770);
+BFCA(2771);
+BFCA(2772);
+BFCA(2773);
+BFCA(2774);
+BFCA(2775);
+BFCA(2776);
+BFCA(2777);
+BFCA(2778);
+BFCA(2779);
+BFCA(2780);
+BFCA(2781);
+BFCA(2782);
+BFCA(2783);
+BFCA(2784);
+BFCA(2785);
+BFCA(2786);
+BFCA(2787);
+BFCA(2788);
+BFCA(2789);
+BFCA(2790);
+BFCA(2791);
+BFCA(2792);
+BFCA(2793);
+BFCA(2794);
+BFCA(2795);
+BFCA(2796);
+BFCA(2797);
+BFCA(2798);
+BFCA(2799);
+BFCA(2800);
+BFCA(2801);
+BFCA(2802);
+BFCA(2803);
+BFCA(2804);
+BFCA(2805);
+BFCA(2806);
+BFCA(2807);
+BFCA(2808);
+BFCA(2809);
+BFCA(2810);
+BFCA(2811);
+BFCA(2812);
+BFCA(2813);
+BFCA(2814);
+BFCA(2815);
+BFCA(2816);
+BFCA(2817);
+BFCA(2818);
+BFCA(2819);
+BFCA(2820);
+BFCA(2821);
+BFCA(2822);
+BFCA(2823);
+BFCA(2824);
+BFCA(2825);
+BFCA(2826);
+BFCA(2827);
+BFCA(2828);
+BFCA(2829);
+BFCA(2830);
+BFCA(2831);
+BFCA(2832);
+BFCA(2833);
+BFCA(2834);
+BFCA(2835);
+BFCA(2836);
+BFCA(2837);
+BFCA(2838);
+BFCA(2839);
+BFCA(2840);
+BFCA(2841);
+BFCA(2842);
+BFCA(2843);
+BFCA(2844);
+BFCA(2845);
+BFCA(2846);
+BFCA(2847);
+BFCA(2848);
+BFCA(2849);
+BFCA(2850);
+BFCA(2851);
+BFCA(2852);
+BFCA(2853);
+BFCA(2854);
+BFCA(2855);
+BFCA(2856);
+BFCA(2857);
+BFCA(2858);
+BFCA(2859);
+BFCA(2860);
+BFCA(2861);
+BFCA(2862);
+BFCA(2863);
+BFCA(2864);
+BFCA(2865);
+BFCA(2866);
+BFCA(2867);
+BFCA(2868);
+BFCA(2869);
+BFCA(2870);
+BFCA(2871);
+BFCA(2872);
+BFCA(2873);
+BFCA(2874);
+BFCA(2875);
+BFCA(2876);
+BFCA(2877);
+BFCA(2878);
+BFCA(2879);
+BFCA(2880);
+BFCA(2881);
+BFCA(2882);
+BFCA(2883);
+BFCA(2884);
+BFCA(2885);
+BFCA(2886);
+BFCA(2887);
+BFCA(2888);
+BFCA(2889);
+BFCA(2890);
+BFCA(2891);
+BFCA(2892);
+BFCA(2893);
+BFCA(2894);
+BFCA(2895);
+BFCA(2896);
+BFCA(2897);
+BFCA(2898);
+BFCA(2899);
+BFCA(2900);
+BFCA(2901);
+BFCA(2902);
+BFCA(2903);
+BFCA(2904);
+BFCA(2905);
+BFCA(2906);
+BFCA(2907);
+BFCA(2908);
+BFCA(2909);
+BFCA(2910);
+BFCA(2911);
+BFCA(2912);
+BFCA(2913);
+BFCA(2914);
+BFCA(2915);
+BFCA(2916);
+BFCA(2917);
+BFCA(2918);
+BFCA(2919);
+BFCA(2920);
+BFCA(2921);
+BFCA(2922);
+BFCA(2923);
+BFCA(2924);
+BFCA(2925);
+BFCA(2926);
+BFCA(2927);
+BFCA(2928);
+BFCA(2929);
+BFCA(2930);
+BFCA(2931);
+BFCA(2932);
+BFCA(2933);
+BFCA(2934);
+BFCA(2935);
+BFCA(2936);
+BFCA(2937);
+BFCA(2938);
+BFCA(2939);
+BFCA(2940);
+BFCA(2941);
+BFCA(2942);
+BFCA(2943);
+BFCA(2944);
+BFCA(2945);
+BFCA(2946);
+BFCA(2947);
+BFCA(2948);
+BFCA(2949);
+BFCA(2950);
+BFCA(2951);
+BFCA(2952);
+BFCA(2953);
+BFCA(2954);
+BFCA(2955);
+BFCA(2956);
+BFCA(2957);
+BFCA(2958);
+BFCA(2959);
+BFCA(2960);
+BFCA(2961);
+BFCA(2962);
+BFCA(2963);
+BFCA(2964);
+BFCA(2965);
+BFCA(2966);
+BFCA(2967);
+BFCA(2968);
+BFCA(2969);
+BFCA(2970);
+BFCA(2971);
+BFCA(2972);
+BFCA(2973);
+BFCA(2974);
+BFCA(2975);
+BFCA(2976);
+BFCA(2977);
+BFCA(2978);
+BFCA(2979);
+BFCA(2980);
+BFCA(2981);
+BFCA(2982);
+BFCA(2983);
+BFCA(2984);
+BFCA(2985);
+BFCA(2986);
+BFCA(2987);
+BFCA(2988);
+BFCA(2989);
+BFCA(2990);
+BFCA(2991);
+BFCA(2992);
+BFCA(2993);
+BFCA(2994);
+BFCA(2995);
+BFCA(2996);
+BFCA(2997);
+BFCA(2998);
+BFCA(2999);
+BFCA(3000);
+BFCA(3001);
+BFCA(3002);
+BFCA(3003);
+BFCA(3004);
+BFCA(3005);
+BFCA(3006);
+BFCA(3007);
+BFCA(3008);
+BFCA(3009);
+BFCA(3010);
+BFCA(3011);
+BFCA(3012);
+BFCA(3013);
+BFCA(3014);
+BFCA(3015);
+BFCA(3016);
+BFCA(3017);
+BFCA(3018);
+BFCA(3019);
+BFCA(3020);
+BFCA(3021);
+BFCA(3022);
+BFCA(3023);
+BFCA(3024);
+BFCA(3025);
+BFCA(3026);
+BFCA(3027);
+BFCA(3028);
+BFCA(3029);
+BFCA(3030);
+BFCA(3031);
+BFCA(3032);
+BFCA(3033);
+BFCA(3034);
+BFCA(3035);
+BFCA(3036);
+BFCA(3037);
+BFCA(3038);
+BFCA(3039);
+BFCA(3040);
+BFCA(3041);
+BFCA(3042);
+BFCA(3043);
+BFCA(3044);
+BFCA(3045);
+BFCA(3046);
+BFCA(3047);
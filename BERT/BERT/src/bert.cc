@@ -29,6 +29,7 @@
 #include "windows_api_functions.h"
 #include "module_functions.h"
 #include "message_utilities.h"
+#include "frame_reader.h"
 #include "..\resource.h"
 
 #include "excel_com_type_libraries.h"
@@ -90,25 +91,30 @@ void BERT::FileWatchUpdate(const std::vector<std::string> &files) {
 
   // any changes?
   if (updated) {
-
     DebugOut("Updating...\n");
+    RequestFunctionUpdate();
+  }
+}
 
-    // NOTE: this has to get on the correct thread. use COM to switch contexts
-    // (and use the marshaled pointer) 
-    // (and don't forget to release reference)
-
-    LPDISPATCH dispatch_pointer = 0;
-    HRESULT hresult = AtlUnmarshalPtr(stream_pointer_, IID_IDispatch, (LPUNKNOWN*)&dispatch_pointer);
-    if (SUCCEEDED(hresult) && dispatch_pointer) {
-      CComQIPtr<Excel::_Application> application(dispatch_pointer);
-      if (application) {
-        CComVariant variant_macro = "BERT.UpdateFunctions";
-        CComVariant variant_result = application->Run(variant_macro);
-      }
-      dispatch_pointer->Release();
-    }
+void BERT::RequestFunctionUpdate() {
+
+  // NOTE: this has to get on the correct thread. use COM to switch contexts
+  // (and use the marshaled pointer) 
+  // (and don't forget to release reference)
 
+  if (!stream_pointer_) return; // no pointer yet; functions are mapped at startup
+
+  LPDISPATCH dispatch_pointer = 0;
+  HRESULT hresult = AtlUnmarshalPtr(stream_pointer_, IID_IDispatch, (LPUNKNOWN*)&dispatch_pointer);
+  if (SUCCEEDED(hresult) && dispatch_pointer) {
+    CComQIPtr<Excel::_Application> application(dispatch_pointer);
+    if (application) {
+      CComVariant variant_macro = "BERT.UpdateFunctions";
+      CComVariant variant_result = application->Run(variant_macro);
+    }
+    dispatch_pointer->Release();
   }
+
 }
 
 int BERT::UpdateFunctions() {
@@ -136,7 +142,11 @@ BERT::BERT()
   , stream_pointer_(0)
   , ribbon_menu_dispatch_(0)
   , console_notification_handle_(0)
+  , console_pipe_handle_(0)
+  , console_pipe_reading_(false)
+  , console_pipe_connected_(false)
   , next_user_button_id_(1000)
+  , main_thread_id_(0)
 {
   APIFunctions::GetRegistryDWORD(dev_flags_, "BERT2.DevOptions");
   home_directory_ = ModuleFunctions::ModulePath();
@@ -286,50 +296,38 @@ void BERT::ShutdownConsole() {
 
 }
 
-unsigned __stdcall BERT::ConsoleThreadFunction(void *param) {
-  HRESULT hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
-  unsigned result = Instance()->InstanceConsoleThreadFunction();
-  CoUninitialize();
-  return result;
-}
-
-unsigned BERT::InstanceConsoleThreadFunction(){
+void BERT::OpenConsolePipe() {
 
   std::string pipe_name = "\\\\.\\pipe\\";
   pipe_name.append(console_pipe_name_);
 
   uint32_t buffer_size = 2048;
-  char *buffer = 0;
-
-  OVERLAPPED read_io, write_io;
   DWORD error = 0;
-  DWORD bytes_read, bytes_written;
-  DWORD result;
-
-  bool reading = false;
-  bool connected = false;
-
-  console_notification_handle_ = ::CreateEvent(0, TRUE, FALSE, 0);
 
-  HANDLE handle = CreateNamedPipeA(pipe_name.c_str(),
+  console_pipe_handle_ = CreateNamedPipeA(pipe_name.c_str(),
     PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
     PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
     4, buffer_size, buffer_size, 100, NULL);
 
-  if (NULL == handle || handle == INVALID_HANDLE_VALUE) {
+  if (NULL == console_pipe_handle_ || console_pipe_handle_ == INVALID_HANDLE_VALUE) {
     std::cerr << "create pipe failed" << std::endl;
-    return -1;
+    console_pipe_handle_ = 0;
+    return;
   }
 
-  memset(&read_io, 0, sizeof(read_io));
-  memset(&write_io, 0, sizeof(write_io));
+  console_pipe_reading_ = false;
+  console_pipe_connected_ = false;
+  console_reader_.Clear();
 
-  read_io.hEvent = CreateEvent(0, TRUE, FALSE, 0);
-  write_io.hEvent = CreateEvent(0, TRUE, FALSE, 0);
+  memset(&console_read_io_, 0, sizeof(console_read_io_));
+  memset(&console_write_io_, 0, sizeof(console_write_io_));
 
-  buffer = new char[buffer_size];
+  console_read_io_.hEvent = CreateEvent(0, TRUE, FALSE, 0);
+  console_write_io_.hEvent = CreateEvent(0, TRUE, FALSE, 0);
 
-  if (ConnectNamedPipe(handle, &read_io)) {
+  console_notification_handle_ = ::CreateEvent(0, TRUE, FALSE, 0);
+
+  if (ConnectNamedPipe(console_pipe_handle_, &console_read_io_)) {
     std::cerr << "ERR in connectNamedPipe" << std::endl;
     error = -1;
   }
@@ -337,7 +335,7 @@ unsigned BERT::InstanceConsoleThreadFunction(){
     error = GetLastError();
     switch (error) {
     case ERROR_PIPE_CONNECTED:
-      SetEvent(read_io.hEvent);
+      SetEvent(console_read_io_.hEvent);
       error = 0;
       break;
     case ERROR_IO_PENDING:
@@ -349,116 +347,149 @@ unsigned BERT::InstanceConsoleThreadFunction(){
     }
   }
 
-  std::vector < HANDLE > handles = { read_io.hEvent, console_notification_handle_ };
+  if (error) {
+    CloseConsolePipe();
+    return;
+  }
 
-  while (!error) {
+  if (!reactor_.Add(console_read_io_.hEvent, [this]() { ConsolePipeEvent(); })
+    || !reactor_.Add(console_notification_handle_, [this]() { ConsoleNotificationEvent(); })) {
+    CloseConsolePipe();
+  }
 
-    if (!reading && connected) {
-      ReadFile(handle, buffer, buffer_size, 0, &read_io);
-      reading = true;
-    }
+}
+
+void BERT::CloseConsolePipe() {
+
+  if (!console_pipe_handle_) return;
+
+  // send anything pending (the shutdown notification, on close)
+  if (console_pipe_connected_) ConsoleNotificationEvent();
+
+  reactor_.Remove(console_read_io_.hEvent);
+  reactor_.Remove(console_notification_handle_);
+
+  CancelIo(console_pipe_handle_);
+
+  CloseHandle(console_read_io_.hEvent);
+  CloseHandle(console_write_io_.hEvent);
+  CloseHandle(console_pipe_handle_);
+  CloseHandle(console_notification_handle_);
+
+  console_notification_handle_ = 0;
+  console_pipe_handle_ = 0;
+
+}
+
+void BERT::StartConsoleRead() {
+  if (!console_pipe_reading_ && console_pipe_connected_) {
+    ReadFile(console_pipe_handle_, console_reader_.read_pointer(), console_reader_.read_size(), 0, &console_read_io_);
+    console_pipe_reading_ = true;
+  }
+}
+
+void BERT::ConsoleNotificationEvent() {
+
+  DWORD bytes_written;
+
+  ::ResetEvent(console_notification_handle_);
+  while (console_notifications_.size()) {
+    std::string message = console_notifications_[0];
+    console_notifications_.erase(console_notifications_.begin());
+    WriteFile(console_pipe_handle_, message.c_str(), (DWORD)message.length(), &bytes_written, &console_write_io_);
+    //result = GetOverlappedResultEx(handle, &write_io, &bytes_written, INFINITE, FALSE);
+    GetOverlappedResult(console_pipe_handle_, &console_write_io_, &bytes_written, TRUE);
+  }
+
+}
+
+void BERT::ConsolePipeEvent() {
 
-    //result = WaitForSingleObject(read_io.hEvent, 1000);
-    result = WaitForMultipleObjects(2, &(handles[0]), FALSE, 1000);
-    if (result == WAIT_OBJECT_0 + 1) {
-      ::ResetEvent(handles[1]);
-      std::string message = console_notifications_[0];
-      console_notifications_.erase(console_notifications_.begin());
-      WriteFile(handle, message.c_str(), (DWORD)message.length(), &bytes_written, &write_io);
-      //result = GetOverlappedResultEx(handle, &write_io, &bytes_written, INFINITE, FALSE);
-      result = GetOverlappedResult(handle, &write_io, &bytes_written, TRUE);
+  DWORD bytes_read;
+  DWORD error = 0;
+
+  ResetEvent(console_read_io_.hEvent);
+  console_pipe_reading_ = false;
+  //result = GetOverlappedResultEx(handle, &read_io, &bytes_read, 0, FALSE);
+  DWORD result = GetOverlappedResult(console_pipe_handle_, &console_read_io_, &bytes_read, FALSE);
+  if (result) {
+    if (!console_pipe_connected_) {
+      std::cout << " * connected to mgmt pipe " << std::endl;
+      console_pipe_connected_ = true;
     }
-    else if (result == WAIT_OBJECT_0) {
-      ResetEvent(read_io.hEvent);
-      reading = false;
-      //result = GetOverlappedResultEx(handle, &read_io, &bytes_read, 0, FALSE);
-      result = GetOverlappedResult(handle, &read_io, &bytes_read, FALSE);
-      if (result) {
-        if (!connected) {
-          std::cout << " * connected to mgmt pipe " << std::endl;
-          connected = true;
-        }
-        else {
-          std::cout << " * read message mgmt pipe " << std::endl;
-          BERTBuffers::CallResponse call, reply;
-          MessageUtilities::Unframe(call, buffer, bytes_read);
-
-          reply.set_id(call.id());
-          auto result = reply.mutable_result();
-          bool success = false;
-
-          switch (call.operation_case()) {
-          case BERTBuffers::CallResponse::OperationCase::kFunctionCall:
-          {
-            const std::string &function = call.function_call().function();
-            // we should validate target
-            std::cout << "console: " << function << std::endl;
-            if (!function.compare("hide-console")) {
-
-              // can we do this on this thread? (...)
-              HideConsole();
-            }
-            break;
-          }
-          default:
-            std::cout << "Unexpected operation case: " << call.operation_case() << std::endl;
-            break;
-          }
-          
-          result->set_boolean(success);
-          std::string data = MessageUtilities::Frame(reply);
-
-          WriteFile(handle, data.c_str(), (DWORD)data.length(), NULL, &write_io);
+    else {
+      std::cout << " * read message mgmt pipe " << std::endl;
+      BERTBuffers::CallResponse call, reply;
+      console_reader_.Complete(bytes_read, false);
+      console_reader_.Parse(call);
+
+      reply.set_id(call.id());
+      auto result = reply.mutable_result();
+      bool success = false;
 
+      switch (call.operation_case()) {
+      case BERTBuffers::CallResponse::OperationCase::kFunctionCall:
+      {
+        const std::string &function = call.function_call().function();
+        // we should validate target
+        std::cout << "console: " << function << std::endl;
+        if (!function.compare("hide-console")) {
+
+          // can we do this on this thread? (...)
+          HideConsole();
         }
+        break;
       }
-      else {
-        error = GetLastError();
-        if (error == ERROR_BROKEN_PIPE) {
+      default:
+        std::cout << "Unexpected operation case: " << call.operation_case() << std::endl;
+        break;
+      }
+
+      result->set_boolean(success);
+      std::string data = MessageUtilities::Frame(reply);
 
-          // reset and wait for reconnect
+      WriteFile(console_pipe_handle_, data.c_str(), (DWORD)data.length(), NULL, &console_write_io_);
 
-          std::cout << " * broken pipe [2] " << std::endl;
+    }
+  }
+  else {
+    error = GetLastError();
+    if (error == ERROR_MORE_DATA) {
 
-          ResetEvent(read_io.hEvent);
-          ResetEvent(write_io.hEvent);
-          DisconnectNamedPipe(handle);
+      // partial message; the frame prefix tells us how much is left,
+      // so keep reading into the same buffer
 
-          connected = false;
-          error = 0;
+      console_reader_.Complete(bytes_read, true);
+    }
+    else if (error == ERROR_BROKEN_PIPE) {
 
-          if (ConnectNamedPipe(handle, &read_io)) {
-            std::cerr << "ERR in connectNamedPipe" << std::endl;
-            error = -1;
-          }
+      // reset and wait for reconnect
 
-        }
-        else {
-          DebugOut("error in GORE (console pipe): %d\n", error);
-          break;
-        }
+      std::cout << " * broken pipe [2] " << std::endl;
+
+      ResetEvent(console_read_io_.hEvent);
+      ResetEvent(console_write_io_.hEvent);
+      DisconnectNamedPipe(console_pipe_handle_);
+
+      console_pipe_connected_ = false;
+      console_reader_.Clear();
+
+      if (ConnectNamedPipe(console_pipe_handle_, &console_read_io_)) {
+        std::cerr << "ERR in connectNamedPipe" << std::endl;
+        CloseConsolePipe();
+        return;
       }
+
     }
-    else if (result == ERROR_BROKEN_PIPE) {
-      std::cout << " * broken pipe [1] " << std::endl;
-      connected = false;
-    }
-    else if (result != WAIT_TIMEOUT) {
-      error = GetLastError();
-      DebugOut("error in WaitForSingleObject: %d\n", error);
+    else if (error != ERROR_IO_INCOMPLETE) {
+      DebugOut("error in GORE (console pipe): %d\n", error);
+      CloseConsolePipe();
+      return;
     }
   }
 
-  CloseHandle(read_io.hEvent);
-  CloseHandle(write_io.hEvent);
-  CloseHandle(handle);
-  CloseHandle(console_notification_handle_);
-
-  console_notification_handle_ = 0;
-
-  delete[] buffer;
+  StartConsoleRead();
 
-  return 0;
 }
 
 int BERT::StartConsoleProcess() {
@@ -475,7 +506,7 @@ int BERT::StartConsoleProcess() {
   }
 
   if (!console_pipe_name_.length()) console_pipe_name_ = pipe_name.str();
-  uintptr_t console_thread_ptr = _beginthreadex(0, 0, ConsoleThreadFunction, this, 0, 0);
+  reactor_.Post([this]() { OpenConsolePipe(); });
 
   if (dev_flags_) {
     APIFunctions::GetRegistryString(console_command, "BERT2.OverrideConsoleCommand");
@@ -504,9 +535,10 @@ int BERT::StartConsoleProcess() {
   // add flag for management pipe
   command_line << " -m " << console_pipe_name_;
 
-  // add a -p (pipe) for each language
+  // add a -p (pipe) for each language. the console counts as using a 
+  // language, so this starts any that are lazy.
   for (auto language_service : language_services_) {
-    command_line << " -p " << language_service->pipe_name();
+    if (language_service->EnsureStarted()) command_line << " -p " << language_service->pipe_name();
   }
 
   // pass complete dev flags, process can parse
@@ -861,6 +893,8 @@ int BERT::ExcelCallback(const BERTBuffers::CallResponse &call, BERTBuffers::Call
 
 void BERT::Init() {
 
+  main_thread_id_ = GetCurrentThreadId();
+
   // ReadConfigFile();
 
   std::string config_file_path;
@@ -934,21 +968,48 @@ void BERT::Init() {
   SetEnvironmentVariableW(L"BERT_VERSION", BERT_VERSION);
   SetEnvironmentVariableA("BERT_BUILD_DATE", __TIMESTAMP__);
 
+  // the reactor runs callback pipes (and the console pipe), so it 
+  // has to be running before we initialize languages
+
+  reactor_.Start();
+
+  // the reactor has a fixed number of handles. the console needs two 
+  // (pipe and notification); the rest go to languages in order, and a
+  // language that doesn't fit its config gets fewer workers.
+
+  reactor_.Reserve(2);
+
   // set up initial languages 
-  // connect all first; then initialize
+  // launch all first, so the processes start in parallel; then connect; 
+  // then initialize. lazy languages are left until they're used.
   //for (const auto &descriptor : language_descriptors) {
   if (language_config.is_array()) {
     for (const auto &item : language_config.array_items()) {
       //auto service = std::make_shared<LanguageService>(callback_info_, object_map_, dev_flags_, config_, home_directory_, descriptor);
       auto service = std::make_shared<LanguageService>(callback_info_, object_map_, dev_flags_, config_, home_directory_, item);
       if (service->configured()) {
-        service->Connect(job_handle_); // is this synchronous? we can do these in parallel
+        service->LimitReactorHandles(reactor_.Reserve(service->reactor_handles()));
+        if (!service->lazy_start()) service->Launch(job_handle_);
         language_services_.push_back(service);
       }
       else std::cerr << "r service not configured, skipping" << std::endl;
     }
   }
 
+  // async calls don't hold a thread while they wait, but a process with 
+  // async calls pending has a reader task on the queue while nobody else 
+  // is reading its pipe (see LanguageService::PostAsync). so one thread 
+  // for each process (one per reactor handle), plus the usual threads 
+  // for completions.
+
+  size_t async_threads = ASYNC_COMPLETION_THREADS;
+  for (const auto &language_service : language_services_) async_threads += language_service->reactor_handles();
+  async_calls_.Start((uint32_t)async_threads);
+
+  for (const auto &language_service : language_services_) {
+    if (!language_service->lazy_start()) language_service->Connect();
+  }
+
   // ... insert callback thread ...
 
   // we need to check if connection failed and if so, remove the service
@@ -957,7 +1018,11 @@ void BERT::Init() {
 
   std::vector<std::shared_ptr<LanguageService>> connected;
   for (const auto &language_service : language_services_) {
-    if (language_service->connected()) {
+    if (language_service->lazy_start()) {
+      DebugOut("language %s will start on first use\n", language_service->name().c_str());
+      connected.push_back(language_service);
+    }
+    else if (language_service->connected()) {
       language_service->Initialize();
       connected.push_back(language_service);
     }
@@ -1081,9 +1146,18 @@ void BERT::Close() {
 
   // shutdown services
   for (const auto &language_service : language_services_) {
+    language_service->LogMemoryReports(MEMORY_REPORT_TIMEOUT);
     language_service->Shutdown();
   }
 
+  // pipes are closed by tasks posted above; those run before the thread exits
+  // async calls still waiting will fail once the pipes are closed
+
+  async_calls_.Stop();
+
+  reactor_.Post([this]() { CloseConsolePipe(); });
+  reactor_.Stop();
+
   // free marshalled pointer
   if (stream_pointer_) AtlFreeMarshalStream(stream_pointer_);
 
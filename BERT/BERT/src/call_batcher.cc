@@ -0,0 +1,188 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+#include "call_batcher.h"
+#include "message_utilities.h"
+
+#include <memory>
+
+CallBatcher::CallBatcher()
+  : thread_handle_(0)
+  , running_(false)
+  , window_(0)
+  , max_size_(MAX_BATCH_SIZE)
+{}
+
+CallBatcher::~CallBatcher() {
+  Stop();
+}
+
+unsigned __stdcall CallBatcher::StartThread(void *data) {
+  CallBatcher *batcher = reinterpret_cast<CallBatcher*>(data);
+  batcher->Run();
+  return 0;
+}
+
+void CallBatcher::Start(uint32_t window, uint32_t max_size, Sender sender) {
+  if (running_) return;
+  window_ = window;
+  max_size_ = max_size ? max_size : MAX_BATCH_SIZE;
+  sender_ = sender;
+  running_ = true;
+  thread_handle_ = (HANDLE)_beginthreadex(0, 0, StartThread, this, 0, 0);
+}
+
+void CallBatcher::Stop() {
+
+  std::vector<Batch> pending;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) return;
+    running_ = false;
+    for (auto &entry : batches_) pending.push_back(std::move(entry.second));
+    batches_.clear();
+  }
+  condition_.notify_all();
+
+  if (thread_handle_) {
+    if (WaitForSingleObject(thread_handle_, CALL_BATCHER_STOP_TIMEOUT) != WAIT_OBJECT_0) {
+      DebugOut("batcher thread did not exit\n");
+    }
+    CloseHandle(thread_handle_);
+    thread_handle_ = 0;
+  }
+
+  for (auto &batch : pending) Send(batch);
+
+}
+
+void CallBatcher::Submit(BERTBuffers::CallResponse &call, AsyncCompletion completion) {
+
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  if (!running_) {
+    lock.unlock();
+    sender_(call, completion);
+    return;
+  }
+
+  const std::string &function = call.function_call().function();
+  auto iter = batches_.find(function);
+
+  if (iter == batches_.end()) {
+    Batch &batch = batches_[function];
+    auto function_call = batch.call.mutable_function_call();
+    function_call->set_function(function);
+    function_call->set_flags(call.function_call().flags());
+    batch.call.set_wait(true);
+    batch.deadline = GetTickCount64() + window_;
+    iter = batches_.find(function);
+    condition_.notify_one(); // new deadline
+  }
+
+  Batch &batch = iter->second;
+  auto arguments = batch.call.mutable_function_call()->add_arguments()->mutable_arr();
+  arguments->mutable_data()->Swap(call.mutable_function_call()->mutable_arguments());
+  arguments->set_rows(arguments->data_size());
+  arguments->set_cols(1);
+  batch.completions.push_back(completion);
+
+  if (batch.completions.size() >= max_size_) {
+    Batch full = std::move(batch);
+    batches_.erase(iter);
+    lock.unlock();
+    Send(full);
+  }
+
+}
+
+void CallBatcher::Send(Batch &batch) {
+
+  auto function_call = batch.call.mutable_function_call();
+
+  // one call: unwrap it and send it as is
+
+  if (batch.completions.size() == 1) {
+    BERTBuffers::CallResponse call;
+    call.set_wait(true);
+    auto single = call.mutable_function_call();
+    single->set_function(function_call->function());
+    single->set_flags(function_call->flags());
+    single->mutable_arguments()->Swap(function_call->mutable_arguments(0)->mutable_arr()->mutable_data());
+    sender_(call, batch.completions[0]);
+    return;
+  }
+
+  function_call->set_flags(function_call->flags() | FUNCTION_FLAG_BATCH);
+
+  auto completions = std::make_shared<std::vector<AsyncCompletion>>(std::move(batch.completions));
+
+  sender_(batch.call, [completions](BERTBuffers::CallResponse &response) {
+
+    size_t count = completions->size();
+    bool batched = (response.operation_case() == BERTBuffers::CallResponse::OperationCase::kResult
+      && response.result().value_case() == BERTBuffers::Variable::ValueCase::kArr
+      && response.result().arr().data_size() == count);
+
+    for (size_t i = 0; i < count; i++) {
+      BERTBuffers::CallResponse element;
+      element.set_id(response.id());
+      if (batched) element.mutable_result()->Swap(response.mutable_result()->mutable_arr()->mutable_data((int)i));
+      else if (response.operation_case() == BERTBuffers::CallResponse::OperationCase::kErr) element.set_err(response.err());
+      else element.set_err("invalid batch response");
+      (*completions)[i](element);
+    }
+
+  });
+
+}
+
+void CallBatcher::Run() {
+
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  while (running_) {
+
+    std::vector<Batch> ready;
+    uint64_t now = GetTickCount64();
+    uint64_t next = 0;
+
+    for (auto iter = batches_.begin(); iter != batches_.end(); ) {
+      if (iter->second.deadline <= now) {
+        ready.push_back(std::move(iter->second));
+        iter = batches_.erase(iter);
+      }
+      else {
+        if (!next || iter->second.deadline < next) next = iter->second.deadline;
+        ++iter;
+      }
+    }
+
+    if (ready.size()) {
+      lock.unlock();
+      for (auto &batch : ready) Send(batch);
+      lock.lock();
+    }
+    else if (next) condition_.wait_for(lock, std::chrono::milliseconds(next - now));
+    else condition_.wait(lock);
+
+  }
+
+}
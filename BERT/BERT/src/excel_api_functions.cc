@@ -113,9 +113,18 @@ void RegisterFunctions() {
 
     ss.clear();
     ss.str("");
-    ss << "BERTFunctionCall" << index;
+    // async functions return void (>) and take excel's async handle (X)
+    // as the last argument; they go to a separate set of entry points.
+
+    bool async = (entry->flags_ & FUNCTION_FLAG_ASYNC) != 0;
+    ss << (async ? "BERTAsyncFunctionCall" : "BERTFunctionCall") << index;
     Convert::StringToXLOPER(xlParm[1], ss.str(), false);
-    Convert::StringToXLOPER(xlParm[2], "UQQQQQQQQQQQQQQQQ", false);
+
+    // thread-safe functions ($) can be called from excel's recalc threads
+
+    std::string type_text = async ? ">QQQQQQQQQQQQQQQQX" : "UQQQQQQQQQQQQQQQQ";
+    if (entry->flags_ & FUNCTION_FLAG_THREAD_SAFE) type_text.append("$");
+    Convert::StringToXLOPER(xlParm[2], type_text, false);
 
     ss.clear();
     ss.str("");
@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+#include "in_process_host.h"
+#include "windows_api_functions.h"
+
+#include <sstream>
+
+/** console output from the host goes to the debug log */
+static void HostConsole(const char *text, int32_t length, int32_t flag) {
+  std::string message(text, length);
+  if (flag) std::cerr << message;
+  else std::cout << message;
+}
+
+InProcessHost::InProcessHost()
+  : module_(0)
+  , call_(0)
+  , release_(0)
+  , shutdown_(0)
+  , available_(false)
+  , call_count_(0)
+  , call_time_(0)
+{
+}
+
+bool InProcessHost::Load(const std::string &library_path, const std::string &prepend_path, const std::string &language_home, const std::string &bert_home) {
+
+  if (available_ || module_) return available_;
+
+  std::string old_path = APIFunctions::GetPath();
+  APIFunctions::PrependPath(prepend_path);
+
+  module_ = LoadLibraryA(library_path.c_str());
+
+  APIFunctions::SetPath(old_path);
+
+  if (!module_) {
+    std::cerr << "ERR: can't load in-process host " << library_path << " (" << GetLastError() << ")" << std::endl;
+    return false;
+  }
+
+  RHostInitializeProcedure initialize = reinterpret_cast<RHostInitializeProcedure>(GetProcAddress(module_, "RHostInitialize"));
+  call_ = reinterpret_cast<RHostCallProcedure>(GetProcAddress(module_, "RHostCall"));
+  release_ = reinterpret_cast<RHostReleaseProcedure>(GetProcAddress(module_, "RHostRelease"));
+  shutdown_ = reinterpret_cast<RHostShutdownProcedure>(GetProcAddress(module_, "RHostShutdown"));
+
+  if (!initialize || !call_ || !release_ || !shutdown_) {
+    std::cerr << "ERR: in-process host is missing exports" << std::endl;
+    return false;
+  }
+
+  int32_t result = initialize(language_home.c_str(), bert_home.c_str(), HostConsole);
+  if (result) {
+    std::cerr << "ERR: in-process host failed to start (" << result << ")" << std::endl;
+    return false;
+  }
+
+  available_ = true;
+  return true;
+
+}
+
+bool InProcessHost::Call(BERTBuffers::CallResponse &response, const BERTBuffers::CallResponse &call) {
+
+  if (!available_) return false;
+
+  LARGE_INTEGER frequency, start, end;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&start);
+
+  std::string message = call.SerializeAsString();
+  char *data = 0;
+  uint32_t length = 0;
+
+  if (call_(message.c_str(), (uint32_t)message.length(), &data, &length)) return false;
+
+  bool result = response.ParseFromArray(data, length);
+  release_(data);
+
+  QueryPerformanceCounter(&end);
+  call_count_++;
+  call_time_ += (uint64_t)((end.QuadPart - start.QuadPart) * 1000000 / frequency.QuadPart);
+
+  return result;
+
+}
+
+void InProcessHost::Shutdown() {
+  if (!available_) return;
+  available_ = false;
+  shutdown_();
+}
+
+std::string InProcessHost::Report() {
+  uint64_t count = call_count_;
+  std::stringstream ss;
+  ss << "in-process calls: " << count;
+  if (count) ss << ", average " << (call_time_ / count) << " us";
+  return ss.str();
+}
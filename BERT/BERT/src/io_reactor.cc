@@ -0,0 +1,179 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "stdafx.h"
+#include "io_reactor.h"
+
+#include <algorithm>
+#include <iostream>
+
+IOReactor::IOReactor()
+  : thread_handle_(0)
+  , thread_id_(0)
+  , running_(false)
+  , reserved_(1)
+{
+  InitializeCriticalSectionAndSpinCount(&critical_section_, 0x00000400);
+  wake_event_ = CreateEvent(0, TRUE, FALSE, 0);
+  handles_.push_back(wake_event_);
+  handlers_.push_back(nullptr);
+}
+
+IOReactor::~IOReactor() {
+  Stop();
+  CloseHandle(wake_event_);
+  DeleteCriticalSection(&critical_section_);
+}
+
+unsigned __stdcall IOReactor::StartThread(void *data) {
+  HRESULT hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+  IOReactor *reactor = reinterpret_cast<IOReactor*>(data);
+  reactor->Run();
+  CoUninitialize();
+  return 0;
+}
+
+void IOReactor::Start() {
+  if (running_) return;
+  running_ = true;
+  unsigned thread_id = 0;
+  thread_handle_ = _beginthreadex(0, 0, StartThread, this, 0, &thread_id);
+  thread_id_ = thread_id;
+}
+
+void IOReactor::Stop() {
+  if (!thread_handle_) return;
+  running_ = false;
+  SetEvent(wake_event_);
+  if (!on_thread()) {
+    if (WaitForSingleObject((HANDLE)thread_handle_, IO_REACTOR_STOP_TIMEOUT) != WAIT_OBJECT_0) {
+      DebugOut("reactor thread did not exit\n");
+    }
+  }
+  CloseHandle((HANDLE)thread_handle_);
+  thread_handle_ = 0;
+}
+
+void IOReactor::Post(Handler task) {
+  EnterCriticalSection(&critical_section_);
+  tasks_.push_back(task);
+  LeaveCriticalSection(&critical_section_);
+  SetEvent(wake_event_);
+}
+
+bool IOReactor::Add(HANDLE handle, Handler handler) {
+  if (handles_.size() >= IO_REACTOR_MAX_HANDLES) {
+    std::cerr << "reactor is full (" << IO_REACTOR_MAX_HANDLES << " handles), not adding handle" << std::endl;
+    return false;
+  }
+  handles_.push_back(handle);
+  handlers_.push_back(handler);
+  return true;
+}
+
+size_t IOReactor::Reserve(size_t count) {
+  EnterCriticalSection(&critical_section_);
+  size_t available = (reserved_ < IO_REACTOR_MAX_HANDLES) ? IO_REACTOR_MAX_HANDLES - reserved_ : 0;
+  if (count > available) count = available;
+  reserved_ += count;
+  LeaveCriticalSection(&critical_section_);
+  return count;
+}
+
+void IOReactor::Remove(HANDLE handle) {
+  for (size_t i = 1; i < handles_.size(); i++) {
+    if (handles_[i] == handle) {
+      handles_.erase(handles_.begin() + i);
+      handlers_.erase(handlers_.begin() + i);
+      return;
+    }
+  }
+}
+
+size_t IOReactor::RemoveInvalidHandles() {
+  size_t removed = 0;
+  for (size_t i = 1; i < handles_.size(); ) {
+    if (WaitForSingleObject(handles_[i], 0) == WAIT_FAILED) {
+      std::cerr << "reactor: removing invalid handle (" << GetLastError() << ")" << std::endl;
+      handles_.erase(handles_.begin() + i);
+      handlers_.erase(handlers_.begin() + i);
+      removed++;
+    }
+    else i++;
+  }
+  return removed;
+}
+
+void IOReactor::RunTasks() {
+  std::vector<Handler> tasks;
+  EnterCriticalSection(&critical_section_);
+  tasks.swap(tasks_);
+  LeaveCriticalSection(&critical_section_);
+  for (auto task : tasks) task();
+}
+
+void IOReactor::Run() {
+
+  while (running_) {
+
+    DWORD count = (DWORD)handles_.size();
+    DWORD result = WaitForMultipleObjects(count, &(handles_[0]), FALSE, INFINITE);
+
+    // a failed wait means a bad handle (closed while registered) or too 
+    // many handles. report it; if we can drop the bad handles, keep going,
+    // because callbacks and the console stop working if this thread exits.
+
+    if (result >= WAIT_OBJECT_0 + count) {
+      DWORD err = GetLastError();
+      std::cerr << "reactor wait failed (" << err << "), " << count << " handles" << std::endl;
+      if (RemoveInvalidHandles()) continue;
+      std::cerr << "reactor stopped; callbacks and console i/o won't be serviced" << std::endl;
+      running_ = false;
+      break;
+    }
+
+    // the wait reports the lowest signaled index. so a busy pipe can't 
+    // starve the ones after it, dispatch everything that's signaled.
+    // handlers can remove handles, so look each one up as we go.
+
+    std::vector<HANDLE> signaled;
+    for (DWORD i = result - WAIT_OBJECT_0; i < count; i++) {
+      if (i == result - WAIT_OBJECT_0 || WaitForSingleObject(handles_[i], 0) == WAIT_OBJECT_0) {
+        signaled.push_back(handles_[i]);
+      }
+    }
+
+    for (auto handle : signaled) {
+      if (handle == wake_event_) {
+        ResetEvent(wake_event_);
+        RunTasks();
+        continue;
+      }
+      auto iter = std::find(handles_.begin(), handles_.end(), handle);
+      if (iter == handles_.end()) continue; // removed
+      Handler handler = handlers_[iter - handles_.begin()]; // copy; it may remove itself
+      handler();
+    }
+
+  }
+
+  // anything posted on the way out (cleanup)
+  RunTasks();
+
+}
@@ -37,9 +37,33 @@ void LanguageDescriptor::FromJSON(const json11::Json& item, const std::string &h
     startup_resource_path_ = startup_resource_path;
   }
 
+  // a prebuilt image for the language (julia sysimage), relative to the 
+  // BERT home directory. the child falls back to the default image if 
+  // the file doesn't exist.
+
+  if (!item["sysimage"].is_null()) {
+    std::string sysimage_path = home_directory;
+    sysimage_path.append(item["sysimage"].string_value());
+    sysimage_path_ = sysimage_path;
+  }
+
+  // library for the in-process host (see InProcessHost), relative to the 
+  // BERT home directory. it's only used if the config turns it on.
+
+  if (!item["host_library"].is_null()) {
+    std::string host_library_path = home_directory;
+    host_library_path.append(item["host_library"].string_value());
+    host_library_path_ = host_library_path;
+  }
+
   // can probably just call bool_value() regardless, should return false if not present
   if (!item["named_arguments"].is_null()) named_arguments_ = item["named_arguments"].bool_value();
 
+  // the control process can run as a shared server (one per user, for
+  // several excel instances). it's only used if the config turns it on.
+
+  if (!item["shared_server"].is_null()) shared_server_ = item["shared_server"].bool_value();
+
   if (!item["name"].is_null()) name_ = item["name"].string_value();
   if (!item["executable"].is_null()) executable_ = item["executable"].string_value();
   if (!item["prefix"].is_null()) prefix_ = item["prefix"].string_value();
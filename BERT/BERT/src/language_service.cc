@@ -24,21 +24,59 @@
 #include "language_service.h"
 #include "string_utilities.h"
 
+#include <thread>
+#include <fstream>
+#include <algorithm>
+
 // by convention we don't use transaction 0. 
 // this may cause a problem if it rolls over.
-uint32_t LanguageService::transaction_id_ = 1;
+std::atomic<uint32_t> LanguageService::transaction_id_(1);
 
 //LanguageService::LanguageService(CallbackInfo &callback_info, COMObjectMap &object_map, DWORD dev_flags, const json11::Json &config, const std::string &home_directory, const LanguageDescriptor &descriptor)
 LanguageService::LanguageService(CallbackInfo &callback_info, COMObjectMap &object_map, DWORD dev_flags, const json11::Json &config, const std::string &home_directory, const json11::Json &json)
   : callback_info_(callback_info)
   , object_map_(object_map)
   , dev_flags_(dev_flags)
+  , ready_event_(0)
+  , launch_time_(0)
   , connected_(false)
   , configured_(false)
+  , lazy_start_(false)
+  , ready_(true)
+  , starting_(false)
+  , application_pointer_(0)
+  , cached_functions_(false)
+  , shared_ring_size_(0)
+  , stream_chunk_cells_(STREAM_CHUNK_CELLS)
+  , compression_threshold_(COMPRESSION_THRESHOLD)
+  , call_timeout_(0)
+  , batch_window_(0)
+  , batch_size_(MAX_BATCH_SIZE)
+  , worker_count_(1)
+  , affinity_routing_(false)
+  , next_worker_(0)
+  , outstanding_calls_(0)
+  , failed_(false)
+  , standby_enabled_(false)
+  , standby_count_(0)
+  , in_process_(false)
+  , shared_(false)
+  , launch_mutex_(0)
+  , config_(config)
+  , descriptor_json_(json)
+  , home_directory_(home_directory)
+  , reader_active_(false)
+  , async_reader_(false)
+  , management_pipe_handle_(0)
+  , callback_pipe_handle_(0)
   // , resource_id_(0)
   // , language_descriptor_(descriptor)
 {
   memset(&io_, 0, sizeof(io_));
+  memset(&write_io_, 0, sizeof(write_io_));
+  memset(&callback_io_, 0, sizeof(callback_io_));
+  memset(&process_info_, 0, sizeof(process_info_));
+  memset(&startup_timing_, 0, sizeof(startup_timing_));
 
   // we're now receiving the json descriptor instead of the object, but we still
   // want to construct the object. the json descriptor may have multiple versions
@@ -51,6 +89,81 @@ LanguageService::LanguageService(CallbackInfo &callback_info, COMObjectMap &obje
   configured_ = !(config["BERT"][language_descriptor_.name_].is_null());
   if (!configured_) return;
 
+  // shared memory ring for large payloads (optional, size in MB)
+
+  if (config["BERT"][language_descriptor_.name_]["sharedMemory"].is_number()) {
+    int megabytes = config["BERT"][language_descriptor_.name_]["sharedMemory"].int_value();
+    if (megabytes > 0) shared_ring_size_ = (uint64_t)megabytes * 1024 * 1024;
+  }
+
+  // streamed results, chunk size in cells (0 to turn off)
+
+  if (config["BERT"][language_descriptor_.name_]["streamChunk"].is_number()) {
+    int cells = config["BERT"][language_descriptor_.name_]["streamChunk"].int_value();
+    stream_chunk_cells_ = cells > 0 ? cells : 0;
+  }
+
+  // frame compression, minimum message size in bytes (0 to turn off)
+
+  if (config["BERT"][language_descriptor_.name_]["compression"].is_number()) {
+    int bytes = config["BERT"][language_descriptor_.name_]["compression"].int_value();
+    compression_threshold_ = bytes > 0 ? bytes : 0;
+  }
+
+  // worker pool size (default 1, "auto" for one per core) and routing
+
+  json11::Json workers = config["BERT"][language_descriptor_.name_]["workers"];
+  if (workers.is_number() && workers.int_value() > 1) worker_count_ = workers.int_value();
+  else if (workers.is_string() && !workers.string_value().compare("auto")) worker_count_ = std::thread::hardware_concurrency();
+  if (worker_count_ < 1) worker_count_ = 1;
+  if (worker_count_ > MAX_WORKER_COUNT) worker_count_ = MAX_WORKER_COUNT;
+
+  json11::Json routing = config["BERT"][language_descriptor_.name_]["routing"];
+  affinity_routing_ = (routing.is_string() && !routing.string_value().compare("affinity"));
+
+  // function call timeout, in seconds (0 or missing for none)
+
+  if (config["BERT"][language_descriptor_.name_]["callTimeout"].is_number()) {
+    double seconds = config["BERT"][language_descriptor_.name_]["callTimeout"].number_value();
+    call_timeout_ = seconds > 0 ? (uint32_t)(seconds * 1000) : 0;
+  }
+
+  // warm standby (see PrepareStandby)
+
+  standby_enabled_ = config["BERT"][language_descriptor_.name_]["standby"].bool_value();
+
+  // in-process host for thread-safe functions (see InProcessHost)
+
+  in_process_ = config["BERT"][language_descriptor_.name_]["inProcess"].bool_value();
+
+  // shared server, if the language supports it. that means one process, 
+  // and no shared memory (the server has one pair of rings).
+
+  shared_ = language_descriptor_.shared_server_ && config["BERT"][language_descriptor_.name_]["shared"].bool_value();
+  if (shared_) {
+    worker_count_ = 1;
+    standby_enabled_ = false;
+    shared_ring_size_ = 0;
+  }
+
+  // lazy start: start the process when the language is first used
+
+  lazy_start_ = config["BERT"][language_descriptor_.name_]["lazyStart"].bool_value();
+  ready_ = !lazy_start_;
+
+  // batching for async calls: window in ms (0 or missing to turn off),
+  // and the largest batch
+
+  if (config["BERT"][language_descriptor_.name_]["batchWindow"].is_number()) {
+    int window = config["BERT"][language_descriptor_.name_]["batchWindow"].int_value();
+    batch_window_ = window > 0 ? window : 0;
+  }
+
+  if (config["BERT"][language_descriptor_.name_]["batchSize"].is_number()) {
+    int size = config["BERT"][language_descriptor_.name_]["batchSize"].int_value();
+    if (size > 0) batch_size_ = size;
+  }
+
   std::string override_home;
   if (config["BERT"][language_descriptor_.name_]["home"].is_string()) override_home = config["BERT"][language_descriptor_.name_]["home"].string_value();
 
@@ -198,6 +311,21 @@ LanguageService::LanguageService(CallbackInfo &callback_info, COMObjectMap &obje
     APIFunctions::GetRegistryString(pipe_name_, override_key.c_str());
   }
 
+  // a shared server is per user, not per process. pipes are visible 
+  // across sessions, so the user name keeps it to this user (and it goes
+  // on the command line, so it's scrubbed).
+
+  if (!pipe_name_.length() && shared_) {
+    char user[256];
+    DWORD length = sizeof(user);
+    if (!GetUserNameA(user, &length)) strcpy_s(user, "user");
+    std::string user_name(user);
+    for (auto &c : user_name) if (!isalnum((unsigned char)c)) c = '_';
+    std::stringstream ss;
+    ss << "BERT2-PIPE-" << language_descriptor_.prefix_ << "-SHARED-" << user_name;
+    pipe_name_ = ss.str();
+  }
+
   if (!pipe_name_.length()) {
     std::stringstream ss;
     ss << "BERT2-PIPE-" << language_descriptor_.prefix_ << "-" << _getpid();
@@ -208,8 +336,25 @@ LanguageService::LanguageService(CallbackInfo &callback_info, COMObjectMap &obje
 
 void LanguageService::Initialize() {
 
+  uint64_t start = GetTickCount64();
+
   if (connected_) {
-    uintptr_t callback_thread_ptr = _beginthreadex(0, 0, CallbackThreadFunction, this, 0, 0);
+    if (shared_) RegisterClient();
+    BERT::Instance()->reactor().Post([this]() { OpenCallbackPipe(); });
+
+    // the host starts here, so it gets the startup code and source files
+    // in the same order as the process
+
+    if (in_process_ && language_descriptor_.host_library_path_.length()) {
+      std::string prepend = language_descriptor_.prepend_path_;
+      InterpolateString(prepend);
+      host_.Load(language_descriptor_.host_library_path_, prepend, language_descriptor_.home_, home_directory_);
+    }
+
+    if (shared_ring_size_) OpenSharedRings();
+    if (stream_chunk_cells_) EnableStreaming();
+    if (compression_threshold_) EnableCompression();
+    if (batch_window_) EnableBatching();
 
     // get embedded startup code, split into lines
     // FIXME: why do we require that this be in multiple lines?
@@ -237,409 +382,1479 @@ void LanguageService::Initialize() {
       code->set_startup(true);
       Call(response, call);
 
+      if (host_.available()) host_.Call(response, call);
+
     }
   }
 
-}
+  startup_timing_.initialize = GetTickCount64() - start;
 
-void LanguageService::SetApplicationPointer(LPDISPATCH application_pointer) {
-  BERTBuffers::CallResponse call, response;
+  for (auto worker : workers_) worker->Initialize();
 
-  auto function_call = call.mutable_function_call();
-  function_call->set_function("install-application-pointer"); // generic
-  function_call->set_target(BERTBuffers::CallTarget::system);
-  object_map_.DispatchToVariable(function_call->add_arguments(), application_pointer, true);
+  // the standby starts after everything else, in the background
+
+  if (connected_ && standby_enabled_) StartStandby();
 
-  Call(response, call);
 }
 
-void LanguageService::RunCallbackThread() {
+void LanguageService::StartStandby() {
 
-  int buffer_size = 1024 * 8;
-  char *buffer = new char[buffer_size];
-  std::stringstream ss;
-  ss << "\\\\.\\pipe\\" << pipe_name_ << "-CB";
+  // the last one is finished (or nearly: we only start another once it 
+  // has made its standby available)
 
-  auto bert = BERT::Instance();
+  if (standby_thread_.joinable()) standby_thread_.join();
+  standby_thread_ = std::thread([this]() { PrepareStandby(); });
 
-  HANDLE callback_pipe_handle = CreateFileA(ss.str().c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, 0);
-  if (!callback_pipe_handle || callback_pipe_handle == INVALID_HANDLE_VALUE) {
-    DWORD err = GetLastError();
-    DebugOut("err opening pipe [1]: %d\n", err);
-  }
-  else {
+}
 
-    DebugOut("Connected to callback pipe\n");
+void LanguageService::PrepareStandby() {
 
-    DWORD mode = PIPE_READMODE_MESSAGE;
-    BOOL state = SetNamedPipeHandleState(callback_pipe_handle, &mode, 0, 0);
+  if (!standby_enabled_) return;
 
-    DWORD bytes = 0;
-    OVERLAPPED io;
+  uint64_t start = GetTickCount64();
 
-    std::string message_buffer;
+  std::shared_ptr<LanguageService> standby;
+  {
+    std::lock_guard<std::mutex> lock(standby_mutex_);
+    standby = CreateWorker(worker_count_ + standby_count_++);
+  }
 
-    memset(&io, 0, sizeof(io));
-    io.hEvent = CreateEvent(0, TRUE, FALSE, 0);
-    ReadFile(callback_pipe_handle, buffer, buffer_size, 0, &io);
-    while (true) {
-      DWORD result = WaitForSingleObject(io.hEvent, 1000);
-      if (result == WAIT_OBJECT_0) {
-        ResetEvent(io.hEvent);
-        //DWORD rslt = GetOverlappedResultEx(callback_pipe_handle, &io, &bytes, 0, FALSE);
-        DWORD rslt = GetOverlappedResult(callback_pipe_handle, &io, &bytes, FALSE);
-        if (rslt) {
-
-          BERTBuffers::CallResponse &call = callback_info_.callback_call_;
-          BERTBuffers::CallResponse &response = callback_info_.callback_response_;
-
-          call.Clear();
-          response.Clear();
-
-          if (message_buffer.length()) {
-            message_buffer.append(buffer, bytes);
-            MessageUtilities::Unframe(call, message_buffer);
-            message_buffer = "";
-          }
-          else {
-            MessageUtilities::Unframe(call, buffer, bytes);
-          }
+  standby->Launch(BERT::Instance()->job_handle());
+  standby->Connect();
+  if (!standby->connected()) {
+    DebugOut("%s: standby did not connect\n", language_descriptor_.name_.c_str());
+    return;
+  }
+  standby->Initialize();
 
-          bert->HandleCallback(language_descriptor_.name_);
-          //DumpJSON(response);
+  // replay what we have so far; then anything that came in meanwhile, 
+  // with the lock held, so we don't miss a file between the two
 
-          if (call.wait()) {
-            std::string str_response = MessageUtilities::Frame(response);
-            WriteFile(callback_pipe_handle, str_response.c_str(), (int32_t)str_response.size(), &bytes, &io);
-            //result = GetOverlappedResultEx(callback_pipe_handle, &io, &bytes, INFINITE, FALSE);
-            result = GetOverlappedResult(callback_pipe_handle, &io, &bytes, TRUE);
-          }
+  std::vector<std::string> files;
+  LPDISPATCH application_pointer;
+  {
+    std::lock_guard<std::mutex> lock(standby_mutex_);
+    files = source_files_;
+  }
+  {
+    std::lock_guard<std::recursive_mutex> lock(start_mutex_);
+    application_pointer = application_pointer_;
+  }
 
-          // restart
-          ResetEvent(io.hEvent);
-          ReadFile(callback_pipe_handle, buffer, buffer_size, 0, &io);
+  if (application_pointer) standby->SetApplicationPointer(application_pointer);
+  for (const auto &file : files) standby->ReadSourceFile(file);
 
-        }
-        else {
-          DWORD err = GetLastError();
-          if (err == ERROR_MORE_DATA) {
-            message_buffer.append(buffer, bytes);
-            ResetEvent(io.hEvent);
-            ReadFile(callback_pipe_handle, buffer, buffer_size, 0, &io);
-          }
-          else {
-            DebugOut("ERR in GORE: %d\n", err);
-            // ...
-            break;
-          }
-        }
-      }
-      else if (result != WAIT_TIMEOUT) {
-        DebugOut("callback pipe error: %d\n", GetLastError());
-        break;
-      }
+  {
+    std::lock_guard<std::mutex> lock(standby_mutex_);
+    for (size_t i = files.size(); i < source_files_.size(); i++) standby->ReadSourceFile(source_files_[i]);
+    if (standby_enabled_) {
+      standby_ = standby;
+      standby.reset();
     }
-
-    CloseHandle(io.hEvent);
-    DisconnectNamedPipe(callback_pipe_handle);
-    CloseHandle(callback_pipe_handle);
   }
-  delete buffer;
-}
 
-int LanguageService::LaunchProcess(HANDLE job_handle, char *command_line) {
+  // shut down while we were starting
 
-  STARTUPINFOA si;
+  if (standby) standby->Shutdown();
+  else DebugOut("%s: standby ready (%d ms)\n", language_descriptor_.name_.c_str(), (int)(GetTickCount64() - start));
 
-  ZeroMemory(&si, sizeof(si));
-  si.cb = sizeof(si);
+}
 
-  ZeroMemory(&process_info_, sizeof(process_info_));
+bool LanguageService::PromoteStandby(size_t index) {
 
-  int result = 0;
+  if (!standby_) return false;
 
-  DWORD creation_flags = CREATE_NO_WINDOW;
-  if (dev_flags_ & 0x01) creation_flags = 0;
+  std::shared_ptr<LanguageService> &slot = index ? workers_[index - 1] : replacement_;
+  if (slot) retired_.push_back(slot);
+  slot = standby_;
+  standby_.reset();
 
-  if (!CreateProcessA(0, command_line, 0, 0, FALSE, creation_flags, 0, 0, &si, &process_info_))
-  {
-    DebugOut("CreateProcess failed (%d).\n", GetLastError());
-    result = GetLastError();
-  }
-  else {
-    child_process_id_ = process_info_.dwProcessId;
-    if (job_handle) {
-      if (!AssignProcessToJobObject(job_handle, process_info_.hProcess))
-      {
-        DebugOut("Could not AssignProcessToObject\n");
-      }
-    }
-  }
+  DebugOut("%s: standby replaced failed process (%d)\n", language_descriptor_.name_.c_str(), (int)index);
 
-  return result;
-}
+  StartStandby();
+  return true;
 
-bool LanguageService::ProcessExitCode(DWORD *exit_code) {
-  return GetExitCodeProcess(process_info_.hProcess, exit_code) ? true : false;
 }
 
-void LanguageService::Connect(HANDLE job_handle) {
-
-  int rslt = StartChildProcess(job_handle);
-  int errs = 0;
+LanguageService* LanguageService::Primary() {
+  if (!standby_enabled_) return this;
+  std::lock_guard<std::mutex> lock(standby_mutex_);
+  LanguageService *primary = replacement_ ? replacement_.get() : this;
+  if (standby_ && primary->failed() && PromoteStandby(0)) primary = replacement_.get();
+  return primary;
+}
 
-  buffer_ = new char[PIPE_BUFFER_SIZE];
-  io_.hEvent = CreateEvent(0, TRUE, TRUE, 0); // FIXME: clean this up
+std::vector<std::shared_ptr<LanguageService>> LanguageService::Workers() {
+  std::unique_lock<std::mutex> lock(standby_mutex_, std::defer_lock);
+  if (standby_enabled_) lock.lock();
+  return workers_;
+}
 
-  if (!rslt) {
+void LanguageService::EnableBatching() {
 
-    std::string full_name = "\\\\.\\pipe\\";
-    full_name.append(pipe_name_);
+  BERTBuffers::CallResponse call, response;
+  call.set_wait(true);
 
-    while (1) {
-      pipe_handle_ = CreateFileA(full_name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, 0);
-      if (!pipe_handle_ || pipe_handle_ == INVALID_HANDLE_VALUE) {
+  auto function_call = call.mutable_function_call();
+  function_call->set_function("batch-calls");
+  function_call->set_target(BERTBuffers::CallTarget::system);
 
-        DWORD exit_code = 0;
-        if (!GetExitCodeProcess(process_info_.hProcess, &exit_code)) {
-          std::cerr << "error calling get exit code process: " << GetLastError() << std::endl;
-        }
-        else if (exit_code != STILL_ACTIVE) {
-          std::cerr << "process exited with exit code " << exit_code << std::endl;
-          break;
-        }
+  Call(response, call);
 
-        DWORD err = GetLastError();
-        DebugOut("err opening pipe [2]: %d\n", err);
-        if (errs++ > 30) break;
-        Sleep(100);
-      }
-      else {
-        DWORD mode = PIPE_READMODE_MESSAGE;
-        BOOL state = SetNamedPipeHandleState(pipe_handle_, &mode, 0, 0);
-        connected_ = true;
-        DebugOut("Connected (errs: %d)\n", errs);
-        break;
-      }
-    }
+  if (response.operation_case() != BERTBuffers::CallResponse::OperationCase::kResult || !response.result().boolean()) {
+    DebugOut("child process does not support batched calls\n");
+    return;
   }
 
+  batcher_.Start(batch_window_, batch_size_, [this](BERTBuffers::CallResponse &call, AsyncCompletion completion) {
+    PostAsync(call, completion);
+  });
+
 }
 
-void LanguageService::ReadSourceFile(const std::string &file) {
+void LanguageService::RegisterClient() {
 
   BERTBuffers::CallResponse call, response;
-  call.set_wait(true); // prevent race
+  call.set_wait(true);
 
   auto function_call = call.mutable_function_call();
-  function_call->set_function("read-source-file");
+  function_call->set_function("register-client");
   function_call->set_target(BERTBuffers::CallTarget::system);
-  function_call->add_arguments()->set_str(file);
-  function_call->add_arguments()->set_boolean(true); // notify
+  function_call->add_arguments()->set_integer(_getpid());
 
   Call(response, call);
 
+  if (response.operation_case() != BERTBuffers::CallResponse::OperationCase::kResult || !response.result().str().length()) {
+    DebugOut("shared server did not register client; no callbacks\n");
+    return;
+  }
+
+  callback_pipe_name_ = response.result().str();
+  DebugOut("registered with shared server (callback %s)\n", callback_pipe_name_.c_str());
+
 }
 
-void LanguageService::InterpolateString(std::string &str, const std::vector<std::pair<std::string, std::string>> &additional_replacements){
+void LanguageService::LogMemoryReports(uint32_t timeout_ms) {
 
-  auto replace_function = [](std::string &haystack, std::string needle, std::string replacement) {
-    for (std::string::size_type i = 0; (i = haystack.find(needle, i)) != std::string::npos;)
-    {
-      haystack.replace(i, needle.length(), replacement);
-      i += replacement.length();
-    }
-  };
-  
-  // NOTE: this is designed for switching x86/x64 R, but we actually
-  // want 64-bit R even with 32-bit Excel; the only reason to do this
-  // would be if you were running on a 32-bit machine, which we don't
-  // ncessarily want to support.
+  std::vector<std::shared_ptr<LanguageService>> pool;
+  {
+    std::lock_guard<std::mutex> lock(standby_mutex_);
+    pool = workers_;
+    if (replacement_) pool.push_back(replacement_);
+    if (standby_) pool.push_back(standby_);
+  }
 
-#ifdef _WIN64
-  const char arch[] = "x64";
-#else
-  const char arch[] = "i386";
-#endif
+  std::vector<LanguageService*> processes;
+  if (healthy()) processes.push_back(this);
+  for (auto process : pool) if (process->healthy()) processes.push_back(process.get());
 
-  replace_function(str, "$HOME", language_descriptor_.home_);
-  replace_function(str, "$ARCH", arch);
-  replace_function(str, "$NAME", language_descriptor_.name_);
+  // ask everyone first, so they work on it in parallel and one busy 
+  // process only costs its own report
 
-  for (const auto &pair : additional_replacements) {
-    replace_function(str, pair.first, pair.second);
+  std::vector<uint32_t> ids;
+  for (auto process : processes) ids.push_back(process->RequestMemoryReport());
+
+  uint64_t deadline = GetTickCount64() + timeout_ms;
+  for (size_t i = 0; i < processes.size(); i++) {
+    uint64_t now = GetTickCount64();
+    std::string report = processes[i]->WaitMemoryReport(ids[i], (uint32_t)(deadline > now ? deadline - now : 1));
+    if (report.length()) DebugOut("%s memory (%s):\n%s\n", language_descriptor_.name_.c_str(), processes[i]->pipe_name_.c_str(), report.c_str());
   }
 
 }
 
-bool LanguageService::ValidFile(const std::string &file) {
+uint32_t LanguageService::RequestMemoryReport() {
 
-  // path functions can't operate on const strings
+  BERTBuffers::CallResponse call;
+  call.set_wait(true);
 
-  static char path[MAX_PATH];
+  auto function_call = call.mutable_function_call();
+  function_call->set_function("memory-stats");
+  function_call->set_target(BERTBuffers::CallTarget::system);
 
-  size_t len = file.length();
-  if (len > MAX_PATH - 2) len = MAX_PATH - 2;
-  memcpy(path, file.c_str(), len);
-  path[len] = 0;
+  return PostCall(call);
 
-  // FIXME: lc extension then casecompare
+}
 
-  // this just returns a pointer to the original string.
-  // also it includes the period. docs:
-  //
-  // "or the address of the terminating null character otherwise."
-  // so check that case.
+std::string LanguageService::WaitMemoryReport(uint32_t id, uint32_t timeout_ms) {
 
-  char *extension = PathFindExtensionA(path);
-  if (extension && *extension) {
-    extension++;
-    for (auto compare : language_descriptor_.extensions_) {
-      if (!StringUtilities::ICaseCompare(compare, extension)) {
-        return true;
-      }
-    }
-  }
+  // this is only telemetry; if the process is busy, don't interrupt it 
+  // (and don't wait out the cancel grace period). the late response is 
+  // dropped when it arrives.
 
-  return false;
-}
+  BERTBuffers::CallResponse response;
+  WaitResponse(response, id, 0, timeout_ms, nullptr, false);
 
-void LanguageService::Shutdown() {
+  if (response.operation_case() != BERTBuffers::CallResponse::OperationCase::kResult) return "";
+  return response.result().str();
 
-  if (connected_) {
-    BERTBuffers::CallResponse call;
-    BERTBuffers::CallResponse rsp;
+}
 
-    call.set_wait(false);
-    //call.set_control_message("shutdown");
-    call.mutable_function_call()->set_function("shutdown");
-    call.mutable_function_call()->set_target(BERTBuffers::CallTarget::system);
-    Call(rsp, call);
+bool LanguageService::SharedServerRunning() {
 
-    connected_ = false;
-    CloseHandle(pipe_handle_);
-    pipe_handle_ = 0;
-  }
+  // this fails at once if there's no such pipe. if every instance is busy
+  // it times out, but the server is there.
+
+  std::string full_name = "\\\\.\\pipe\\";
+  full_name.append(pipe_name_);
 
-  if (buffer_) delete buffer_;
+  if (WaitNamedPipeA(full_name.c_str(), 1)) return true;
+  return (GetLastError() != ERROR_FILE_NOT_FOUND);
 
 }
 
-void LanguageService::Call(BERTBuffers::CallResponse &response, BERTBuffers::CallResponse &call) {
+void LanguageService::OpenSharedRings() {
 
-  DWORD bytes;
-  uint32_t id = LanguageService::transaction_id();
+  std::string call_ring_name = pipe_name_ + "-RING-C";
+  std::string response_ring_name = pipe_name_ + "-RING-R";
 
-  auto bert = BERT::Instance();
+  if (!call_ring_.Create(call_ring_name, shared_ring_size_) || !response_ring_.Create(response_ring_name, shared_ring_size_)) {
+    DebugOut("failed to create shared rings\n");
+    call_ring_.Close();
+    response_ring_.Close();
+    return;
+  }
 
-  call.set_id(id);
+  // this call is well under the ring threshold, so it goes over the
+  // pipe even though the (unattached) rings are valid on our side.
 
-  std::string framed_message = MessageUtilities::Frame(call);
+  BERTBuffers::CallResponse call, response;
+  call.set_wait(true);
 
-  ResetEvent(io_.hEvent);
-  bool write_result = WriteFile(pipe_handle_, framed_message.c_str(), (int32_t)framed_message.length(), NULL, &io_);
+  auto function_call = call.mutable_function_call();
+  function_call->set_function("shared-ring");
+  function_call->set_target(BERTBuffers::CallTarget::system);
+  function_call->add_arguments()->set_str(call_ring_name);
+  function_call->add_arguments()->set_str(response_ring_name);
 
-  // wait for the write to complete. FIXME: there's no need to wait if we don't need a 
-  // result, but in that case we will need to make sure it's clear before we send another message.
+  Call(response, call);
 
-//  GetOverlappedResultEx(pipe_handle_, &io_, &bytes, INFINITE, false);
-  GetOverlappedResult(pipe_handle_, &io_, &bytes, TRUE);
+  if (response.operation_case() != BERTBuffers::CallResponse::OperationCase::kResult || !response.result().boolean()) {
+    DebugOut("child process did not attach shared rings; using pipe only\n");
+    call_ring_.Close();
+    response_ring_.Close();
+  }
+  else DebugOut("shared rings attached (%llu bytes)\n", shared_ring_size_);
 
-  if (call.wait()) {
+}
 
-    ResetEvent(callback_info_.default_unsignaled_event_);
-    HANDLE handles[2] = { io_.hEvent, callback_info_.default_unsignaled_event_ };
+void LanguageService::EnableStreaming() {
 
-    ResetEvent(io_.hEvent);
-    ReadFile(pipe_handle_, buffer_, PIPE_BUFFER_SIZE, 0, &io_);
+  BERTBuffers::CallResponse call, response;
+  call.set_wait(true);
 
-    std::string message_buffer;
+  auto function_call = call.mutable_function_call();
+  function_call->set_function("stream-results");
+  function_call->set_target(BERTBuffers::CallTarget::system);
+  function_call->add_arguments()->set_integer(stream_chunk_cells_);
 
-    // ::MessageBoxA(0, "Call wait", "CB", MB_OK);
-    Sleep(1000);
+  Call(response, call);
 
-    while (true) {
-      ResetEvent(callback_info_.default_signaled_event_); // set unsignaled
-      DWORD signaled = WaitForMultipleObjectsEx(2, handles, FALSE, INFINITE, FALSE);
-      if (signaled == WAIT_OBJECT_0) {
-
-        // ::MessageBoxA(0, "Call signaled", "CB", MB_OK);
-
-        //DWORD rslt = GetOverlappedResultEx(pipe_handle_, &io_, &bytes, INFINITE, FALSE);
-        DWORD rslt = GetOverlappedResult(pipe_handle_, &io_, &bytes, TRUE);
-        if (rslt) {
-
-          if (message_buffer.length()) {
-            message_buffer.append(buffer_, bytes);
-            if (!MessageUtilities::Unframe(response, message_buffer)) {
-              DebugOut("parse err [2]!\n");
-              response.set_err("parse error (0x10)");
-              break;
-            }
-          }
-          else {
-            if (!MessageUtilities::Unframe(response, buffer_, bytes)) {
-              DebugOut("parse err [1]!\n");
-              response.set_err("parse error (0x11)");
-              break;
-            }
-          }
+  if (response.operation_case() != BERTBuffers::CallResponse::OperationCase::kResult || !response.result().boolean()) {
+    DebugOut("child process does not stream results\n");
+    stream_chunk_cells_ = 0;
+  }
 
-          // check for callback
-          bool complete = false;
-          switch (response.operation_case()) {
-          case BERTBuffers::CallResponse::OperationCase::kFunctionCall: // callback
+}
 
-            // temp, use existing
-            //callback_info_.callback_call_.CopyFrom(response);
-            bert->HandleCallbackOnThread(language_descriptor_.name_, &response);
+void LanguageService::EnableCompression() {
 
-            // write
-            ResetEvent(io_.hEvent);
-            framed_message = MessageUtilities::Frame(callback_info_.callback_response_);
-            WriteFile(pipe_handle_, framed_message.c_str(), (int32_t)framed_message.length(), NULL, &io_);
+  // we can't compress until the other side agrees, so hold the 
+  // threshold until we have a response
 
-            // wait?
-            //GetOverlappedResultEx(pipe_handle_, &io_, &bytes, INFINITE, FALSE);
-            GetOverlappedResult(pipe_handle_, &io_, &bytes, TRUE);
+  uint32_t threshold = compression_threshold_;
+  compression_threshold_ = 0;
 
-            // ok
-            ResetEvent(io_.hEvent);
-            ReadFile(pipe_handle_, buffer_, PIPE_BUFFER_SIZE, 0, &io_);
+  BERTBuffers::CallResponse call, response;
+  call.set_wait(true);
 
-            break;
-          default:
-            complete = true;
-            break;
-          }
+  auto function_call = call.mutable_function_call();
+  function_call->set_function("compression");
+  function_call->set_target(BERTBuffers::CallTarget::system);
+  function_call->add_arguments()->set_integer(threshold);
 
-          if (complete) break;
-        }
-        else {
-          DWORD err = GetLastError();
-          if (err == ERROR_MORE_DATA) {
-            message_buffer.append(buffer_, bytes);
-            ResetEvent(io_.hEvent);
-            ReadFile(pipe_handle_, buffer_, PIPE_BUFFER_SIZE, 0, &io_);
-          }
-          else {
-            std::stringstream ss;
-            ss << "pipe error " << err;
-            response.set_err(ss.str());
-            break;
+  Call(response, call);
+
+  if (response.operation_case() != BERTBuffers::CallResponse::OperationCase::kResult || !response.result().boolean()) {
+    DebugOut("child process does not support compression\n");
+  }
+  else compression_threshold_ = threshold;
+
+}
+
+void LanguageService::SetApplicationPointer(LPDISPATCH application_pointer) {
+
+  // if we haven't started yet, this gets installed when we do
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(start_mutex_);
+    application_pointer_ = application_pointer;
+    if (deferred()) return;
+  }
+
+  BERTBuffers::CallResponse call, response;
+
+  auto function_call = call.mutable_function_call();
+  function_call->set_function("install-application-pointer"); // generic
+  function_call->set_target(BERTBuffers::CallTarget::system);
+  object_map_.DispatchToVariable(function_call->add_arguments(), application_pointer, true);
+
+  Call(response, call);
+
+  for (auto worker : Workers()) worker->SetApplicationPointer(application_pointer);
+}
+
+void LanguageService::OpenCallbackPipe() {
+
+  std::stringstream ss;
+  if (callback_pipe_name_.length()) ss << "\\\\.\\pipe\\" << callback_pipe_name_;
+  else ss << "\\\\.\\pipe\\" << pipe_name_ << "-CB";
+
+  callback_pipe_handle_ = CreateFileA(ss.str().c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, 0);
+  if (!callback_pipe_handle_ || callback_pipe_handle_ == INVALID_HANDLE_VALUE) {
+    DWORD err = GetLastError();
+    DebugOut("err opening pipe [1]: %d\n", err);
+    callback_pipe_handle_ = 0;
+    return;
+  }
+
+  DebugOut("Connected to callback pipe\n");
+
+  DWORD mode = PIPE_READMODE_MESSAGE;
+  BOOL state = SetNamedPipeHandleState(callback_pipe_handle_, &mode, 0, 0);
+
+  memset(&callback_io_, 0, sizeof(callback_io_));
+  callback_io_.hEvent = CreateEvent(0, TRUE, FALSE, 0);
+  ReadFile(callback_pipe_handle_, callback_reader_.read_pointer(), callback_reader_.read_size(), 0, &callback_io_);
+
+  if (!BERT::Instance()->reactor().Add(callback_io_.hEvent, [this]() { CallbackPipeEvent(); })) {
+    std::cerr << language_descriptor_.name_ << ": no room for the callback pipe; callbacks are off for " << pipe_name_ << std::endl;
+    CancelIo(callback_pipe_handle_);
+    CloseHandle(callback_io_.hEvent);
+    CloseHandle(callback_pipe_handle_);
+    callback_io_.hEvent = 0;
+    callback_pipe_handle_ = 0;
+    callback_reader_.Clear();
+  }
+
+}
+
+void LanguageService::CallbackPipeEvent() {
+
+  DWORD bytes = 0;
+
+  ResetEvent(callback_io_.hEvent);
+  //DWORD rslt = GetOverlappedResultEx(callback_pipe_handle_, &callback_io_, &bytes, 0, FALSE);
+  DWORD rslt = GetOverlappedResult(callback_pipe_handle_, &callback_io_, &bytes, FALSE);
+  if (rslt) {
+
+    BERTBuffers::CallResponse &call = callback_info_.callback_call_;
+    BERTBuffers::CallResponse &response = callback_info_.callback_response_;
+
+    call.Clear();
+    response.Clear();
+
+    callback_reader_.Complete(bytes, false);
+    callback_reader_.Parse(call);
+
+    BERT::Instance()->HandleCallback(language_descriptor_.name_);
+    //DumpJSON(response);
+
+    if (call.wait()) {
+      std::string str_response = MessageUtilities::Frame(response);
+      MessageUtilities::CompressFrame(str_response, compression_threshold_);
+      WriteFile(callback_pipe_handle_, str_response.c_str(), (int32_t)str_response.size(), &bytes, &callback_io_);
+      //result = GetOverlappedResultEx(callback_pipe_handle_, &callback_io_, &bytes, INFINITE, FALSE);
+      GetOverlappedResult(callback_pipe_handle_, &callback_io_, &bytes, TRUE);
+    }
+
+    // restart
+    ResetEvent(callback_io_.hEvent);
+    ReadFile(callback_pipe_handle_, callback_reader_.read_pointer(), callback_reader_.read_size(), 0, &callback_io_);
+
+  }
+  else {
+    DWORD err = GetLastError();
+    if (err == ERROR_MORE_DATA) {
+      callback_reader_.Complete(bytes, true);
+      ResetEvent(callback_io_.hEvent);
+      ReadFile(callback_pipe_handle_, callback_reader_.read_pointer(), callback_reader_.read_size(), 0, &callback_io_);
+    }
+    else if (err != ERROR_IO_INCOMPLETE) {
+      DebugOut("ERR in GORE: %d\n", err);
+      CloseCallbackPipe();
+    }
+  }
+
+}
+
+void LanguageService::CloseCallbackPipe() {
+
+  if (!callback_pipe_handle_) return;
+
+  BERT::Instance()->reactor().Remove(callback_io_.hEvent);
+
+  CancelIo(callback_pipe_handle_);
+  CloseHandle(callback_io_.hEvent);
+  CloseHandle(callback_pipe_handle_);
+
+  callback_io_.hEvent = 0;
+  callback_pipe_handle_ = 0;
+  callback_reader_.Clear();
+
+}
+
+int LanguageService::LaunchProcess(HANDLE job_handle, char *command_line) {
+
+  STARTUPINFOA si;
+
+  ZeroMemory(&si, sizeof(si));
+  si.cb = sizeof(si);
+
+  ZeroMemory(&process_info_, sizeof(process_info_));
+
+  int result = 0;
+
+  DWORD creation_flags = CREATE_NO_WINDOW;
+  if (dev_flags_ & 0x01) creation_flags = 0;
+
+  if (!CreateProcessA(0, command_line, 0, 0, FALSE, creation_flags, 0, 0, &si, &process_info_))
+  {
+    DebugOut("CreateProcess failed (%d).\n", GetLastError());
+    result = GetLastError();
+  }
+  else {
+    child_process_id_ = process_info_.dwProcessId;
+    if (job_handle) {
+      if (!AssignProcessToJobObject(job_handle, process_info_.hProcess))
+      {
+        DebugOut("Could not AssignProcessToObject\n");
+      }
+    }
+  }
+
+  return result;
+}
+
+bool LanguageService::ProcessExitCode(DWORD *exit_code) {
+  return GetExitCodeProcess(process_info_.hProcess, exit_code) ? true : false;
+}
+
+void LanguageService::Launch(HANDLE job_handle) {
+
+  io_.hEvent = CreateEvent(0, TRUE, TRUE, 0); // FIXME: clean this up
+  write_io_.hEvent = CreateEvent(0, TRUE, FALSE, 0);
+
+  // auto-reset, so if the pipe isn't there when we wake up we go back 
+  // to waiting (and polling) instead of spinning
+
+  ready_event_ = CreateEventA(0, FALSE, FALSE, APIFunctions::ReadyEventName(pipe_name_).c_str());
+
+  uint64_t start = GetTickCount64();
+
+  if (shared_) {
+
+    // if another instance is starting the server, wait for it to finish 
+    // (it holds the mutex until it connects). then start it if it's not 
+    // there. it's not in our job, so it outlives us. the mutex is in the
+    // session namespace, so other users can't create (or hold) it; if the
+    // same user starts a server from another session, the pipe can only 
+    // have one owner, and the second server exits.
+
+    std::string mutex_name = "Local\\" + pipe_name_ + "-LAUNCH";
+    launch_mutex_ = CreateMutexA(0, FALSE, mutex_name.c_str());
+    if (launch_mutex_) WaitForSingleObject(launch_mutex_, SHARED_LAUNCH_TIMEOUT);
+
+    if (SharedServerRunning()) {
+      DebugOut("%s: using shared server\n", language_descriptor_.name_.c_str());
+      launch_time_ = start;
+    }
+    else if (!StartChildProcess(0)) launch_time_ = start;
+  }
+  else if (!StartChildProcess(job_handle)) launch_time_ = start;
+
+  startup_timing_.spawn = GetTickCount64() - start;
+
+  // start the rest of the pool now as well; they connect in Connect
+
+  for (uint32_t index = 1; index < worker_count_; index++) {
+    auto worker = CreateWorker(index);
+    worker->Launch(job_handle);
+    workers_.push_back(worker);
+  }
+
+}
+
+void LanguageService::Connect() {
+
+  int errs = 0;
+
+  if (launch_time_) {
+
+    std::string full_name = "\\\\.\\pipe\\";
+    full_name.append(pipe_name_);
+
+    // the child creates the pipe and then sets the ready event. if the pipe
+    // exists but all instances are busy, WaitNamedPipe blocks until one is 
+    // available. if it doesn't exist yet, wait on the ready event and the
+    // process handle; that returns as soon as the pipe is there or the 
+    // process exits. the timeout (a short, growing backoff) is a fallback 
+    // for a child that doesn't signal.
+
+    DWORD backoff = 1;
+    DWORD elapsed = 0;
+    HANDLE handles[] = { process_info_.hProcess, ready_event_ };
+
+    while (1) {
+      pipe_handle_ = CreateFileA(full_name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, 0);
+      if (!pipe_handle_ || pipe_handle_ == INVALID_HANDLE_VALUE) {
+
+        DWORD err = GetLastError();
+        errs++;
+
+        if (elapsed >= CHILD_CONNECT_TIMEOUT) {
+          DebugOut("err opening pipe [2]: %d\n", err);
+          break;
+        }
+
+        if (err == ERROR_PIPE_BUSY) {
+          WaitNamedPipeA(full_name.c_str(), CHILD_CONNECT_TIMEOUT - elapsed);
+          elapsed = CHILD_CONNECT_TIMEOUT; // one more try
+          continue;
+        }
+
+        uint64_t wait_start = GetTickCount64();
+        DWORD result = WaitForMultipleObjects(ready_event_ ? 2 : 1, handles, FALSE, backoff);
+
+        if (result == WAIT_OBJECT_0) {
+          DWORD exit_code = 0;
+          GetExitCodeProcess(process_info_.hProcess, &exit_code);
+          std::cerr << "process exited with exit code " << exit_code << std::endl;
+          break;
+        }
+
+        if (result == WAIT_OBJECT_0 + 1) elapsed += (DWORD)(GetTickCount64() - wait_start);
+        else {
+          elapsed += backoff;
+          if (backoff < 64) backoff *= 2;
+        }
+      }
+      else {
+
+        // the shared server's pipe name is well known. the server only 
+        // lets this user connect, but it doesn't stop somebody else from 
+        // creating the name first; so check who we're talking to.
+
+        if (shared_) {
+          ULONG server_process_id = 0;
+          if (!GetNamedPipeServerProcessId(pipe_handle_, &server_process_id) || !APIFunctions::SameUser(server_process_id)) {
+            std::cerr << "shared server (" << server_process_id << ") is not running as this user; not connecting" << std::endl;
+            CloseHandle(pipe_handle_);
+            pipe_handle_ = 0;
+            break;
+          }
+
+          // if we didn't start the shared server, we still want its process
+          // handle (to check health, see healthy)
+
+          if (!process_info_.hProcess) {
+            child_process_id_ = server_process_id;
+            process_info_.hProcess = OpenProcess(SYNCHRONIZE | PROCESS_QUERY_LIMITED_INFORMATION, FALSE, server_process_id);
+          }
+        }
+
+        DWORD mode = PIPE_READMODE_MESSAGE;
+        BOOL state = SetNamedPipeHandleState(pipe_handle_, &mode, 0, 0);
+        connected_ = true;
+
+        startup_timing_.connect = GetTickCount64() - launch_time_ - startup_timing_.spawn;
+        DebugOut("Connected (errs: %d, %d ms)\n", errs, (int)startup_timing_.connect);
+        break;
+      }
+    }
+  }
+
+  if (ready_event_) CloseHandle(ready_event_);
+  ready_event_ = 0;
+
+  if (launch_mutex_) {
+    ReleaseMutex(launch_mutex_);
+    CloseHandle(launch_mutex_);
+    launch_mutex_ = 0;
+  }
+
+  // connect the rest of the pool. if this one didn't connect, there's no
+  // point (we'll be dropped).
+
+  std::vector<std::shared_ptr<LanguageService>> launched;
+  launched.swap(workers_);
+
+  if (connected_) {
+    for (auto worker : launched) {
+      worker->Connect();
+      if (worker->connected()) workers_.push_back(worker);
+      else DebugOut("worker (%s) did not connect\n", worker->pipe_name().c_str());
+    }
+    if (workers_.size()) DebugOut("%s: %d workers\n", language_descriptor_.name_.c_str(), (int)worker_count());
+  }
+
+}
+
+bool LanguageService::EnsureStarted() {
+
+  if (ready_) return connected_;
+
+  // recursive, because starting makes calls (which come back here). 
+  // other threads wait until we're done.
+
+  std::lock_guard<std::recursive_mutex> lock(start_mutex_);
+  if (ready_ || starting_) return connected_;
+
+  starting_ = true;
+  DebugOut("starting %s on first use\n", language_descriptor_.name_.c_str());
+
+  Launch(BERT::Instance()->job_handle());
+  Connect();
+
+  if (connected_) {
+    Initialize();
+    if (application_pointer_) SetApplicationPointer(application_pointer_);
+    for (auto file : pending_files_) ReadSourceFile(file);
+  }
+  else std::cerr << "ERR: language " << language_descriptor_.name_ << " not connected" << std::endl;
+
+  pending_files_.clear();
+  ready_ = true;
+  starting_ = false;
+
+  // if we registered functions from the cache, refresh them now that we
+  // can list them. functions are registered on excel's main thread, which 
+  // may be waiting on us, so ask for that from another thread
+
+  if (connected_ && cached_functions_) BERT::Instance()->async_calls().Post([]() { BERT::Instance()->RequestFunctionUpdate(); });
+
+  return connected_;
+
+}
+
+void LanguageService::LimitReactorHandles(size_t available) {
+
+  size_t needed = reactor_handles();
+  if (available >= needed) return;
+
+  bool standby = standby_enabled_ && available > 1;
+  size_t workers = available - (standby ? 1 : 0);
+  if (workers < 1) workers = 1;
+
+  std::cerr << language_descriptor_.name_ << ": not enough reactor handles for " << worker_count_ << " worker(s)"
+    << (standby_enabled_ ? " and a standby" : "") << "; using " << workers << (standby ? " and a standby" : "") << std::endl;
+
+  worker_count_ = (uint32_t)workers;
+  standby_enabled_ = standby;
+
+}
+
+std::shared_ptr<LanguageService> LanguageService::CreateWorker(uint32_t index) {
+
+  auto worker = std::make_shared<LanguageService>(callback_info_, object_map_, dev_flags_, config_, home_directory_, descriptor_json_);
+
+  std::stringstream ss;
+  ss << pipe_name_ << "-W" << index;
+  worker->pipe_name_ = ss.str();
+  worker->worker_count_ = 1;
+  worker->batch_window_ = 0;
+  worker->lazy_start_ = false;
+  worker->ready_ = true;
+  worker->standby_enabled_ = false;
+  worker->in_process_ = false;
+
+  return worker;
+}
+
+bool LanguageService::healthy() {
+  if (!connected_ || failed_) return false;
+  return (WaitForSingleObject(process_info_.hProcess, 0) != WAIT_OBJECT_0);
+}
+
+LanguageService* LanguageService::SelectWorker(const BERTBuffers::CallResponse &call) {
+
+  std::unique_lock<std::mutex> lock(standby_mutex_, std::defer_lock);
+  if (standby_enabled_) lock.lock();
+
+  // slot 0 is this process (or its replacement). if a slot has failed 
+  // and there's a standby, swap it in.
+
+  size_t count = worker_count();
+  auto worker = [&](size_t index) -> LanguageService* { 
+    LanguageService *candidate = index ? workers_[index - 1].get() : (replacement_ ? replacement_.get() : this);
+    if (standby_ && candidate->failed() && PromoteStandby(index)) candidate = index ? workers_[index - 1].get() : replacement_.get();
+    return candidate;
+  };
+
+  // affinity: same function, same worker (unless it's down, then the next one)
+
+  if (affinity_routing_) {
+    size_t start = std::hash<std::string>()(call.function_call().function()) % count;
+    for (size_t i = 0; i < count; i++) {
+      LanguageService *candidate = worker((start + i) % count);
+      if (candidate->healthy()) return candidate;
+    }
+    return this;
+  }
+
+  // least loaded. start somewhere different each time, so ties rotate.
+
+  size_t start = next_worker_++ % count;
+  LanguageService *selected = 0;
+  uint32_t load = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    LanguageService *candidate = worker((start + i) % count);
+    if (!candidate->healthy()) continue;
+    uint32_t candidate_load = candidate->outstanding_calls_;
+    if (!selected || candidate_load < load) {
+      selected = candidate;
+      load = candidate_load;
+      if (!load) break;
+    }
+  }
+
+  return selected ? selected : this;
+}
+
+void LanguageService::ReadSourceFile(const std::string &file) {
+
+  // not started: hold on to it (once), read it when we start
+
+  {
+    std::lock_guard<std::recursive_mutex> lock(start_mutex_);
+    if (deferred()) {
+      if (std::find(pending_files_.begin(), pending_files_.end(), file) == pending_files_.end()) pending_files_.push_back(file);
+      return;
+    }
+  }
+
+  BERTBuffers::CallResponse call, response;
+  call.set_wait(true); // prevent race
+
+  auto function_call = call.mutable_function_call();
+  function_call->set_function("read-source-file");
+  function_call->set_target(BERTBuffers::CallTarget::system);
+  function_call->add_arguments()->set_str(file);
+  function_call->add_arguments()->set_boolean(true); // notify
+
+  Call(response, call);
+
+  if (host_.available()) host_.Call(response, call);
+
+  for (auto worker : Workers()) worker->ReadSourceFile(file);
+
+  // keep the list for the next standby, and pass it to the current one
+
+  if (standby_enabled_) {
+    std::shared_ptr<LanguageService> standby;
+    {
+      std::lock_guard<std::mutex> lock(standby_mutex_);
+      if (std::find(source_files_.begin(), source_files_.end(), file) == source_files_.end()) source_files_.push_back(file);
+      standby = standby_;
+    }
+    if (standby) standby->ReadSourceFile(file);
+  }
+
+}
+
+void LanguageService::InterpolateString(std::string &str, const std::vector<std::pair<std::string, std::string>> &additional_replacements){
+
+  auto replace_function = [](std::string &haystack, std::string needle, std::string replacement) {
+    for (std::string::size_type i = 0; (i = haystack.find(needle, i)) != std::string::npos;)
+    {
+      haystack.replace(i, needle.length(), replacement);
+      i += replacement.length();
+    }
+  };
+  
+  // NOTE: this is designed for switching x86/x64 R, but we actually
+  // want 64-bit R even with 32-bit Excel; the only reason to do this
+  // would be if you were running on a 32-bit machine, which we don't
+  // ncessarily want to support.
+
+#ifdef _WIN64
+  const char arch[] = "x64";
+#else
+  const char arch[] = "i386";
+#endif
+
+  replace_function(str, "$HOME", language_descriptor_.home_);
+  replace_function(str, "$ARCH", arch);
+  replace_function(str, "$NAME", language_descriptor_.name_);
+
+  for (const auto &pair : additional_replacements) {
+    replace_function(str, pair.first, pair.second);
+  }
+
+}
+
+bool LanguageService::ValidFile(const std::string &file) {
+
+  // path functions can't operate on const strings
+
+  static char path[MAX_PATH];
+
+  size_t len = file.length();
+  if (len > MAX_PATH - 2) len = MAX_PATH - 2;
+  memcpy(path, file.c_str(), len);
+  path[len] = 0;
+
+  // FIXME: lc extension then casecompare
+
+  // this just returns a pointer to the original string.
+  // also it includes the period. docs:
+  //
+  // "or the address of the terminating null character otherwise."
+  // so check that case.
+
+  char *extension = PathFindExtensionA(path);
+  if (extension && *extension) {
+    extension++;
+    for (auto compare : language_descriptor_.extensions_) {
+      if (!StringUtilities::ICaseCompare(compare, extension)) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+void LanguageService::Shutdown() {
+
+  // lazy and never started, nothing to clean up
+
+  if (deferred()) return;
+
+  // stop forwarding to a replacement, and stop making standbys. these 
+  // processes go down with the rest.
+
+  std::vector<std::shared_ptr<LanguageService>> spares;
+  if (standby_enabled_) {
+    std::lock_guard<std::mutex> lock(standby_mutex_);
+    standby_enabled_ = false;
+    if (standby_) spares.push_back(standby_);
+    if (replacement_) spares.push_back(replacement_);
+    spares.insert(spares.end(), retired_.begin(), retired_.end());
+  }
+  for (auto spare : spares) spare->Shutdown();
+
+  // a standby that's still starting sees the flag and shuts itself down
+
+  if (standby_thread_.joinable()) standby_thread_.join();
+
+  if (host_.available()) {
+    DebugOut("%s %s\n", language_descriptor_.name_.c_str(), host_.Report().c_str());
+    host_.Shutdown();
+  }
+
+  // anything waiting in the batcher goes out now (and fails, below)
+
+  batcher_.Stop();
+
+  // async calls still pending won't get a response now. failing them 
+  // also ends the async reader task, if there is one.
+
+  FailAsyncCalls("language shut down");
+
+  // a shared server keeps running for other clients. it sees the pipe 
+  // close, and releases our environment.
+
+  if (connected_ && shared_) {
+    connected_ = false;
+    CloseHandle(pipe_handle_);
+    pipe_handle_ = 0;
+  }
+
+  if (connected_) {
+    BERTBuffers::CallResponse call;
+    BERTBuffers::CallResponse rsp;
+
+    call.set_wait(false);
+    //call.set_control_message("shutdown");
+    call.mutable_function_call()->set_function("shutdown");
+    call.mutable_function_call()->set_target(BERTBuffers::CallTarget::system);
+    Call(rsp, call);
+
+    connected_ = false;
+    CloseHandle(pipe_handle_);
+    pipe_handle_ = 0;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(management_mutex_);
+    if (management_pipe_handle_) CloseHandle(management_pipe_handle_);
+    management_pipe_handle_ = 0;
+  }
+
+  call_ring_.Close();
+  response_ring_.Close();
+
+  BERT::Instance()->reactor().Post([this]() { CloseCallbackPipe(); });
+
+  for (auto worker : workers_) worker->Shutdown();
+
+}
+
+void LanguageService::WriteFrame(const std::string &framed_message) {
+
+  // one writer at a time; reads use a separate overlapped struct, so 
+  // a write can go out while a read is pending.
+
+  std::lock_guard<std::mutex> lock(write_mutex_);
+
+  DWORD bytes;
+  ResetEvent(write_io_.hEvent);
+  WriteFile(pipe_handle_, framed_message.c_str(), (int32_t)framed_message.length(), NULL, &write_io_);
+  if (!GetOverlappedResult(pipe_handle_, &write_io_, &bytes, TRUE)) failed_ = true;
+
+}
+
+uint32_t LanguageService::PostCall(BERTBuffers::CallResponse &call) {
+
+  uint32_t id = LanguageService::transaction_id();
+  call.set_id(id);
+
+  std::string frame = MessageUtilities::Frame(call, &call_ring_);
+  MessageUtilities::CompressFrame(frame, compression_threshold_);
+  WriteFrame(frame);
+  MessageUtilities::ReleaseFrameBuffer(frame);
+  return id;
+
+}
+
+bool LanguageService::TakePendingResponse(BERTBuffers::CallResponse &response, uint32_t id) {
+  auto iter = pending_responses_.find(id);
+  if (iter == pending_responses_.end()) return false;
+  response.Swap(&(iter->second));
+  pending_responses_.erase(iter);
+  return true;
+}
+
+void LanguageService::CancelCall(uint32_t id) {
+
+  BERTBuffers::CallResponse call;
+  auto function_call = call.mutable_function_call();
+  function_call->set_function("cancel");
+  function_call->add_arguments()->set_integer(id);
+  function_call->add_arguments()->set_integer(_getpid()); // ids are per client (shared server)
+
+  std::string frame = MessageUtilities::Frame(call);
+  std::lock_guard<std::mutex> lock(management_mutex_);
+
+  if (!management_pipe_handle_) {
+    std::string full_name = "\\\\.\\pipe\\";
+    full_name.append(pipe_name_);
+    full_name.append("-M");
+
+    management_pipe_handle_ = CreateFileA(full_name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+    if (!management_pipe_handle_ || management_pipe_handle_ == INVALID_HANDLE_VALUE) {
+      DebugOut("err opening management pipe: %d\n", GetLastError());
+      management_pipe_handle_ = 0;
+    }
+    else {
+      DWORD mode = PIPE_READMODE_MESSAGE;
+      SetNamedPipeHandleState(management_pipe_handle_, &mode, 0, 0);
+    }
+  }
+
+  if (management_pipe_handle_) {
+    DWORD bytes;
+    if (!WriteFile(management_pipe_handle_, frame.c_str(), (DWORD)frame.length(), &bytes, 0)) {
+      DebugOut("err writing management pipe: %d\n", GetLastError());
+      CloseHandle(management_pipe_handle_);
+      management_pipe_handle_ = 0; // try again next time
+    }
+  }
+
+  MessageUtilities::ReleaseFrameBuffer(frame);
+
+}
+
+bool LanguageService::PollCancel(CallWait &wait) {
+
+  uint64_t now = GetTickCount64();
+
+  if (!wait.cancelled) {
+    bool expired = wait.deadline && now >= wait.deadline;
+    if (expired || (wait.abort && wait.abort())) {
+      wait.reason = expired ? "call timed out" : "call cancelled";
+      if (wait.abandon) return true;
+      DebugOut("cancel call %u (%s)\n", wait.id, expired ? "timeout" : "abort");
+      wait.cancelled = now;
+      CancelCall(wait.id);
+    }
+    return false;
+  }
+
+  return (now - wait.cancelled >= CANCEL_GRACE_PERIOD);
+
+}
+
+bool LanguageService::CancelRead() {
+  DWORD bytes;
+  CancelIoEx(pipe_handle_, &io_);
+  if (GetOverlappedResult(pipe_handle_, &io_, &bytes, TRUE)) return false;
+  return (GetLastError() == ERROR_OPERATION_ABORTED);
+}
+
+void LanguageService::WaitResponse(BERTBuffers::CallResponse &response, uint32_t id, ResultStream *stream, uint32_t timeout_ms, AbortCheck abort, bool cancel) {
+
+  CallWait wait = { id, timeout_ms ? GetTickCount64() + timeout_ms : 0, abort, 0, 0, BERT::Instance()->on_main_thread(), !cancel };
+
+  // if we're on the main thread, we have to handle callbacks while we
+  // wait, even if another thread is reading (see ReadResponses). 
+
+  bool polling = (wait.deadline || wait.abort || wait.callbacks);
+  if (wait.callbacks) ResetEvent(callback_info_.default_signaled_event_); // blocked
+
+  // if another thread is reading, wait for it to either deliver our
+  // response or give up the pipe. otherwise we become the reader.
+
+  {
+    std::unique_lock<std::mutex> lock(pending_mutex_);
+    while (true) {
+      if (TakePendingResponse(response, id)) return;
+      if (!reader_active_) break;
+      if (!polling) pending_condition_.wait(lock);
+      else {
+        pending_condition_.wait_for(lock, std::chrono::milliseconds(CALL_POLL_INTERVAL));
+        lock.unlock();
+        if (wait.callbacks && WaitForSingleObject(callback_info_.default_unsignaled_event_, 0) == WAIT_OBJECT_0) {
+          ResetEvent(callback_info_.default_unsignaled_event_);
+          BERT::Instance()->HandleCallbackOnThread(language_descriptor_.name_);
+          SetEvent(callback_info_.default_signaled_event_); // signal callback thread
+          ResetEvent(callback_info_.default_signaled_event_); // still blocked
+        }
+        bool give_up = PollCancel(wait);
+        lock.lock();
+        if (give_up) {
+          if (!TakePendingResponse(response, id)) {
+            abandoned_calls_.insert(id);
+            response.set_err(wait.reason);
+          }
+          return;
+        }
+      }
+    }
+    reader_active_ = true;
+  }
+
+  ReadResponses(response, wait, stream);
+
+  // if there are async calls waiting, somebody has to keep reading
+
+  bool handoff = false;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    reader_active_ = false;
+    handoff = !async_pending_.empty() && !async_reader_;
+    if (handoff) async_reader_ = true;
+  }
+  pending_condition_.notify_all();
+
+  if (handoff) BERT::Instance()->async_calls().Post([this]() { ReadAsyncResponses(); });
+
+}
+
+void LanguageService::ReadResponses(BERTBuffers::CallResponse &response, CallWait &wait, ResultStream *stream) {
+
+  DWORD bytes;
+  auto bert = BERT::Instance();
+  bool streaming = false;
+  uint32_t id = wait.id;
+
+  // we poll even if this call has no timeout, for async call timeouts. 
+  // id 0 means we're reading for async calls only (ReadAsyncResponses).
+
+  DWORD interval = CALL_POLL_INTERVAL;
+
+  // callbacks have to run on excel's main thread. off the main thread 
+  // (multithreaded recalc) we only wait on the pipe, and we leave the 
+  // callback events alone; those describe the main thread.
+
+  HANDLE handles[2] = { io_.hEvent, callback_info_.default_unsignaled_event_ };
+  DWORD handle_count = wait.callbacks ? 2 : 1;
+  if (wait.callbacks) ResetEvent(callback_info_.default_unsignaled_event_);
+
+  ResetEvent(io_.hEvent);
+  ReadFile(pipe_handle_, reader_.read_pointer(), reader_.read_size(), 0, &io_);
+
+  while (true) {
+    if (wait.callbacks) ResetEvent(callback_info_.default_signaled_event_); // set unsignaled
+    DWORD signaled = WaitForMultipleObjectsEx(handle_count, handles, FALSE, interval, FALSE);
+    if (signaled == WAIT_OBJECT_0) {
+
+      DWORD rslt = GetOverlappedResult(pipe_handle_, &io_, &bytes, TRUE);
+      if (rslt) {
+
+        BERTBuffers::CallResponse message;
+
+        reader_.Complete(bytes, false);
+        if (!reader_.Parse(message, &response_ring_)) {
+          DebugOut("parse err [1]!\n");
+          response.set_err("parse error (0x11)");
+          break;
+        }
+
+        bool more = (reader_.flags() & FRAME_FLAG_STREAM) != 0;
+        bool ours = (message.id() == id || message.id() == 0);
+        bool hold = false; // part of a streamed response, nothing to deliver yet
+
+        if (ours && stream && (more || streaming)) {
+
+          // streamed result for a caller that can take it in pieces
+
+          if (!streaming) {
+            stream->Begin(message.result().arr());
+            response.Swap(&message);
+            streaming = true;
+          }
+          else stream->Append(message.result().arr());
+
+          if (!more) {
+            stream->End();
+            break;
+          }
+          hold = true;
+
+        }
+        else {
+
+          // streamed, but nobody is taking pieces: assemble. the first 
+          // frame is the header, the rest are data. once it's complete 
+          // it's handled like any other response.
+
+          auto partial = partial_responses_.find(message.id());
+          if (partial == partial_responses_.end()) {
+            if (more) {
+              partial_responses_[message.id()].Swap(&message);
+              hold = true;
+            }
+          }
+          else {
+            auto data = partial->second.mutable_result()->mutable_arr()->mutable_data();
+            auto chunk = message.mutable_result()->mutable_arr()->mutable_data();
+            data->Reserve(data->size() + chunk->size());
+            for (auto &element : *chunk) data->Add()->Swap(&element);
+
+            if (more) hold = true;
+            else {
+              message.Swap(&(partial->second));
+              partial_responses_.erase(partial);
+            }
+          }
+        }
+
+        if (hold) {}
+        else if (message.operation_case() == BERTBuffers::CallResponse::OperationCase::kFunctionCall) {
+
+          // callback. we can only run these on the main thread.
+
+          BERTBuffers::CallResponse callback_response;
+          if (wait.callbacks) bert->HandleCallbackOnThread(language_descriptor_.name_, &message, &callback_response);
+          else {
+            callback_response.set_id(message.id());
+            callback_response.set_err("callbacks are not supported in thread-safe or async functions");
+          }
+          std::string frame = MessageUtilities::Frame(callback_response);
+          MessageUtilities::CompressFrame(frame, compression_threshold_);
+          WriteFrame(frame);
+          MessageUtilities::ReleaseFrameBuffer(frame);
+
+        }
+        else if (message.id() == id || message.id() == 0) {
+
+          // ours. id 0 means the other side didn't echo the id, in which
+          // case we have to assume lock-step (old behavior).
+
+          response.Swap(&message);
+          break;
+
+        }
+        else {
+
+          // some other caller's response. an async call gets it directly;
+          // otherwise stash it and wake any waiters. if nobody is waiting 
+          // any more (abandoned), drop it.
+
+          AsyncCompletion completion;
+          bool drained = false;
+          {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            auto async_call = async_pending_.find(message.id());
+            if (async_call != async_pending_.end()) {
+              completion = std::move(async_call->second.completion);
+              async_pending_.erase(async_call);
+              drained = (!id && async_pending_.empty());
+            }
+            else if (!abandoned_calls_.erase(message.id())) pending_responses_[message.id()].Swap(&message);
           }
+          if (completion) CompleteAsync(completion, message);
+          else pending_condition_.notify_all();
+
+          if (drained) break;
+
+        }
+
+        ResetEvent(io_.hEvent);
+        ReadFile(pipe_handle_, reader_.read_pointer(), reader_.read_size(), 0, &io_);
+
+      }
+      else {
+        DWORD err = GetLastError();
+        if (err == ERROR_MORE_DATA) {
+          reader_.Complete(bytes, true);
+          ResetEvent(io_.hEvent);
+          ReadFile(pipe_handle_, reader_.read_pointer(), reader_.read_size(), 0, &io_);
+        }
+        else {
+          std::stringstream ss;
+          ss << "pipe error " << err;
+          response.set_err(ss.str());
+          failed_ = true;
+          break;
+        }
+      }
+    }
+    else if (signaled == WAIT_TIMEOUT) {
+
+      PollAsyncCalls();
+
+      // reading for async calls only: stop when they're done. otherwise
+      // check our call. we can't stop partway through a streamed result 
+      // (the stream already has part of it), so in that case keep reading.
+
+      if (!id) {
+        bool drained;
+        {
+          std::lock_guard<std::mutex> lock(pending_mutex_);
+          drained = async_pending_.empty();
         }
+        if (drained && CancelRead()) break;
+      }
+      else if (!streaming && PollCancel(wait) && CancelRead()) {
+        DebugOut("abandon call %u\n", id);
+        partial_responses_.erase(id);
+        {
+          std::lock_guard<std::mutex> lock(pending_mutex_);
+          abandoned_calls_.insert(id);
+        }
+        response.set_err(wait.reason);
+        break;
+      }
+    }
+    else {
+      ResetEvent(callback_info_.default_unsignaled_event_);
+      DebugOut("other handle signaled, do something\n");
+      bert->HandleCallbackOnThread(language_descriptor_.name_);
+      SetEvent(callback_info_.default_signaled_event_); // signal callback thread
+    }
+  }
+
+}
+
+void LanguageService::Call(BERTBuffers::CallResponse &response, BERTBuffers::CallResponse &call, ResultStream *stream, AbortCheck abort) {
+
+  if (!EnsureStarted()) {
+    response.set_err("language not available");
+    return;
+  }
+
+  bool function_call = (call.operation_case() == BERTBuffers::CallResponse::OperationCase::kFunctionCall
+    && call.function_call().target() != BERTBuffers::CallTarget::system);
+
+  // waited calls to thread-safe functions can run in-process. if the 
+  // host can't take it, it goes to the process as usual.
+
+  if (function_call && host_.available() && call.wait()
+    && (call.function_call().flags() & FUNCTION_FLAG_THREAD_SAFE)
+    && !(call.function_call().flags() & FUNCTION_FLAG_BATCH)
+    && host_.Call(response, call)) return;
+
+  // function calls can go to any worker in the pool. anything else 
+  // goes to this process, or its replacement if it failed.
+
+  if (function_call && (workers_.size() || standby_enabled_)) {
+    LanguageService *worker = SelectWorker(call);
+    if (worker != this) {
+      worker->Call(response, call, stream, abort);
+      return;
+    }
+  }
+  else if (!function_call) {
+    LanguageService *primary = Primary();
+    if (primary != this) {
+      primary->Call(response, call, stream, abort);
+      return;
+    }
+  }
+
+  // the child process enforces the timeout as well, so it holds even if
+  // nobody is waiting (or the cancel is lost).
+
+  uint32_t timeout = 0;
+  if (function_call && call_timeout_) {
+    timeout = call_timeout_;
+    call.set_timeout(timeout);
+  }
+
+  outstanding_calls_++;
+
+  uint32_t id = PostCall(call);
+  if (call.wait()) WaitResponse(response, id, stream, timeout, abort);
+  if (BERT::Instance()->on_main_thread()) SetEvent(callback_info_.default_signaled_event_); // default signaled
+
+  outstanding_calls_--;
+
+}
+
+void LanguageService::CallAsync(BERTBuffers::CallResponse &call, AsyncCompletion completion) {
+  if (!EnsureStarted()) {
+    BERTBuffers::CallResponse response;
+    response.set_err("language not available");
+    completion(response);
+  }
+  else if (batcher_.running()) batcher_.Submit(call, completion);
+  else PostAsync(call, completion);
+}
+
+void LanguageService::PostAsync(BERTBuffers::CallResponse &call, AsyncCompletion completion) {
+
+  if (workers_.size() || standby_enabled_) {
+    LanguageService *worker = SelectWorker(call);
+    if (worker != this) {
+      worker->PostAsync(call, completion);
+      return;
+    }
+  }
+
+  uint32_t timeout = call_timeout_;
+  if (timeout) call.set_timeout(timeout);
+
+  outstanding_calls_++;
+  call.set_wait(true);
+  uint32_t id = PostCall(call);
+
+  // register the call so the reader can complete it. the response may 
+  // already be here (stashed by another reader); and if nobody is 
+  // reading, start the async reader.
+
+  BERTBuffers::CallResponse response;
+  bool arrived = false;
+  bool start_reader = false;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    if (TakePendingResponse(response, id)) arrived = true;
+    else {
+      AsyncCall &async_call = async_pending_[id];
+      async_call.completion = completion;
+      async_call.wait = { id, timeout ? GetTickCount64() + timeout : 0, nullptr, 0, 0, false };
+      if (!reader_active_ && !async_reader_) start_reader = async_reader_ = true;
+    }
+  }
+
+  if (arrived) CompleteAsync(completion, response);
+  if (start_reader) BERT::Instance()->async_calls().Post([this]() { ReadAsyncResponses(); });
+
+}
+
+void LanguageService::ReadAsyncResponses() {
+
+  while (true) {
+    {
+      std::lock_guard<std::mutex> lock(pending_mutex_);
+      if (async_pending_.empty() || reader_active_) {
+        async_reader_ = false; // done, or another thread is reading (and hands back when it's done)
+        return;
+      }
+      reader_active_ = true;
+    }
+
+    if (!failed_) {
+      BERTBuffers::CallResponse response;
+      CallWait wait = { 0, 0, nullptr, 0, 0, false };
+      ReadResponses(response, wait, 0);
+    }
+    if (failed_) FailAsyncCalls("pipe error");
+
+    {
+      std::lock_guard<std::mutex> lock(pending_mutex_);
+      reader_active_ = false;
+    }
+    pending_condition_.notify_all();
+  }
+
+}
+
+void LanguageService::PollAsyncCalls() {
+
+  std::vector<uint32_t> cancel;
+  std::vector<AsyncCompletion> expired;
+  uint64_t now = GetTickCount64();
+
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    for (auto iter = async_pending_.begin(); iter != async_pending_.end(); ) {
+      CallWait &wait = iter->second.wait;
+      if (wait.deadline && !wait.cancelled && now >= wait.deadline) {
+        wait.cancelled = now;
+        cancel.push_back(iter->first);
       }
-      else if( signaled != WAIT_TIMEOUT) {
-        ResetEvent(callback_info_.default_unsignaled_event_);
-        DebugOut("other handle signaled, do something\n");
-        bert->HandleCallbackOnThread(language_descriptor_.name_);
-        SetEvent(callback_info_.default_signaled_event_); // signal callback thread
+      else if (wait.cancelled && now - wait.cancelled >= CANCEL_GRACE_PERIOD) {
+        DebugOut("abandon async call %u\n", iter->first);
+        abandoned_calls_.insert(iter->first);
+        expired.push_back(std::move(iter->second.completion));
+        iter = async_pending_.erase(iter);
+        continue;
       }
+      ++iter;
+    }
+  }
+
+  for (auto id : cancel) {
+    DebugOut("cancel async call %u (timeout)\n", id);
+    CancelCall(id);
+  }
+
+  for (auto &completion : expired) {
+    BERTBuffers::CallResponse response;
+    response.set_err("call timed out");
+    CompleteAsync(completion, response);
+  }
+
+}
+
+void LanguageService::CompleteAsync(AsyncCompletion completion, BERTBuffers::CallResponse &response) {
+  auto result = std::make_shared<BERTBuffers::CallResponse>();
+  result->Swap(&response);
+  outstanding_calls_--;
+  BERT::Instance()->async_calls().Post([completion, result]() { completion(*result); });
+}
+
+void LanguageService::FailAsyncCalls(const char *reason) {
+
+  std::vector<AsyncCompletion> completions;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    for (auto &entry : async_pending_) {
+      abandoned_calls_.insert(entry.first);
+      completions.push_back(std::move(entry.second.completion));
     }
+    async_pending_.clear();
+  }
 
+  for (auto &completion : completions) {
+    BERTBuffers::CallResponse response;
+    response.set_err(reason);
+    CompleteAsync(completion, response);
   }
-  SetEvent(callback_info_.default_signaled_event_); // default signaled
 
 }
 
@@ -685,8 +1900,59 @@ FUNCTION_LIST LanguageService::CreateFunctionList(const BERTBuffers::CallRespons
 
 }
 
+std::string LanguageService::FunctionCachePath() {
+  std::stringstream ss;
+  ss << home_directory_ << "\\cache\\" << language_descriptor_.name_ << "-functions.pb";
+  return ss.str();
+}
+
+bool LanguageService::ReadFunctionCache(BERTBuffers::CallResponse &response) {
+  std::ifstream file(FunctionCachePath(), std::ios::in | std::ios::binary);
+  if (!file.good()) return false;
+  return response.ParseFromIstream(&file) && response.operation_case() == BERTBuffers::CallResponse::kFunctionList;
+}
+
+void LanguageService::WriteFunctionCache(const BERTBuffers::CallResponse &response) {
+
+  // other excel instances may be reading or writing the same file, so 
+  // write a temp file and rename it into place
+
+  std::string directory = home_directory_ + "\\cache";
+  CreateDirectoryA(directory.c_str(), 0);
+
+  std::string path = FunctionCachePath();
+  std::stringstream temp;
+  temp << path << "." << GetCurrentProcessId();
+
+  {
+    std::ofstream file(temp.str(), std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file.good() || !response.SerializeToOstream(&file)) {
+      DebugOut("%s: can't write function cache\n", language_descriptor_.name_.c_str());
+      return;
+    }
+  }
+
+  if (!MoveFileExA(temp.str().c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) DeleteFileA(temp.str().c_str());
+
+}
+
 FUNCTION_LIST LanguageService::MapLanguageFunctions(uint32_t key, std::shared_ptr<LanguageService> language_service) {
 
+  // a lazy language that hasn't started: register the functions it had 
+  // last time, so a cell calling one starts it (see EnsureStarted). if 
+  // there's no list yet (first run, or the cache was removed), start it 
+  // now, the same as without lazy start, so there is one next time.
+
+  if (deferred()) {
+    BERTBuffers::CallResponse cached;
+    if (ReadFunctionCache(cached)) {
+      DebugOut("%s: registering %d functions from cache\n", language_descriptor_.name_.c_str(), cached.function_list().functions_size());
+      cached_functions_ = true;
+      return LanguageService::CreateFunctionList(cached, key, name(), language_service);
+    }
+    EnsureStarted();
+  }
+
   if (!connected_) return {}; 
 
   BERTBuffers::CallResponse call;
@@ -696,8 +1962,16 @@ FUNCTION_LIST LanguageService::MapLanguageFunctions(uint32_t key, std::shared_pt
   call.mutable_function_call()->set_target(BERTBuffers::CallTarget::system);
   call.set_wait(true);
 
+  uint64_t start = GetTickCount64();
   Call(response, call);
-  
+  startup_timing_.list_functions = GetTickCount64() - start;
+
+  DebugOut("%s startup: spawn %d, connect %d, initialize %d, list functions %d (ms)\n", 
+    language_descriptor_.name_.c_str(), (int)startup_timing_.spawn, (int)startup_timing_.connect, 
+    (int)startup_timing_.initialize, (int)startup_timing_.list_functions);
+
+  if (lazy_start_ && response.operation_case() == BERTBuffers::CallResponse::kFunctionList) WriteFunctionCache(response);
+
   return LanguageService::CreateFunctionList(response, key, name(), language_service);
 
 }
@@ -718,6 +1992,8 @@ int LanguageService::StartChildProcess(HANDLE job_handle) {
 
   std::stringstream command;
   command << "\"" << child_path_ << "\" -p " << pipe_name_ << " " << arguments;
+  if (shared_) command << " -s";
+  if (language_descriptor_.sysimage_path_.length()) command << " -i \"" << language_descriptor_.sysimage_path_ << "\"";
 
   // construct shell command and launch process
   size_t len = command.str().length();
@@ -427,7 +427,7 @@ comments, and save your work often. \n\n""");
 
   end
 
-end
+end # module BERT
 
 using Main.BERT.EXCEL;
 
@@ -0,0 +1,83 @@
+#
+# Copyright (c) 2017-2018 Structured Data, LLC
+# 
+# This file is part of BERT.
+#
+# BERT is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# BERT is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+#
+# builds a custom system image for ControlJulia. the image contains the 
+# BERT module (from the startup file), any packages listed on the command 
+# line, and code compiled by a short workload, so the first spreadsheet 
+# call doesn't have to wait for the jit. run this with the julia you use 
+# with BERT (the image only works with that build):
+#
+#   julia build-sysimage.jl [package ...]
+#
+# the image is written next to this script, as bert-julia-<version>.dll,
+# which is where bert-languages.json looks for it. if the image is not 
+# there, ControlJulia uses the default image. rebuild after updating 
+# julia, the startup file, or the packages.
+#
+
+const julia_bindir = isdefined(Sys, :BINDIR) ? Sys.BINDIR : JULIA_HOME
+const version_tag = string(VERSION.major, ".", VERSION.minor)
+
+const sysimage_directory = dirname(abspath(@__FILE__))
+const startup_file = joinpath(dirname(sysimage_directory), "startup", "startup-$(version_tag).jl")
+const sysimage_path = joinpath(sysimage_directory, "bert-julia-$(version_tag)")
+
+if !isfile(startup_file)
+  error("startup file not found: $(startup_file)")
+end
+
+packages = ARGS
+
+# the userimg file is included into Main at the end of the system image
+# build. include the startup file (that defines the BERT module), load 
+# packages, then run the workload. the workload is wrapped so that a 
+# failure there doesn't break the build.
+
+userimg = IOBuffer()
+println(userimg, "include(", repr(startup_file), ")")
+for package in packages
+  println(userimg, "using ", package)
+end
+print(userimg, """
+try
+  BERT.ListFunctions()
+  for value in Any[1, 1.5, "text", true, nothing, [1, 2, 3], [1.5 2.5; 3.5 4.5], Any[1, "a", false]]
+    show(IOBuffer(), MIME("text/plain"), value)
+    string(value)
+  end
+  Dict{String, Any}("a" => 1, "b" => [1.0, 2.0])
+catch err
+  println("sysimage workload failed: ", err)
+end
+""")
+
+userimg_path = joinpath(sysimage_directory, "userimg.jl")
+open(userimg_path, "w") do f
+  write(f, take!(userimg))
+end
+
+# build_sysimg ships with julia (in share/julia). it adds the platform 
+# extension (.dll) to the output path.
+
+include(joinpath(julia_bindir, Base.DATAROOTDIR, "julia", "build_sysimg.jl"))
+build_sysimg(sysimage_path, "native", userimg_path; force=true)
+
+rm(userimg_path)
+println("wrote image: $(sysimage_path)")
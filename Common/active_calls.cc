@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "active_calls.h"
+
+#include <chrono>
+
+uint64_t ActiveCalls::Now() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ActiveCalls::Enter(uint32_t id, uint32_t timeout_ms, uint32_t client) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  calls_.push_back({ id, client, timeout_ms ? Now() + timeout_ms : 0, false });
+}
+
+bool ActiveCalls::Leave(uint32_t id, uint32_t client) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (auto iter = calls_.rbegin(); iter != calls_.rend(); iter++) {
+    if (iter->id == id && iter->client == client) {
+      calls_.erase(std::next(iter).base());
+      break;
+    }
+  }
+  if (calls_.empty() || !calls_.back().cancel) return false;
+  calls_.back().cancel = false;
+  return true;
+}
+
+bool ActiveCalls::Active(uint32_t id, uint32_t client) {
+  if (!id) return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &entry : calls_) {
+    if (entry.id == id && entry.client == client) return true;
+  }
+  return false;
+}
+
+bool ActiveCalls::Cancel(uint32_t id, uint32_t client) {
+  if (!id) return false;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < calls_.size(); i++) {
+    if (calls_[i].id == id && calls_[i].client == client) {
+      if (i == calls_.size() - 1) return true;
+      calls_[i].cancel = true;
+      return false;
+    }
+  }
+  return false;
+}
+
+bool ActiveCalls::Running(uint32_t client) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return calls_.empty() || calls_.back().client == client;
+}
+
+uint32_t ActiveCalls::Expired() {
+  uint64_t now = Now();
+  uint32_t id = 0;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t i = 0; i < calls_.size(); i++) {
+    Entry &entry = calls_[i];
+    if (entry.deadline && entry.deadline <= now) {
+      entry.deadline = 0; // report once
+      if (i == calls_.size() - 1) id = entry.id;
+      else entry.cancel = true;
+    }
+  }
+  return id;
+}
+
+int64_t ActiveCalls::NextTimeout() {
+  uint64_t now = Now();
+  int64_t timeout = -1;
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &entry : calls_) {
+    if (!entry.deadline) continue;
+    int64_t remaining = entry.deadline > now ? (int64_t)(entry.deadline - now) : 0;
+    if (timeout < 0 || remaining < timeout) timeout = remaining;
+  }
+  return timeout;
+}
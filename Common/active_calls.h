@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <stdint.h>
+
+/**
+ * calls the child process is running, with optional deadlines. the 
+ * dispatch loop adds calls as it starts them and removes them when they
+ * finish; the management thread checks ids for targeted cancellation and
+ * polls for expired deadlines. calls can nest (callbacks), so this is a 
+ * stack. thread safe.
+ *
+ * ids are assigned by each client, so in a shared server they're only 
+ * unique with the client (0 if there's only one). an interrupt only stops
+ * the innermost call, so cancelling a call further down the stack waits
+ * until the calls above it return (see Cancel and Leave).
+ */
+class ActiveCalls {
+
+protected:
+  typedef struct {
+    uint32_t id;
+    uint32_t client;
+    uint64_t deadline; // 0 = none
+    bool cancel;       // cancelled, waiting for the calls above it
+  }
+  Entry;
+
+public:
+
+  /** a call is starting. timeout is in milliseconds, 0 for none */
+  void Enter(uint32_t id, uint32_t timeout_ms, uint32_t client = 0);
+
+  /** 
+   * a call finished (or failed). returns true if the call that's now 
+   * innermost was cancelled while it was covered; interrupt it now.
+   */
+  bool Leave(uint32_t id, uint32_t client = 0);
+
+  /** 
+   * check if the call is running, at any depth. id 0 is never active (we 
+   * don't use it for transactions).
+   */
+  bool Active(uint32_t id, uint32_t client = 0);
+
+  /** 
+   * cancel a call. returns true if it's the innermost call, so interrupt 
+   * now; otherwise it's marked, and Leave reports it when it's uncovered. 
+   * false if the call isn't running.
+   */
+  bool Cancel(uint32_t id, uint32_t client = 0);
+
+  /** 
+   * true if the innermost call belongs to this client, or there are no
+   * calls (the interrupt would go to whatever the console is running).
+   */
+  bool Running(uint32_t client);
+
+  /**
+   * check for calls past their deadline. each expired call is reported 
+   * once, like Cancel: returns its id if it's innermost (interrupt now), 
+   * or 0.
+   */
+  uint32_t Expired();
+
+  /**
+   * milliseconds until the next deadline (0 if something is overdue), 
+   * or -1 if there are no deadlines.
+   */
+  int64_t NextTimeout();
+
+  /** monotonic clock in milliseconds */
+  static uint64_t Now();
+
+private:
+  std::mutex mutex_;
+  std::vector<Entry> calls_;
+
+};
@@ -0,0 +1,240 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pipe.h"
+#include "event_loop.h"
+#include "timer_wheel.h"
+#include "message_utilities.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+/**
+ * call and connect latency, before and after the loops went event driven.
+ *
+ * connect: a server starts listening after a delay (a child starting up),
+ * and the client either retries on a fixed 100 ms sleep, as Connect used 
+ * to, or waits for a ready signal and connects at once. reports the time 
+ * from listening to connected.
+ *
+ * call: a trivial function call to a stand-in child, whose dispatch loop
+ * runs on the event loop and a timer wheel (with a periodic tick, like 
+ * ControlR's). the client either waits for the response to be readable, 
+ * or sleeps one second first, as LanguageService::Call used to.
+ *
+ * usage: call_latency_benchmark [iterations-scale]
+ */
+
+#define BENCHMARK_PIPE_NAME     "bert-latency-benchmark"
+#define CONNECT_RETRY_MS        100
+#define CHILD_TICK_MS           100
+#define FIXED_SLEEP_MS          1000
+
+typedef std::chrono::steady_clock Clock;
+
+static double Microseconds(Clock::time_point start, Clock::time_point end) {
+  return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+static void Report(const char *label, std::vector<double> &samples) {
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (auto sample : samples) total += sample;
+  std::cout << label << ": "
+    << (total / samples.size()) << " us mean, "
+    << samples[samples.size() / 2] << " us median, "
+    << samples.back() << " us max" << std::endl;
+}
+
+/** write everything queued, including a part-sent last message */
+static void Flush(Pipe &pipe) {
+  pipe.NextWrite();
+  while (pipe.writing() && !pipe.error()) {
+    struct pollfd pfd = { pipe.wait_handle_write(), POLLOUT, 0 };
+    while (poll(&pfd, 1, -1) < 0 && errno == EINTR);
+    pipe.NextWrite();
+  }
+}
+
+/** the ready event: set once the server is listening */
+class ReadySignal {
+public:
+  void Set() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready_ = true;
+    condition_.notify_all();
+  }
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return ready_; });
+  }
+private:
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool ready_ = false;
+};
+
+static bool Connect(bool polling, int trials) {
+
+  std::vector<double> samples;
+
+  for (int i = 0; i < trials; i++) {
+
+    Pipe server;
+    Pipe client;
+    ReadySignal ready;
+    Clock::time_point listening;
+    bool started = false;
+
+    // vary the startup delay so it doesn't line up with the retry interval
+
+    std::thread child([&] {
+      std::this_thread::sleep_for(std::chrono::milliseconds(20 + (i * 37) % CONNECT_RETRY_MS));
+      listening = Clock::now();
+      started = !server.Start(BENCHMARK_PIPE_NAME, false);
+      ready.Set();
+    });
+
+    if (polling) {
+      while (client.Open(BENCHMARK_PIPE_NAME)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(CONNECT_RETRY_MS));
+      }
+    }
+    else {
+      ready.Wait();
+      if (started) client.Open(BENCHMARK_PIPE_NAME);
+    }
+
+    Clock::time_point connected = Clock::now();
+    child.join();
+
+    if (!started || !client.connected()) return false;
+    samples.push_back(Microseconds(listening, connected));
+  }
+
+  Report(polling ? "connect (100 ms polling)" : "connect (ready signal)", samples);
+  return true;
+}
+
+/** stand-in child: return twice the argument */
+static void ChildLoop(Pipe *server) {
+
+  EventLoop loop;
+  TimerWheel timers;
+  bool done = false;
+  uint64_t ticks = 0;
+
+  timers.Schedule(CHILD_TICK_MS, [&ticks] { ticks++; }, CHILD_TICK_MS);
+
+  server->Connect();
+  loop.Add(server->wait_handle_read(), EPOLLIN, [&](uint32_t events) {
+    while (!done) {
+      DWORD result = server->ReadMessage(false);
+      if (result == WAIT_TIMEOUT || result == ERROR_MORE_DATA) return;
+      BERTBuffers::CallResponse call, response;
+      if (result || !server->ParseMessage(call)) {
+        done = true;
+        return;
+      }
+      response.set_id(call.id());
+      response.mutable_result()->set_real(call.function_call().arguments(0).real() * 2);
+      server->PushWrite(MessageUtilities::Frame(response));
+      Flush(*server);
+    }
+  });
+
+  while (!done) {
+    timers.Advance();
+    if (loop.RunOnce((int)timers.NextTimeout()) < 0) break;
+  }
+}
+
+static bool Call(Pipe &client, bool fixed_sleep, int iterations) {
+
+  std::vector<double> samples;
+
+  BERTBuffers::CallResponse call, response;
+  call.set_wait(true);
+  call.mutable_function_call()->set_function("Twice");
+  call.mutable_function_call()->add_arguments()->set_real(21);
+
+  for (int i = 0; i < iterations; i++) {
+
+    call.set_id(i + 1);
+    auto start = Clock::now();
+
+    client.PushWrite(MessageUtilities::Frame(call));
+    Flush(client);
+
+    if (fixed_sleep) std::this_thread::sleep_for(std::chrono::milliseconds(FIXED_SLEEP_MS));
+
+    DWORD result;
+    while ((result = client.ReadMessage(true)) == WAIT_TIMEOUT || result == ERROR_MORE_DATA);
+    if (result || !client.ParseMessage(response) || response.id() != call.id() || response.result().real() != 42) return false;
+
+    samples.push_back(Microseconds(start, Clock::now()));
+  }
+
+  Report(fixed_sleep ? "call (fixed 1 s sleep)" : "call (event driven)", samples);
+  return true;
+}
+
+int main(int argc, char **argv) {
+
+  int scale = argc > 1 ? atoi(argv[1]) : 1;
+  if (scale < 1) scale = 1;
+
+  char directory[] = "/tmp/bert-benchmark-XXXXXX";
+  if (!mkdtemp(directory)) {
+    std::cerr << "mkdtemp failed" << std::endl;
+    return 1;
+  }
+  setenv("BERT_PIPE_DIR", directory, 1);
+
+  bool ok = Connect(true, 10 * scale) && Connect(false, 10 * scale);
+
+  if (ok) {
+    Pipe server;
+    Pipe client;
+
+    if (server.Start(BENCHMARK_PIPE_NAME, false) || client.Open(BENCHMARK_PIPE_NAME)) {
+      std::cerr << "pipe setup failed" << std::endl;
+      ok = false;
+    }
+    else {
+      std::thread child(ChildLoop, &server);
+      ok = Call(client, false, 10000 * scale) && Call(client, true, 3);
+      client.Reset(); // the child sees the hangup and stops
+      child.join();
+    }
+  }
+
+  rmdir(directory);
+  return ok ? 0 : 1;
+}
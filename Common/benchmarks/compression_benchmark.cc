@@ -0,0 +1,107 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "message_utilities.h"
+#include "lz_codec.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <random>
+
+/**
+ * frame compression benchmark. frames a large result, compresses it with
+ * CompressFrame and unframes it again (which decompresses), and reports 
+ * the ratio and throughput (uncompressed bytes) for each step. the second
+ * case is random data, which should be left alone quickly.
+ *
+ * usage: compression_benchmark [iterations]
+ */
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool Run(const char *label, const BERTBuffers::CallResponse &message, int iterations) {
+
+  std::string frame = MessageUtilities::Frame(message);
+  size_t original = frame.length();
+
+  double compress_seconds = 0, unframe_seconds = 0;
+  bool compressed = false;
+  std::string working;
+
+  for (int i = 0; i < iterations; i++) {
+
+    working = frame;
+    auto start = std::chrono::steady_clock::now();
+    compressed = MessageUtilities::CompressFrame(working);
+    compress_seconds += Seconds(start);
+
+    BERTBuffers::CallResponse parsed;
+    start = std::chrono::steady_clock::now();
+    bool result = MessageUtilities::Unframe(parsed, working);
+    unframe_seconds += Seconds(start);
+
+    if (!result || parsed.id() != message.id()) {
+      std::cerr << label << ": round trip failed" << std::endl;
+      return false;
+    }
+  }
+
+  double megabytes = (double)original * iterations / (1024 * 1024);
+
+  std::cout << label << ": " << original << " -> " << working.length() << " bytes";
+  if (compressed) std::cout << " (" << ((double)original / working.length()) << "x)";
+  else std::cout << " (not compressed)";
+  std::cout << ", compress " << (megabytes / compress_seconds) << " MB/s"
+    << ", unframe " << (megabytes / unframe_seconds) << " MB/s" << std::endl;
+
+  return true;
+}
+
+int main(int argc, char **argv) {
+
+  int iterations = argc > 1 ? atoi(argv[1]) : 20;
+  if (iterations < 1) iterations = 1;
+
+  // 1M-element numeric array with a repeating pattern, like a filled-down
+  // column or a sequence
+
+  BERTBuffers::CallResponse repeated;
+  repeated.set_id(1);
+  auto arr = repeated.mutable_result()->mutable_arr();
+  arr->set_rows(1000000);
+  arr->set_cols(1);
+  for (int i = 0; i < 1000000; i++) arr->add_data()->set_real((double)(i % 100));
+
+  BERTBuffers::CallResponse random;
+  random.set_id(2);
+  arr = random.mutable_result()->mutable_arr();
+  arr->set_rows(1000000);
+  arr->set_cols(1);
+  std::mt19937_64 generator(42);
+  std::uniform_real_distribution<double> distribution;
+  for (int i = 0; i < 1000000; i++) arr->add_data()->set_real(distribution(generator));
+
+  bool ok = Run("repeated numeric", repeated, iterations) 
+    && Run("random numeric", random, iterations);
+
+  return ok ? 0 : 1;
+}
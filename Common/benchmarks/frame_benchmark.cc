@@ -0,0 +1,131 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "message_utilities.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+/**
+ * frame serialization benchmark (v2 header, pooled buffers). compares
+ * Frame() with the original stream-based framing, for three typical 
+ * messages. reports throughput (framed bytes) and heap allocations per 
+ * frame. each frame goes back to the pool after it's "written", as Pipe 
+ * does.
+ *
+ * usage: frame_benchmark [iterations-scale]
+ */
+
+static uint64_t allocations = 0;
+
+void *operator new(size_t size) {
+  allocations++;
+  void *pointer = malloc(size ? size : 1);
+  if (!pointer) throw std::bad_alloc();
+  return pointer;
+}
+
+void operator delete(void *pointer) noexcept { free(pointer); }
+void operator delete(void *pointer, size_t) noexcept { free(pointer); }
+
+/** the framing we used before v2: stringstream, v1 prefix, str() copy */
+static std::string StreamFrame(const google::protobuf::Message &message) {
+  int32_t bytes = (int32_t)message.ByteSizeLong();
+  std::stringstream stream;
+  stream.write(reinterpret_cast<char*>(&bytes), sizeof(int32_t));
+  message.SerializeToOstream(dynamic_cast<std::ostream*>(&stream));
+  return stream.str();
+}
+
+typedef std::string(*FrameFunction)(const google::protobuf::Message &message);
+
+static std::string PooledFrame(const google::protobuf::Message &message) {
+  return MessageUtilities::Frame(message);
+}
+
+static void Run(const char *label, const google::protobuf::Message &message, int iterations) {
+
+  FrameFunction functions[] = { StreamFrame, PooledFrame };
+  const char *names[] = { "stream", "pooled" };
+
+  for (int f = 0; f < 2; f++) {
+
+    uint64_t bytes = 0;
+    uint64_t check = 0;
+
+    // warm up (fills the pool)
+    for (int i = 0; i < 16; i++) {
+      std::string frame = functions[f](message);
+      MessageUtilities::ReleaseFrameBuffer(frame);
+    }
+
+    uint64_t start_allocations = allocations;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < iterations; i++) {
+      std::string frame = functions[f](message);
+      bytes += frame.length();
+      check += (uint8_t)frame[frame.length() - 1];
+      MessageUtilities::ReleaseFrameBuffer(frame);
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t count = allocations - start_allocations;
+
+    std::cout << label << " (" << names[f] << "): "
+      << (bytes / seconds / (1024 * 1024)) << " MB/s, "
+      << ((double)count / iterations) << " allocs/frame"
+      << " [" << (check & 0xff) << "]" << std::endl;
+  }
+}
+
+int main(int argc, char **argv) {
+
+  int scale = argc > 1 ? atoi(argv[1]) : 1;
+  if (scale < 1) scale = 1;
+
+  BERTBuffers::CallResponse console_line;
+  console_line.set_id(1);
+  console_line.mutable_console()->set_text("[1] 0.8414710 0.9092974 0.1411200 -0.7568025 -0.9589243\n");
+
+  BERTBuffers::CallResponse polyline;
+  polyline.set_id(2);
+  auto graphics = polyline.mutable_console()->mutable_graphics();
+  graphics->set_command("polyline");
+  graphics->set_device_type("svg");
+  for (int i = 0; i < 1000; i++) {
+    graphics->add_x(i * 0.5);
+    graphics->add_y(100.0 + (i % 37) * 1.25);
+  }
+
+  BERTBuffers::CallResponse result;
+  result.set_id(3);
+  auto arr = result.mutable_result()->mutable_arr();
+  arr->set_rows(10000);
+  arr->set_cols(10);
+  for (int i = 0; i < 100000; i++) arr->add_data()->set_real(i * 0.001);
+
+  Run("console line", console_line, 1000000 * scale);
+  Run("graphics polyline", polyline, 20000 * scale);
+  Run("100K-cell result", result, 100 * scale);
+
+  return 0;
+}
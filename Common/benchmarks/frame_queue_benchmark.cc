@@ -0,0 +1,118 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "frame_queue.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+/**
+ * bounded queue benchmark. pushes a lot of console text, and then a 
+ * plotting loop, through a small drop-policy queue with a consumer that 
+ * only takes one frame in every few pushes (a slow reader). checks that
+ * the queue stays near its limit and reports throughput and queue stats.
+ *
+ * usage: frame_queue_benchmark [megabytes]
+ */
+
+#define QUEUE_LIMIT       1024
+#define CONSUMER_INTERVAL 8
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static std::string Marker(uint64_t dropped_bytes) {
+  std::stringstream ss;
+  ss << "[output truncated: " << dropped_bytes << " bytes]\n";
+  return ss.str();
+}
+
+int main(int argc, char **argv) {
+
+  int megabytes = argc > 1 ? atoi(argv[1]) : 5;
+  if (megabytes < 1) megabytes = 1;
+
+  bool ok = true;
+
+  {
+    FrameQueue queue;
+    queue.SetLimit(QUEUE_LIMIT, QUEUE_POLICY_DROP);
+    queue.set_marker(Marker);
+
+    std::string line = "[1] 0.8414710 0.9092974 0.1411200 -0.7568025 -0.9589243\n";
+    uint64_t target = (uint64_t)megabytes * 1024 * 1024, pushed = 0;
+    size_t frames = 0;
+    std::string frame;
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (pushed < target) {
+      queue.Push(line, FRAME_CLASS_TEXT);
+      pushed += line.length();
+      if (++frames % CONSUMER_INTERVAL == 0 && queue.size()) queue.PopFront(frame);
+    }
+
+    double seconds = Seconds(start);
+    std::cout << "text: " << frames << " frames, " << (frames / seconds / 1e6) << " M frames/s; "
+      << queue.Stats() << std::endl;
+
+    if (queue.high_water_bytes() > QUEUE_LIMIT + line.length() * 2) {
+      std::cerr << "text: high water " << queue.high_water_bytes() << " over the limit" << std::endl;
+      ok = false;
+    }
+  }
+
+  {
+    // a plotting loop: each page is a new-page frame and 100 drawing 
+    // commands on the same device, and only the last page matters
+
+    FrameQueue queue;
+    queue.SetLimit(QUEUE_LIMIT * 64, QUEUE_POLICY_DROP);
+    queue.set_marker(Marker);
+
+    std::string page(64, 'p'), command(256, 'g');
+    size_t frames = 0, pages = 2000 * (size_t)megabytes;
+    std::string frame;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (size_t i = 0; i < pages; i++) {
+      queue.Push(page, FRAME_CLASS_PAGE, 1);
+      for (int j = 0; j < 100; j++) {
+        queue.Push(command, FRAME_CLASS_GRAPHICS, 1);
+        if (++frames % CONSUMER_INTERVAL == 0 && queue.size()) queue.PopFront(frame);
+      }
+    }
+
+    double seconds = Seconds(start);
+    std::cout << "graphics: " << frames << " frames, " << (frames / seconds / 1e6) << " M frames/s; "
+      << queue.Stats() << std::endl;
+
+    if (queue.bytes() > QUEUE_LIMIT * 64) {
+      std::cerr << "graphics: queue over the limit" << std::endl;
+      ok = false;
+    }
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pipe.h"
+#include "message_utilities.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/**
+ * in-process vs. out-of-process calls. the same trivial function call 
+ * goes to a stand-in evaluator either through the in-process host 
+ * contract (serialized CallResponse in and out, under the host lock; see
+ * rhost_api.h) or over a pipe to a child process, as the control process
+ * does. reports calls per second for each. R isn't involved, so this is 
+ * the overhead each path adds to a call.
+ *
+ * usage: host_call_benchmark [iterations-scale]
+ */
+
+#define BENCHMARK_PIPE_NAME "bert-host-benchmark"
+
+/** stand-in for the R call: return twice the argument */
+static void Evaluate(BERTBuffers::CallResponse &response, const BERTBuffers::CallResponse &call) {
+  response.set_id(call.id());
+  response.mutable_result()->set_real(call.function_call().arguments(0).real() * 2);
+}
+
+static std::mutex host_mutex;
+
+/** same contract (and work) as RHostCall */
+static int32_t HostCall(const char *call_data, uint32_t call_length, char **response_data, uint32_t *response_length) {
+
+  BERTBuffers::CallResponse call, response;
+  if (!call.ParseFromArray(call_data, call_length)) return -1;
+
+  {
+    std::lock_guard<std::mutex> lock(host_mutex);
+    Evaluate(response, call);
+  }
+
+  uint32_t length = (uint32_t)response.ByteSizeLong();
+  char *data = new char[length ? length : 1];
+  response.SerializeWithCachedSizesToArray(reinterpret_cast<google::protobuf::uint8*>(data));
+
+  *response_data = data;
+  *response_length = length;
+  return 0;
+}
+
+/** write everything queued, including a part-sent last message */
+static void Flush(Pipe &pipe) {
+  pipe.NextWrite();
+  while (pipe.writing() && !pipe.error()) {
+    struct pollfd pfd = { pipe.wait_handle_write(), POLLOUT, 0 };
+    while (poll(&pfd, 1, -1) < 0 && errno == EINTR);
+    pipe.NextWrite();
+  }
+}
+
+/** read one message, blocking */
+static bool Receive(Pipe &pipe, BERTBuffers::CallResponse &message) {
+  DWORD result;
+  while ((result = pipe.ReadMessage(true)) == WAIT_TIMEOUT || result == ERROR_MORE_DATA);
+  return !result && pipe.ParseMessage(message);
+}
+
+/** child process: serve calls until BERT goes away */
+static void ChildMain() {
+  Pipe server;
+  if (server.Start(BENCHMARK_PIPE_NAME, true)) _exit(1);
+  server.Connect();
+  BERTBuffers::CallResponse call, response;
+  while (Receive(server, call)) {
+    response.Clear();
+    Evaluate(response, call);
+    server.PushWrite(MessageUtilities::Frame(response));
+    Flush(server);
+  }
+  _exit(0);
+}
+
+static void Report(const char *label, int iterations, std::chrono::steady_clock::time_point start) {
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cout << label << ": " << (iterations / seconds) << " calls/s, " 
+    << (seconds * 1000000 / iterations) << " us/call" << std::endl;
+}
+
+static bool InProcess(BERTBuffers::CallResponse &call, int iterations) {
+
+  BERTBuffers::CallResponse response;
+  std::string data;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+
+    call.set_id(i + 1);
+    call.SerializeToString(&data);
+
+    char *response_data;
+    uint32_t response_length;
+    if (HostCall(data.c_str(), (uint32_t)data.length(), &response_data, &response_length)) return false;
+    bool result = response.ParseFromArray(response_data, response_length);
+    delete[] response_data;
+
+    if (!result || response.id() != call.id() || response.result().real() != 42) return false;
+  }
+  Report("in-process", iterations, start);
+  return true;
+}
+
+static bool OutOfProcess(BERTBuffers::CallResponse &call, int iterations) {
+
+  std::cout.flush();
+  pid_t pid = fork();
+  if (pid < 0) return false;
+  if (!pid) ChildMain();
+
+  bool ok = false;
+
+  {
+    // the child is listening once it's started; retry until then
+
+    Pipe client;
+    for (int i = 0; i < 1000 && client.Open(BENCHMARK_PIPE_NAME); i++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    if (client.connected()) {
+      BERTBuffers::CallResponse response;
+      auto start = std::chrono::steady_clock::now();
+      int i = 0;
+      for (; i < iterations; i++) {
+        call.set_id(i + 1);
+        client.PushWrite(MessageUtilities::Frame(call));
+        Flush(client);
+        if (!Receive(client, response) || response.id() != call.id() || response.result().real() != 42) break;
+      }
+      ok = (i == iterations);
+      if (ok) Report("out-of-process (pipe)", iterations, start);
+    }
+  }
+
+  // closing the client ends the child; make sure, if we never connected
+
+  if (!ok) kill(pid, SIGKILL);
+  waitpid(pid, 0, 0);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+
+  int scale = argc > 1 ? atoi(argv[1]) : 1;
+  if (scale < 1) scale = 1;
+
+  char directory[] = "/tmp/bert-benchmark-XXXXXX";
+  if (!mkdtemp(directory)) {
+    std::cerr << "mkdtemp failed" << std::endl;
+    return 1;
+  }
+  setenv("BERT_PIPE_DIR", directory, 1);
+
+  BERTBuffers::CallResponse call;
+  call.set_wait(true);
+  call.mutable_function_call()->set_function("Twice");
+  call.mutable_function_call()->add_arguments()->set_real(21);
+
+  bool ok = InProcess(call, 1000000 * scale) && OutOfProcess(call, 50000 * scale);
+
+  rmdir(directory);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,146 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pipe.h"
+#include "shared_ring.h"
+#include "message_utilities.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+#include <unistd.h>
+
+/**
+ * pipe vs. shared ring benchmark. sends large results (1, 16 and 128 MB 
+ * of real cells) from a server pipe to a client over loopback, once as a
+ * regular frame and once through a shared ring, where only the descriptor
+ * goes over the pipe. each message is framed, sent, reassembled and 
+ * parsed; reports time per message and throughput (message bytes). both
+ * ends are in this process, so we pump writes and reads in turn.
+ *
+ * usage: shared_ring_benchmark [iterations-scale]
+ */
+
+#define BENCHMARK_PIPE_NAME "bert-ring-benchmark"
+
+/** room for two of the largest message, so the ring never falls back */
+#define RING_CAPACITY (288ull * 1024 * 1024)
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/** pump writes on one side and reads on the other until a message is complete */
+static bool Transfer(Pipe &writer, Pipe &reader) {
+  while (true) {
+    writer.NextWrite();
+    DWORD result = reader.ReadMessage(false);
+    if (result == 0) return true;
+    if (result != WAIT_TIMEOUT && result != ERROR_MORE_DATA) return false;
+  }
+}
+
+static bool Run(Pipe &server, Pipe &client, SharedRing &producer, SharedRing &consumer, uint32_t megabytes, int iterations) {
+
+  BERTBuffers::CallResponse message;
+  message.set_id(megabytes);
+  auto arr = message.mutable_result()->mutable_arr();
+
+  // a real cell is 11 bytes on the wire
+
+  size_t cells = (size_t)megabytes * 1024 * 1024 / 11;
+  arr->set_rows((int32_t)cells);
+  arr->set_cols(1);
+  for (size_t i = 0; i < cells; i++) arr->add_data()->set_real(i * 0.001);
+
+  size_t bytes = message.ByteSizeLong();
+  const char *names[] = { "pipe", "ring" };
+
+  for (int r = 0; r < 2; r++) {
+
+    SharedRing *ring = r ? &producer : 0;
+    double seconds = 0;
+
+    for (int i = 0; i < iterations; i++) {
+
+      BERTBuffers::CallResponse received;
+      auto start = std::chrono::steady_clock::now();
+
+      std::string frame = ring ? MessageUtilities::Frame(message, ring) : MessageUtilities::Frame(message);
+      server.PushWrite(frame);
+      if (!Transfer(server, client) || !client.ParseMessage(received, &consumer)) {
+        std::cerr << "transfer failed" << std::endl;
+        return false;
+      }
+
+      seconds += Seconds(start);
+      if (received.id() != message.id() || received.result().arr().data_size() != arr->data_size()) {
+        std::cerr << "message mismatch" << std::endl;
+        return false;
+      }
+    }
+
+    std::cout << megabytes << " MB result (" << names[r] << "): "
+      << (seconds * 1000 / iterations) << " ms/message, "
+      << ((double)bytes * iterations / seconds / (1024 * 1024)) << " MB/s" << std::endl;
+  }
+
+  return true;
+}
+
+int main(int argc, char **argv) {
+
+  int scale = argc > 1 ? atoi(argv[1]) : 1;
+  if (scale < 1) scale = 1;
+
+  char directory[] = "/tmp/bert-benchmark-XXXXXX";
+  if (!mkdtemp(directory)) {
+    std::cerr << "mkdtemp failed" << std::endl;
+    return 1;
+  }
+  setenv("BERT_PIPE_DIR", directory, 1);
+
+  std::string ring_name = "bert-ring-benchmark-" + std::to_string(getpid());
+
+  bool ok = false;
+
+  {
+    Pipe server;
+    Pipe client;
+    SharedRing producer;
+    SharedRing consumer;
+
+    if (server.Start(BENCHMARK_PIPE_NAME, false) || client.Open(BENCHMARK_PIPE_NAME)) {
+      std::cerr << "pipe setup failed" << std::endl;
+    }
+    else if (!producer.Create(ring_name, RING_CAPACITY) || !consumer.Open(ring_name)) {
+      std::cerr << "ring setup failed" << std::endl;
+    }
+    else {
+      server.Connect();
+      ok = Run(server, client, producer, consumer, 1, 50 * scale)
+        && Run(server, client, producer, consumer, 16, 8 * scale)
+        && Run(server, client, producer, consumer, 128, 2 * scale);
+    }
+  }
+
+  rmdir(directory);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+#
+# Copyright (c) 2017-2018 Structured Data, LLC
+# 
+# This file is part of BERT.
+#
+# BERT is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# BERT is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+#
+
+#
+# sysimage benchmark. starts julia with the default image and with the 
+# BERT image (see Build/sysimage/build-sysimage.jl), and times each step
+# of getting to the first spreadsheet call:
+#
+#   process:  start julia and exit, with nothing to run
+#   startup:  define the BERT module (included from the startup file with
+#             the default image; it's already in the custom image)
+#   first:    the first call (list functions, then show and convert a 
+#             few values), which is where the jit compiles
+#   second:   the same call again, for reference
+#
+# times are the median of several runs, in milliseconds. run it with the
+# julia you built the image with:
+#
+#   julia sysimage_benchmark.jl [image [runs]]
+#
+# the image defaults to the one build-sysimage.jl writes.
+#
+
+const julia_bindir = isdefined(Sys, :BINDIR) ? Sys.BINDIR : JULIA_HOME
+const julia_path = joinpath(julia_bindir, Base.julia_exename())
+const version_tag = string(VERSION.major, ".", VERSION.minor)
+
+const build_directory = joinpath(dirname(dirname(dirname(abspath(@__FILE__)))), "Build")
+const startup_file = joinpath(build_directory, "startup", "startup-$(version_tag).jl")
+
+image = length(ARGS) > 0 ? ARGS[1] : joinpath(build_directory, "sysimage", "bert-julia-$(version_tag).dll")
+runs = length(ARGS) > 1 ? parse(Int, ARGS[2]) : 5
+
+if !isfile(startup_file)
+  error("startup file not found: $(startup_file)")
+end
+if !isfile(image)
+  error("image not found: $(image) (run build-sysimage.jl first)")
+end
+
+read_output(command) = VERSION < v"0.7.0-" ? readstring(command) : read(command, String)
+
+median_of(values) = sort(values)[div(length(values) + 1, 2)]
+
+elapsed_ms(start) = (time_ns() - start) / 1e6
+
+# runs in the child. prints "benchmark name milliseconds" lines; anything
+# else (the startup file prints a banner) is ignored
+
+const workload = """
+start = time_ns()
+isdefined(Main, :BERT) || include($(repr(startup_file)))
+startup_ms = (time_ns() - start) / 1e6
+function spreadsheet_call()
+  BERT.ListFunctions()
+  for value in Any[1.5, "text", [1, 2, 3], [1.5 2.5; 3.5 4.5], Any[1, "a", false]]
+    show(IOBuffer(), MIME("text/plain"), value)
+    string(value)
+  end
+end
+start = time_ns()
+spreadsheet_call()
+first_ms = (time_ns() - start) / 1e6
+start = time_ns()
+spreadsheet_call()
+second_ms = (time_ns() - start) / 1e6
+println("benchmark startup ", startup_ms)
+println("benchmark first ", first_ms)
+println("benchmark second ", second_ms)
+"""
+
+function measure(label, image_arguments)
+
+  times = Dict{String, Vector{Float64}}()
+
+  for i in 1:runs
+
+    start = time_ns()
+    read_output(`$(julia_path) $(image_arguments) --startup-file=no -e nothing`)
+    push!(get!(times, "process", Float64[]), elapsed_ms(start))
+
+    output = read_output(`$(julia_path) $(image_arguments) --startup-file=no -e $(workload)`)
+    for line in split(strip(output), "\n")
+      fields = split(strip(line))
+      if length(fields) == 3 && fields[1] == "benchmark"
+        push!(get!(times, String(fields[2]), Float64[]), parse(Float64, fields[3]))
+      end
+    end
+
+  end
+
+  print(rpad(label, 9))
+  for name in ["process", "startup", "first", "second"]
+    haskey(times, name) && print("  ", name, " ", round(Int, 10 * median_of(times[name])) / 10, " ms")
+  end
+  println()
+
+end
+
+measure("default", ``)
+measure("custom", `-J $(image)`)
@@ -0,0 +1,175 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pipe.h"
+#include "event_loop.h"
+#include "message_utilities.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+/**
+ * loopback benchmark for the posix transport. an echo server runs on its
+ * own thread, driven by the event loop, as a control process would be; 
+ * the client sends a message, blocks until the echo comes back, and 
+ * parses it. reports round-trip latency for small messages (console 
+ * lines) and throughput for large results (bytes in both directions).
+ *
+ * usage: transport_benchmark [iterations-scale]
+ */
+
+#define BENCHMARK_PIPE_NAME "bert-transport-benchmark"
+
+/** 
+ * write everything queued. WaitWrites only waits for the queue, and the 
+ * last message can still be part-sent; the other side needs all of it.
+ */
+static void Flush(Pipe &pipe) {
+  pipe.NextWrite();
+  while (pipe.writing() && !pipe.error()) {
+    struct pollfd pfd = { pipe.wait_handle_write(), POLLOUT, 0 };
+    while (poll(&pfd, 1, -1) < 0 && errno == EINTR);
+    pipe.NextWrite();
+  }
+}
+
+/** echo every message until the client goes away */
+static void EchoServer(Pipe *server) {
+
+  EventLoop loop;
+  bool done = false;
+
+  server->Connect();
+  loop.Add(server->wait_handle_read(), EPOLLIN, [&](uint32_t events) {
+    while (!done) {
+      DWORD result = server->ReadMessage(false);
+      if (result == WAIT_TIMEOUT || result == ERROR_MORE_DATA) return;
+      BERTBuffers::CallResponse message;
+      if (result || !server->ParseMessage(message)) {
+        done = true;
+        return;
+      }
+      server->PushWrite(MessageUtilities::Frame(message));
+      Flush(*server);
+    }
+  });
+
+  while (!done && loop.RunOnce(-1) >= 0);
+}
+
+/** send and wait for the echo. returns false if the transport failed */
+static bool RoundTrip(Pipe &client, const BERTBuffers::CallResponse &message, BERTBuffers::CallResponse &echo) {
+  client.PushWrite(MessageUtilities::Frame(message));
+  Flush(client);
+  while (true) {
+    DWORD result = client.ReadMessage(true);
+    if (result == 0) return client.ParseMessage(echo) && echo.id() == message.id();
+    if (result != WAIT_TIMEOUT && result != ERROR_MORE_DATA) return false;
+  }
+}
+
+static bool Latency(Pipe &client, int iterations) {
+
+  BERTBuffers::CallResponse message, echo;
+  message.mutable_console()->set_text("[1] 0.8414710 0.9092974 0.1411200 -0.7568025 -0.9589243\n");
+
+  std::vector<double> samples;
+  samples.reserve(iterations);
+
+  for (int i = 0; i < iterations; i++) {
+    message.set_id(i + 1);
+    auto start = std::chrono::steady_clock::now();
+    if (!RoundTrip(client, message, echo)) return false;
+    samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+  }
+
+  std::sort(samples.begin(), samples.end());
+  double total = 0;
+  for (auto sample : samples) total += sample;
+
+  std::cout << "console line round trip: " 
+    << (total / iterations) << " us mean, "
+    << samples[iterations / 2] << " us median, "
+    << samples[iterations * 99 / 100] << " us p99" << std::endl;
+
+  return true;
+}
+
+static bool Throughput(Pipe &client, uint32_t megabytes, int iterations) {
+
+  BERTBuffers::CallResponse message, echo;
+  message.mutable_result()->set_str(std::string((size_t)megabytes * 1024 * 1024, 'x'));
+  size_t bytes = MessageUtilities::Frame(message).length();
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < iterations; i++) {
+    message.set_id(i + 1);
+    if (!RoundTrip(client, message, echo)) return false;
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << megabytes << " MB round trip: "
+    << (seconds * 1000 / iterations) << " ms, "
+    << ((double)bytes * 2 * iterations / seconds / (1024 * 1024)) << " MB/s" << std::endl;
+
+  return true;
+}
+
+int main(int argc, char **argv) {
+
+  int scale = argc > 1 ? atoi(argv[1]) : 1;
+  if (scale < 1) scale = 1;
+
+  char directory[] = "/tmp/bert-benchmark-XXXXXX";
+  if (!mkdtemp(directory)) {
+    std::cerr << "mkdtemp failed" << std::endl;
+    return 1;
+  }
+  setenv("BERT_PIPE_DIR", directory, 1);
+
+  bool ok = false;
+
+  {
+    Pipe server;
+    Pipe client;
+
+    if (server.Start(BENCHMARK_PIPE_NAME, false) || client.Open(BENCHMARK_PIPE_NAME)) {
+      std::cerr << "pipe setup failed" << std::endl;
+    }
+    else {
+      std::thread echo(EchoServer, &server);
+      ok = Latency(client, 20000 * scale)
+        && Throughput(client, 1, 200 * scale)
+        && Throughput(client, 16, 20 * scale);
+      client.Reset(); // the server sees the hangup and stops
+      echo.join();
+    }
+  }
+
+  rmdir(directory);
+  return ok ? 0 : 1;
+}
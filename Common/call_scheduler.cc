@@ -0,0 +1,178 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "call_scheduler.h"
+
+#include <chrono>
+#include <sstream>
+#include <cstring>
+
+static const char *class_names[SCHEDULE_CLASS_COUNT] = { "interactive", "recalc", "background", "housekeeping" };
+
+uint64_t CallScheduler::Now() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+CallScheduler::CallScheduler()
+  : size_(0)
+  , fair_(false)
+{
+  weights_[SCHEDULE_INTERACTIVE] = SCHEDULE_WEIGHT_INTERACTIVE;
+  weights_[SCHEDULE_RECALC] = SCHEDULE_WEIGHT_RECALC;
+  weights_[SCHEDULE_BACKGROUND] = SCHEDULE_WEIGHT_BACKGROUND;
+  weights_[SCHEDULE_HOUSEKEEPING] = SCHEDULE_WEIGHT_HOUSEKEEPING;
+  memcpy(credits_, weights_, sizeof(credits_));
+  memset(stats_, 0, sizeof(stats_));
+  for (int i = 0; i < SCHEDULE_CLASS_COUNT; i++) last_pipe_[i] = -1;
+}
+
+void CallScheduler::set_weight(ScheduleClass schedule_class, uint32_t weight) {
+  weights_[schedule_class] = weight ? weight : 1;
+  if (credits_[schedule_class] > weights_[schedule_class]) credits_[schedule_class] = weights_[schedule_class];
+}
+
+void CallScheduler::Push(ScheduleClass schedule_class, int pipe_index, BERTBuffers::CallResponse &call) {
+  auto &queue = queues_[schedule_class];
+  queue.push_back(Item());
+  Item &item = queue.back();
+  item.schedule_class = schedule_class;
+  item.pipe_index = pipe_index;
+  item.call.Swap(&call);
+  item.queued = Now();
+  size_++;
+  pipe_counts_[pipe_index]++;
+  if (queue.size() > stats_[schedule_class].max_depth) stats_[schedule_class].max_depth = (uint32_t)queue.size();
+}
+
+void CallScheduler::Push(ScheduleClass schedule_class, Task task) {
+  auto &queue = queues_[schedule_class];
+  queue.push_back(Item());
+  Item &item = queue.back();
+  item.schedule_class = schedule_class;
+  item.pipe_index = -1;
+  item.task = task;
+  item.queued = Now();
+  size_++;
+  if (queue.size() > stats_[schedule_class].max_depth) stats_[schedule_class].max_depth = (uint32_t)queue.size();
+}
+
+void CallScheduler::Take(int schedule_class, Item &item) {
+
+  auto &queue = queues_[schedule_class];
+  auto position = queue.begin();
+
+  // fair: the next pipe (by index) after the last one we served, or the 
+  // lowest if we've gone around. this is a scan, but read-ahead limits
+  // the queue per pipe and there aren't many pipes.
+
+  if (fair_ && queue.size() > 1) {
+    int last = last_pipe_[schedule_class];
+    auto next = queue.end();
+    auto lowest = queue.begin();
+    for (auto iter = queue.begin(); iter != queue.end(); ++iter) {
+      if (iter->pipe_index > last && (next == queue.end() || iter->pipe_index < next->pipe_index)) next = iter;
+      if (iter->pipe_index < lowest->pipe_index) lowest = iter;
+    }
+    position = (next != queue.end()) ? next : lowest;
+  }
+
+  item = std::move(*position);
+  queue.erase(position);
+  last_pipe_[schedule_class] = item.pipe_index;
+  size_--;
+  if (item.pipe_index >= 0) pipe_counts_[item.pipe_index]--;
+
+  uint64_t wait = Now() - item.queued;
+  Stats &stats = stats_[schedule_class];
+  stats.dispatched++;
+  stats.total_wait_ms += wait;
+  if (wait > stats.max_wait_ms) stats.max_wait_ms = wait;
+
+}
+
+bool CallScheduler::Pop(Item &item, bool strict) {
+
+  if (!size_) return false;
+
+  if (strict) {
+    for (int i = 0; i < SCHEDULE_CLASS_COUNT; i++) {
+      if (queues_[i].size()) {
+        Take(i, item);
+        return true;
+      }
+    }
+  }
+
+  for (int i = 0; i < SCHEDULE_CLASS_COUNT; i++) {
+    if (queues_[i].size() && credits_[i]) {
+      credits_[i]--;
+      Take(i, item);
+      return true;
+    }
+  }
+
+  // every class with work has used its share: new round
+
+  memcpy(credits_, weights_, sizeof(credits_));
+
+  for (int i = 0; i < SCHEDULE_CLASS_COUNT; i++) {
+    if (queues_[i].size()) {
+      credits_[i]--;
+      Take(i, item);
+      return true;
+    }
+  }
+
+  return false;
+
+}
+
+size_t CallScheduler::pending(int pipe_index) {
+  auto iter = pipe_counts_.find(pipe_index);
+  return iter == pipe_counts_.end() ? 0 : iter->second;
+}
+
+void CallScheduler::Drop(int pipe_index) {
+  pipe_counts_.erase(pipe_index);
+  for (int i = 0; i < SCHEDULE_CLASS_COUNT; i++) {
+    auto &queue = queues_[i];
+    for (auto iter = queue.begin(); iter != queue.end(); ) {
+      if (iter->pipe_index == pipe_index) {
+        iter = queue.erase(iter);
+        size_--;
+        stats_[i].dropped++;
+      }
+      else ++iter;
+    }
+  }
+}
+
+std::string CallScheduler::Report() {
+  std::stringstream ss;
+  for (int i = 0; i < SCHEDULE_CLASS_COUNT; i++) {
+    const Stats &stats = stats_[i];
+    if (i) ss << std::endl;
+    ss << class_names[i] << ": queued " << queues_[i].size() << ", max " << stats.max_depth 
+      << ", dispatched " << stats.dispatched;
+    if (stats.dispatched) ss << ", wait avg " << (stats.total_wait_ms / stats.dispatched) << " ms, max " << stats.max_wait_ms << " ms";
+    if (stats.dropped) ss << ", dropped " << stats.dropped;
+  }
+  return ss.str();
+}
@@ -0,0 +1,159 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <deque>
+#include <unordered_map>
+#include <string>
+#include <functional>
+#include <stdint.h>
+
+#include "variable.pb.h"
+
+/**
+ * priority classes for the dispatch loop, highest first. interactive is
+ * the console (and user buttons), recalc is spreadsheet calls, background
+ * is deferred work like graphics updates, housekeeping is the language's
+ * own event processing.
+ */
+typedef enum {
+  SCHEDULE_INTERACTIVE = 0,
+  SCHEDULE_RECALC,
+  SCHEDULE_BACKGROUND,
+  SCHEDULE_HOUSEKEEPING,
+  SCHEDULE_CLASS_COUNT
+}
+ScheduleClass;
+
+/** default weights: dispatches per round when classes compete */
+#define SCHEDULE_WEIGHT_INTERACTIVE   8
+#define SCHEDULE_WEIGHT_RECALC        4
+#define SCHEDULE_WEIGHT_BACKGROUND    2
+#define SCHEDULE_WEIGHT_HOUSEKEEPING  1
+
+/**
+ * queue between reading messages and running them. the dispatch loop used
+ * to run whichever pipe signaled first, and the wait always reports the 
+ * lowest signaled handle, so a busy spreadsheet client could starve the 
+ * console (and vice versa). now the loop reads everything that's ready 
+ * into the scheduler, then runs one item at a time from here.
+ *
+ * classes are drained by weighted round robin: each class gets its weight 
+ * in dispatches per round, highest class first, and the round starts over
+ * when every class with work has used its share. an idle class doesn't 
+ * hold anything up. within a class, order is FIFO, unless the scheduler
+ * is fair (see set_fair).
+ *
+ * items are either calls (with the pipe they came from) or tasks. not 
+ * thread safe; the dispatch loop owns it.
+ */
+class CallScheduler {
+
+public:
+  typedef std::function<void()> Task;
+
+  typedef struct {
+    ScheduleClass schedule_class;
+    int pipe_index;                 // -1 for tasks
+    BERTBuffers::CallResponse call;
+    Task task;
+    uint64_t queued;                // ms
+  }
+  Item;
+
+  /** per-class metrics */
+  typedef struct {
+    uint64_t dispatched;
+    uint64_t dropped;
+    uint32_t max_depth;
+    uint64_t total_wait_ms;
+    uint64_t max_wait_ms;
+  }
+  Stats;
+
+public:
+  CallScheduler();
+
+public:
+
+  /** queue a call. the call is swapped out of the argument */
+  void Push(ScheduleClass schedule_class, int pipe_index, BERTBuffers::CallResponse &call);
+
+  /** queue a task */
+  void Push(ScheduleClass schedule_class, Task task);
+
+  /** 
+   * take the next item. if strict is set, ignore the weights and take the
+   * highest class with work (use this inside a nested prompt, where the 
+   * console has to come first). returns false if there's nothing queued.
+   */
+  bool Pop(Item &item, bool strict = false);
+
+  /** discard calls from a pipe (the client went away) */
+  void Drop(int pipe_index);
+
+  /** set the weight for a class (minimum 1) */
+  void set_weight(ScheduleClass schedule_class, uint32_t weight);
+
+  /**
+   * fair scheduling: within a class, take turns between pipes (FIFO 
+   * within a pipe), so one busy client can't hold up the others. the
+   * shared server turns this on; with one client it makes no difference.
+   */
+  void set_fair(bool fair) { fair_ = fair; }
+
+  /** items queued, in total */
+  size_t size() { return size_; }
+
+  /** calls queued from one pipe */
+  size_t pending(int pipe_index);
+
+  /** items queued in one class */
+  size_t depth(ScheduleClass schedule_class) { return queues_[schedule_class].size(); }
+
+  /** accessor */
+  const Stats &stats(ScheduleClass schedule_class) { return stats_[schedule_class]; }
+
+  /** metrics, one line per class */
+  std::string Report();
+
+protected:
+
+  /** monotonic clock, in ms */
+  static uint64_t Now();
+
+  /** take the front of a class and update stats */
+  void Take(int schedule_class, Item &item);
+
+private:
+  std::deque<Item> queues_[SCHEDULE_CLASS_COUNT];
+  uint32_t weights_[SCHEDULE_CLASS_COUNT];
+  uint32_t credits_[SCHEDULE_CLASS_COUNT];
+  Stats stats_[SCHEDULE_CLASS_COUNT];
+  size_t size_;
+
+  /** fair scheduling, and the last pipe served in each class */
+  bool fair_;
+  int last_pipe_[SCHEDULE_CLASS_COUNT];
+
+  /** calls queued per pipe, so the loop can limit read-ahead */
+  std::unordered_map<int, size_t> pipe_counts_;
+
+};
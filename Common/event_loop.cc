@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _WIN32
+
+#include "event_loop.h"
+
+#include <iostream>
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define MAX_EVENTS_PER_WAIT 16
+
+EventLoop::EventLoop()
+  : epoll_fd_(-1)
+  , wake_fd_(-1)
+{
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if (epoll_fd_ < 0 || wake_fd_ < 0) {
+    std::cerr << "event loop init failed (" << errno << ")" << std::endl;
+    return;
+  }
+
+  struct epoll_event event = {};
+  event.events = EPOLLIN;
+  event.data.fd = wake_fd_;
+  epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event);
+}
+
+EventLoop::~EventLoop() {
+  if (wake_fd_ >= 0) close(wake_fd_);
+  if (epoll_fd_ >= 0) close(epoll_fd_);
+}
+
+bool EventLoop::Add(int fd, uint32_t events, Handler handler) {
+  struct epoll_event event = {};
+  event.events = events;
+  event.data.fd = fd;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) return false;
+  handlers_[fd] = handler;
+  return true;
+}
+
+bool EventLoop::Modify(int fd, uint32_t events) {
+  struct epoll_event event = {};
+  event.events = events;
+  event.data.fd = fd;
+  return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void EventLoop::Remove(int fd) {
+  epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, 0);
+  handlers_.erase(fd);
+}
+
+void EventLoop::Wake() {
+  uint64_t one = 1;
+  ssize_t rslt = write(wake_fd_, &one, sizeof(one));
+  (void)rslt;
+}
+
+int EventLoop::RunOnce(int timeout) {
+
+  struct epoll_event events[MAX_EVENTS_PER_WAIT];
+  int count = epoll_wait(epoll_fd_, events, MAX_EVENTS_PER_WAIT, timeout);
+
+  if (count < 0) {
+    if (errno == EINTR) return 0;
+    std::cerr << "epoll_wait failed (" << errno << ")" << std::endl;
+    return -1;
+  }
+
+  int dispatched = 0;
+  for (int i = 0; i < count; i++) {
+
+    int fd = events[i].data.fd;
+
+    if (fd == wake_fd_) {
+      uint64_t value;
+      ssize_t rslt = read(wake_fd_, &value, sizeof(value));
+      (void)rslt;
+      continue;
+    }
+
+    // look up each time; a previous handler may have removed this fd.
+    // copy the handler in case it removes itself.
+
+    auto iter = handlers_.find(fd);
+    if (iter == handlers_.end()) continue;
+    Handler handler = iter->second;
+    handler(events[i].events);
+    dispatched++;
+  }
+
+  return dispatched;
+}
+
+#endif // #ifndef _WIN32
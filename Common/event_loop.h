@@ -0,0 +1,77 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <functional>
+#include <unordered_map>
+#include <stdint.h>
+
+/**
+ * readiness loop for the posix transport. this takes the place of 
+ * WaitForMultipleObjects on windows: register file descriptors (pipe wait 
+ * handles) with a handler, then call RunOnce() in the dispatch loop.
+ *
+ * the loop is edge-agnostic (level-triggered), so a handler that doesn't
+ * consume everything will be called again on the next pass. Wake() is safe
+ * to call from other threads and interrupts a blocking wait.
+ */
+class EventLoop {
+
+public:
+  typedef std::function<void(uint32_t events)> Handler;
+
+public:
+  EventLoop();
+  ~EventLoop();
+
+public:
+
+  /** register fd for events (EPOLLIN, EPOLLOUT, ...). returns false on error */
+  bool Add(int fd, uint32_t events, Handler handler);
+
+  /** change the event mask for a registered fd */
+  bool Modify(int fd, uint32_t events);
+
+  /** unregister fd. safe to call from a handler */
+  void Remove(int fd);
+
+  /** 
+   * wait up to timeout milliseconds (-1 to block) and dispatch handlers.
+   * returns the number of events dispatched, 0 on timeout or wake, or -1 
+   * on error.
+   */
+  int RunOnce(int timeout);
+
+  /** interrupt a blocking RunOnce. thread safe */
+  void Wake();
+
+  /** accessor */
+  bool valid() { return epoll_fd_ >= 0; }
+
+private:
+  int epoll_fd_;
+  int wake_fd_;
+  std::unordered_map<int, Handler> handlers_;
+
+};
+
+#endif // #ifndef _WIN32
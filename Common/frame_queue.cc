@@ -0,0 +1,202 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_queue.h"
+
+#include <sstream>
+#include <unordered_map>
+
+FrameQueue::FrameQueue()
+  : bytes_(0)
+  , max_bytes_(0)
+  , policy_(QUEUE_POLICY_NONE)
+  , pages_(0)
+  , coalesced_pages_(0)
+  , high_water_bytes_(0)
+  , high_water_frames_(0)
+  , dropped_frames_(0)
+  , dropped_bytes_(0)
+  , coalesced_frames_(0)
+  , blocked_count_(0)
+{}
+
+void FrameQueue::SetLimit(size_t max_bytes, QueuePolicy policy) {
+  max_bytes_ = max_bytes;
+  policy_ = max_bytes ? policy : QUEUE_POLICY_NONE;
+  if (policy_ == QUEUE_POLICY_DROP && over_limit()) Trim();
+}
+
+bool FrameQueue::Push(std::string frame, FrameClass frame_class, size_t group) {
+
+  Entry entry;
+  entry.frame.swap(frame);
+  entry.frame_class = frame_class;
+  entry.group = group;
+  entry.dropped_bytes = 0;
+
+  bytes_ += entry.frame.length();
+  if (frame_class == FRAME_CLASS_PAGE) pages_++;
+  entries_.push_back(std::move(entry));
+
+  bool wait = false;
+  if (over_limit()) {
+    if (policy_ == QUEUE_POLICY_DROP) Trim();
+    else if (policy_ == QUEUE_POLICY_BLOCK) {
+      blocked_count_++;
+      wait = true;
+    }
+  }
+
+  UpdateHighWater();
+  return wait;
+}
+
+void FrameQueue::Take(FrameQueue &other) {
+
+  for (auto &entry : other.entries_) {
+    bytes_ += entry.frame.length();
+    if (entry.frame_class == FRAME_CLASS_PAGE) pages_++;
+    entries_.push_back(std::move(entry));
+  }
+  other.clear();
+
+  if (policy_ == QUEUE_POLICY_DROP && over_limit()) Trim();
+  UpdateHighWater();
+}
+
+void FrameQueue::pop_front() {
+  const Entry &entry = entries_.front();
+  bytes_ -= entry.frame.length();
+  if (entry.frame_class == FRAME_CLASS_PAGE) pages_--;
+  entries_.pop_front();
+  if (pages_ < coalesced_pages_) coalesced_pages_ = pages_;
+}
+
+void FrameQueue::PopFront(std::string &target) {
+  Entry &entry = entries_.front();
+  bytes_ -= entry.frame.length();
+  if (entry.frame_class == FRAME_CLASS_PAGE) pages_--;
+  target.swap(entry.frame);
+  entries_.pop_front();
+  if (pages_ < coalesced_pages_) coalesced_pages_ = pages_;
+}
+
+void FrameQueue::clear() {
+  entries_.clear();
+  bytes_ = 0;
+  pages_ = 0;
+  coalesced_pages_ = 0;
+}
+
+void FrameQueue::UpdateHighWater() {
+  if (bytes_ > high_water_bytes_) high_water_bytes_ = bytes_;
+  if (entries_.size() > high_water_frames_) high_water_frames_ = entries_.size();
+}
+
+void FrameQueue::Trim() {
+  CoalesceGraphics();
+  if (over_limit()) DropOldest(FRAME_CLASS_TEXT, true);
+  if (over_limit()) DropOldest(FRAME_CLASS_GRAPHICS, false);
+}
+
+void FrameQueue::CoalesceGraphics() {
+
+  // if no pages have been added since the last pass, there's nothing new
+  // to coalesce (the remaining pages are the latest for their devices)
+
+  if (pages_ <= coalesced_pages_) return;
+
+  std::unordered_map<size_t, size_t> last_page;
+  for (size_t i = 0; i < entries_.size(); i++) {
+    if (entries_[i].frame_class == FRAME_CLASS_PAGE) last_page[entries_[i].group] = i;
+  }
+
+  std::deque<Entry> kept;
+  for (size_t i = 0; i < entries_.size(); i++) {
+    Entry &entry = entries_[i];
+    if (entry.frame_class == FRAME_CLASS_GRAPHICS || entry.frame_class == FRAME_CLASS_PAGE) {
+      auto iter = last_page.find(entry.group);
+      if (iter != last_page.end() && i < iter->second) {
+        bytes_ -= entry.frame.length();
+        if (entry.frame_class == FRAME_CLASS_PAGE) pages_--;
+        coalesced_frames_++;
+        continue;
+      }
+    }
+    kept.push_back(std::move(entry));
+  }
+
+  entries_.swap(kept);
+  coalesced_pages_ = pages_;
+
+}
+
+uint64_t FrameQueue::DropOldest(FrameClass frame_class, bool mark) {
+
+  uint64_t dropped = 0;
+  size_t insert_at = 0;
+
+  for (auto iter = entries_.begin(); iter != entries_.end() && over_limit(); ) {
+    if (iter->frame_class == frame_class) {
+      if (!dropped) insert_at = iter - entries_.begin();
+      dropped += iter->frame.length();
+      bytes_ -= iter->frame.length();
+      dropped_frames_++;
+      iter = entries_.erase(iter);
+    }
+    else ++iter;
+  }
+
+  dropped_bytes_ += dropped;
+
+  if (dropped && mark && marker_) {
+
+    // if there's already a marker right before the gap, update it 
+    // instead of adding another one
+
+    if (insert_at > 0 && entries_[insert_at - 1].frame_class == FRAME_CLASS_MARKER) {
+      Entry &marker = entries_[insert_at - 1];
+      bytes_ -= marker.frame.length();
+      marker.dropped_bytes += dropped;
+      marker.frame = marker_(marker.dropped_bytes);
+      bytes_ += marker.frame.length();
+    }
+    else {
+      Entry marker;
+      marker.frame = marker_(dropped);
+      marker.frame_class = FRAME_CLASS_MARKER;
+      marker.group = 0;
+      marker.dropped_bytes = dropped;
+      bytes_ += marker.frame.length();
+      entries_.insert(entries_.begin() + insert_at, std::move(marker));
+    }
+  }
+
+  return dropped;
+}
+
+std::string FrameQueue::Stats() {
+  std::stringstream ss;
+  ss << "queued: " << bytes_ << " bytes/" << entries_.size() << " frames"
+    << ", high water: " << high_water_bytes_ << " bytes/" << high_water_frames_ << " frames";
+  if (dropped_frames_) ss << ", dropped: " << dropped_frames_ << " frames/" << dropped_bytes_ << " bytes";
+  if (coalesced_frames_) ss << ", coalesced: " << coalesced_frames_ << " frames";
+  if (blocked_count_) ss << ", blocked: " << blocked_count_;
+  return ss.str();
+}
@@ -0,0 +1,192 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <functional>
+#include <stdint.h>
+#include <stddef.h>
+
+/** what to do when a queue goes over its byte limit */
+typedef enum {
+
+  /** no limit (the default) */
+  QUEUE_POLICY_NONE = 0,
+
+  /** the producer waits for the consumer (see Pipe::WaitWrites) */
+  QUEUE_POLICY_BLOCK,
+
+  /** drop or coalesce frames that can be lost; see Trim() */
+  QUEUE_POLICY_DROP
+
+}
+QueuePolicy;
+
+/** what a frame is, for the purposes of dropping it */
+typedef enum {
+
+  /** never dropped (responses, prompts, control messages) */
+  FRAME_CLASS_CONTROL = 0,
+
+  /** console output; dropped oldest-first and replaced with a marker */
+  FRAME_CLASS_TEXT,
+
+  /** graphics command; obsolete once there's a later page on the same device */
+  FRAME_CLASS_GRAPHICS,
+
+  /** graphics new page */
+  FRAME_CLASS_PAGE,
+
+  /** truncation marker (internal) */
+  FRAME_CLASS_MARKER
+
+}
+FrameClass;
+
+/**
+ * byte-bounded queue of frames. with the drop policy, going over the limit
+ * drops frames in this order:
+ *
+ * (1) graphics frames followed by a new page on the same device. those 
+ *     would be drawn and then immediately cleared, so this is lossless
+ *     from the user's perspective (it coalesces plotting loops).
+ *
+ * (2) console text, oldest first. dropped text is replaced with a marker
+ *     frame (from the marker function) so the user knows.
+ *
+ * (3) remaining graphics, oldest first. this is the last resort; the 
+ *     current plot will be incomplete, but memory stays flat.
+ *
+ * control frames are never dropped. with the block policy, Push returns 
+ * true when the queue is over the limit and the caller should wait.
+ */
+class FrameQueue {
+
+public:
+
+  /** creates a marker frame for the given number of dropped bytes */
+  typedef std::function<std::string(uint64_t dropped_bytes)> MarkerFunction;
+
+public:
+  FrameQueue();
+
+public:
+
+  /** set limit (0 is unbounded) and policy */
+  void SetLimit(size_t max_bytes, QueuePolicy policy);
+
+  /** set the function that creates truncation markers */
+  void set_marker(MarkerFunction marker) { marker_ = marker; }
+
+  /**
+   * add a frame. group identifies the graphics device, for coalescing. 
+   * returns true if the queue is over the limit and the policy is block.
+   * the frame is moved in, so pass temporaries to avoid a copy.
+   */
+  bool Push(std::string frame, FrameClass frame_class = FRAME_CLASS_CONTROL, size_t group = 0);
+
+  /** move everything from another queue, keeping frame classes (and applying our policy) */
+  void Take(FrameQueue &other);
+
+  /** accessor */
+  const std::string &front() { return entries_.front().frame; }
+
+  /** remove the front frame */
+  void pop_front();
+
+  /** remove the front frame, swapping it into target (no copy) */
+  void PopFront(std::string &target);
+
+  /** remove everything */
+  void clear();
+
+  /** accessor */
+  size_t size() { return entries_.size(); }
+
+  /** accessor */
+  bool empty() { return entries_.empty(); }
+
+  /** accessor: bytes queued */
+  size_t bytes() { return bytes_; }
+
+  /** accessor */
+  size_t max_bytes() { return max_bytes_; }
+
+  /** accessor */
+  QueuePolicy policy() { return policy_; }
+
+  /** true if there's a limit and we're over it */
+  bool over_limit() { return max_bytes_ && bytes_ > max_bytes_; }
+
+  /** accessor: high-water mark, bytes */
+  size_t high_water_bytes() { return high_water_bytes_; }
+
+  /** accessor: high-water mark, frames */
+  size_t high_water_frames() { return high_water_frames_; }
+
+  /** metrics as a string, for logging */
+  std::string Stats();
+
+protected:
+
+  /** apply the drop policy until we're under the limit (or out of options) */
+  void Trim();
+
+  /** drop graphics frames that are followed by a page on the same device */
+  void CoalesceGraphics();
+
+  /** drop the oldest frames of this class until we're under the limit. returns bytes dropped */
+  uint64_t DropOldest(FrameClass frame_class, bool mark);
+
+  void UpdateHighWater();
+
+private:
+
+  struct Entry {
+    std::string frame;
+    FrameClass frame_class;
+    size_t group;
+
+    /** for markers, the total they represent */
+    uint64_t dropped_bytes;
+  };
+
+  std::deque<Entry> entries_;
+
+  size_t bytes_;
+  size_t max_bytes_;
+  QueuePolicy policy_;
+
+  /** number of page frames in the queue, and the count after the last coalesce */
+  size_t pages_;
+  size_t coalesced_pages_;
+
+  MarkerFunction marker_;
+
+  /** metrics */
+  size_t high_water_bytes_;
+  size_t high_water_frames_;
+  uint64_t dropped_frames_;
+  uint64_t dropped_bytes_;
+  uint64_t coalesced_frames_;
+  uint64_t blocked_count_;
+
+};
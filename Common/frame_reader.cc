@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "frame_reader.h"
+
+#include <cstring>
+
+// bounds for the adaptive initial read size
+#define MIN_READ_SIZE       (8 * 1024)
+#define MAX_READ_SIZE       (1024 * 1024)
+
+// if the buffer grew past this (for a large message) and recent messages
+// are small, give the memory back
+#define SHRINK_THRESHOLD    (4 * 1024 * 1024)
+
+// don't trust a length prefix past this; it's probably not a frame
+#define MAX_FRAME_HINT      (256 * 1024 * 1024)
+
+FrameReader::FrameReader(bool framed)
+  : filled_(0)
+  , expected_(0)
+  , average_(MIN_READ_SIZE)
+  , complete_(false)
+  , framed_(framed)
+{
+  buffer_.resize(MIN_READ_SIZE);
+}
+
+void FrameReader::Begin() {
+
+  if (!complete_) return;
+
+  complete_ = false;
+  filled_ = 0;
+  expected_ = 0;
+
+  size_t initial = MIN_READ_SIZE;
+  while (initial < average_ && initial < MAX_READ_SIZE) initial <<= 1;
+
+  if (buffer_.capacity() > SHRINK_THRESHOLD && buffer_.capacity() > initial * 4) {
+    std::vector<char> replacement(initial);
+    buffer_.swap(replacement);
+  }
+  else if (buffer_.size() < initial) buffer_.resize(initial);
+
+}
+
+void FrameReader::Grow(size_t free_space) {
+  if (buffer_.size() - filled_ >= free_space) return;
+  size_t target = buffer_.size() * 2;
+  if (target < filled_ + free_space) target = filled_ + free_space;
+  buffer_.resize(target);
+}
+
+char *FrameReader::read_pointer() {
+  Begin();
+  if (buffer_.size() == filled_) Grow(MIN_READ_SIZE);
+  return &(buffer_[0]) + filled_;
+}
+
+uint32_t FrameReader::read_size() {
+  Begin();
+  if (buffer_.size() == filled_) Grow(MIN_READ_SIZE);
+  return (uint32_t)(buffer_.size() - filled_);
+}
+
+void FrameReader::Reserve(uint32_t bytes) {
+  Begin();
+  if (expected_) return; // already sized for the rest of the frame
+  Grow(bytes);
+}
+
+void FrameReader::Complete(uint32_t bytes, bool more) {
+
+  filled_ += bytes;
+
+  if (!more) {
+    complete_ = true;
+    average_ = (average_ * 7 + filled_) / 8;
+    return;
+  }
+
+  // partial. if we know the frame length, size the buffer exactly so 
+  // the rest comes in a single read. otherwise (raw data, or a length 
+  // that doesn't make sense) grow geometrically.
+
+  FrameHeader header;
+  if (framed_ && !expected_ && MessageUtilities::ReadFrameHeader(&(buffer_[0]), (uint32_t)filled_, header)) {
+    size_t total = (size_t)header.header_size + header.length;
+    if (total > filled_ && total <= MAX_FRAME_HINT) {
+      expected_ = total;
+      if (buffer_.size() < total) buffer_.resize(total);
+      return;
+    }
+  }
+
+  Grow(MIN_READ_SIZE);
+
+}
+
+bool FrameReader::Parse(google::protobuf::Message &message, SharedRing *ring) {
+  if (!complete_ || filled_ < sizeof(int32_t)) return false;
+  return MessageUtilities::Unframe(message, &(buffer_[0]), (uint32_t)filled_, ring);
+}
+
+void FrameReader::Assign(std::string &target) {
+  target.assign(&(buffer_[0]), filled_);
+}
+
+void FrameReader::Clear() {
+  filled_ = 0;
+  expected_ = 0;
+  complete_ = false;
+}
@@ -0,0 +1,126 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+#include "message_utilities.h"
+
+/**
+ * reader for message-mode pipes. the caller does the actual reads (it 
+ * owns the handle and the overlapped structure); this class owns the 
+ * buffer and decides where and how much to read.
+ *
+ * on a message-mode pipe, a message larger than the read comes back in 
+ * pieces (ERROR_MORE_DATA). rather than appending the pieces to a string
+ * and then copying that again, we use the frame length prefix from the 
+ * first piece to size the buffer exactly, read the rest in one go, and 
+ * parse in place. the buffer is reused between messages.
+ *
+ * the initial read size adapts to recent message sizes, so typical 
+ * messages complete in one read. for pipes that don't carry frames (raw
+ * text), turn off framing; the buffer then grows geometrically.
+ *
+ * usage:
+ *
+ *   ReadFile(handle, reader.read_pointer(), reader.read_size(), ...);
+ *   ...
+ *   if (success) { reader.Complete(bytes, false); reader.Parse(message); }
+ *   else if (ERROR_MORE_DATA) { reader.Complete(bytes, true); ReadFile(...) }
+ *
+ * don't call read_pointer() or read_size() while a read is pending; they
+ * may resize the buffer.
+ */
+class FrameReader {
+
+public:
+  FrameReader(bool framed = true);
+
+public:
+
+  /** where the next read should go. starts a new message if the last one was complete */
+  char *read_pointer();
+
+  /** how much the next read should ask for */
+  uint32_t read_size();
+
+  /** 
+   * make sure there's at least this much space for the next read, for 
+   * transports with a fixed record size. no-op if we already know the 
+   * frame length (the buffer is sized exactly).
+   */
+  void Reserve(uint32_t bytes);
+
+  /**
+   * record a completed read. more means the message isn't complete 
+   * (ERROR_MORE_DATA); in that case, read again.
+   */
+  void Complete(uint32_t bytes, bool more);
+
+  /** parse the completed message in place (see MessageUtilities::Unframe) */
+  bool Parse(google::protobuf::Message &message, SharedRing *ring = 0);
+
+  /** copy out the completed message */
+  void Assign(std::string &target);
+
+  /** discard anything partial */
+  void Clear();
+
+  /** accessor */
+  bool complete() { return complete_; }
+
+  /** accessor: the completed message */
+  const char *data() { return &(buffer_[0]); }
+
+  /** accessor: length of the completed message */
+  size_t length() { return filled_; }
+
+  /** flag bits from the completed message's prefix (see message_utilities.h) */
+  uint32_t flags() { return MessageUtilities::FrameFlags(&(buffer_[0]), (uint32_t)filled_); }
+
+  /** accessor */
+  void set_framed(bool framed) { framed_ = framed; }
+
+protected:
+
+  /** if the last message completed, reset for a new one */
+  void Begin();
+
+  /** grow the buffer so the next read has at least this much space */
+  void Grow(size_t free_space);
+
+private:
+  std::vector<char> buffer_;
+
+  /** bytes in the current message */
+  size_t filled_;
+
+  /** full length of the current message, from the prefix (0 if unknown) */
+  size_t expected_;
+
+  /** moving average of message sizes, for the initial read */
+  size_t average_;
+
+  bool complete_;
+  bool framed_;
+
+};
@@ -0,0 +1,221 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "lz_codec.h"
+
+#include <cstring>
+
+// format constants (see LZ4 block format)
+#define MIN_MATCH       4
+#define LAST_LITERALS   5     // the last 5 bytes are always literals
+#define MF_LIMIT        12    // the last match starts at least this far from the end
+#define MAX_DISTANCE    65535
+
+// hash table size (log2). 4K entries is 16K on the stack
+#define HASH_LOG        12
+
+// after this many misses, start skipping ahead faster
+#define SKIP_TRIGGER    6
+
+static inline uint32_t Read32(const uint8_t *p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(uint32_t));
+  return value;
+}
+
+static inline uint32_t Hash(uint32_t sequence) {
+  return (sequence * 2654435761U) >> (32 - HASH_LOG);
+}
+
+/** write a length in the 255-continuation encoding */
+static inline uint8_t* WriteLength(uint8_t *op, size_t length) {
+  while (length >= 255) {
+    *op++ = 255;
+    length -= 255;
+  }
+  *op++ = (uint8_t)length;
+  return op;
+}
+
+namespace LZCodec {
+
+  size_t Bound(size_t length) {
+    return length + (length / 255) + 16;
+  }
+
+  size_t Compress(const char *source, size_t length, char *target, size_t capacity) {
+
+    const uint8_t *src = reinterpret_cast<const uint8_t*>(source);
+    const uint8_t *end = src + length;
+    const uint8_t *ip = src;
+    const uint8_t *anchor = src;
+
+    uint8_t *op = reinterpret_cast<uint8_t*>(target);
+    uint8_t *op_end = op + capacity;
+
+    if (length >= MF_LIMIT + 1) {
+
+      uint32_t table[1 << HASH_LOG];
+      memset(table, 0, sizeof(table));
+
+      const uint8_t *match_limit = end - MF_LIMIT;
+      const uint8_t *match_end_limit = end - LAST_LITERALS;
+
+      uint32_t misses = 1 << SKIP_TRIGGER;
+      ip++;
+
+      while (ip < match_limit) {
+
+        uint32_t sequence = Read32(ip);
+        uint32_t hash = Hash(sequence);
+        const uint8_t *ref = src + table[hash];
+        table[hash] = (uint32_t)(ip - src);
+
+        if (ref >= ip || (size_t)(ip - ref) > MAX_DISTANCE || Read32(ref) != sequence) {
+          ip += (misses++ >> SKIP_TRIGGER);
+          continue;
+        }
+
+        // extend backwards over literals, then forwards
+
+        while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+          ip--;
+          ref--;
+        }
+
+        const uint8_t *mp = ip + MIN_MATCH;
+        const uint8_t *rp = ref + MIN_MATCH;
+        while (mp < match_end_limit && *mp == *rp) {
+          mp++;
+          rp++;
+        }
+
+        size_t literal_length = ip - anchor;
+        size_t match_length = (mp - ip) - MIN_MATCH;
+
+        // token + literal length bytes + literals + offset + match length bytes
+        if ((size_t)(op_end - op) < 1 + (literal_length / 255) + 1 + literal_length + 2 + (match_length / 255) + 1) return 0;
+
+        uint8_t *token = op++;
+        if (literal_length >= 15) {
+          *token = 15 << 4;
+          op = WriteLength(op, literal_length - 15);
+        }
+        else *token = (uint8_t)(literal_length << 4);
+
+        memcpy(op, anchor, literal_length);
+        op += literal_length;
+
+        uint16_t offset = (uint16_t)(ip - ref);
+        *op++ = (uint8_t)(offset & 0xff);
+        *op++ = (uint8_t)(offset >> 8);
+
+        if (match_length >= 15) {
+          *token |= 15;
+          op = WriteLength(op, match_length - 15);
+        }
+        else *token |= (uint8_t)match_length;
+
+        ip = anchor = mp;
+        misses = 1 << SKIP_TRIGGER;
+
+        // index a position inside the match, it helps with runs
+        if (ip < match_limit) table[Hash(Read32(ip - 2))] = (uint32_t)(ip - 2 - src);
+
+      }
+    }
+
+    // trailing literals
+
+    size_t literal_length = end - anchor;
+    if ((size_t)(op_end - op) < 1 + (literal_length / 255) + 1 + literal_length) return 0;
+
+    if (literal_length >= 15) {
+      *op++ = 15 << 4;
+      op = WriteLength(op, literal_length - 15);
+    }
+    else *op++ = (uint8_t)(literal_length << 4);
+
+    memcpy(op, anchor, literal_length);
+    op += literal_length;
+
+    return op - reinterpret_cast<uint8_t*>(target);
+  }
+
+  bool Decompress(const char *source, size_t length, char *target, size_t target_length) {
+
+    const uint8_t *ip = reinterpret_cast<const uint8_t*>(source);
+    const uint8_t *ip_end = ip + length;
+
+    uint8_t *op = reinterpret_cast<uint8_t*>(target);
+    uint8_t *op_start = op;
+    uint8_t *op_end = op + target_length;
+
+    while (ip < ip_end) {
+
+      uint8_t token = *ip++;
+
+      size_t literal_length = token >> 4;
+      if (literal_length == 15) {
+        uint8_t b;
+        do {
+          if (ip >= ip_end) return false;
+          b = *ip++;
+          literal_length += b;
+        } while (b == 255);
+      }
+
+      if ((size_t)(ip_end - ip) < literal_length || (size_t)(op_end - op) < literal_length) return false;
+      memcpy(op, ip, literal_length);
+      op += literal_length;
+      ip += literal_length;
+
+      if (ip >= ip_end) break; // last sequence has no match
+
+      if (ip_end - ip < 2) return false;
+      size_t offset = ip[0] | (ip[1] << 8);
+      ip += 2;
+      if (!offset || offset > (size_t)(op - op_start)) return false;
+
+      size_t match_length = token & 15;
+      if (match_length == 15) {
+        uint8_t b;
+        do {
+          if (ip >= ip_end) return false;
+          b = *ip++;
+          match_length += b;
+        } while (b == 255);
+      }
+      match_length += MIN_MATCH;
+
+      if ((size_t)(op_end - op) < match_length) return false;
+
+      // overlapping matches (offset < length) repeat; copy forward
+
+      const uint8_t *match = op - offset;
+      if (offset >= match_length) memcpy(op, match, match_length);
+      else for (size_t i = 0; i < match_length; i++) op[i] = match[i];
+      op += match_length;
+
+    }
+
+    return op == op_end;
+  }
+
+}
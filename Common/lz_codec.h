@@ -0,0 +1,51 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+/**
+ * small, fast LZ codec for frame compression. the output is the LZ4 block
+ * format (tokens of literal/match lengths, 16-bit offsets, 64K window), so
+ * any LZ4 block decoder can read it. we only implement the fast path: one
+ * hash probe per position, skipping ahead faster on incompressible data.
+ *
+ * this is meant for data that's large and repetitive -- numeric ranges, 
+ * repeated strings, raster images. it's not a general-purpose compressor.
+ */
+namespace LZCodec {
+
+  /** maximum compressed size for a given input length */
+  size_t Bound(size_t length);
+
+  /**
+   * compress source into target. returns the compressed length, or 0 if 
+   * it doesn't fit in capacity (use Bound() to be sure it does).
+   */
+  size_t Compress(const char *source, size_t length, char *target, size_t capacity);
+
+  /**
+   * decompress source into target, which must be exactly the original
+   * length. returns false if the data is malformed or the wrong length.
+   */
+  bool Decompress(const char *source, size_t length, char *target, size_t target_length);
+
+};
@@ -0,0 +1,182 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "memory_policy.h"
+
+#include <chrono>
+#include <sstream>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#include <malloc.h>
+#else
+#include <unistd.h>
+#include <stdio.h>
+#endif
+
+static const char *action_names[MEMORY_ACTION_COUNT] = { "none", "idle", "soft", "hard" };
+
+MemoryPolicy::MemoryPolicy()
+  : idle_ms_(0)
+  , cache_ttl_(0)
+  , soft_limit_(0)
+  , hard_limit_(0)
+  , last_activity_(Now())
+  , last_check_(0)
+  , last_ceiling_(0)
+  , idle_reclaimed_(true)
+  , last_rss_(0)
+  , peak_rss_(0)
+{
+  memset(stats_, 0, sizeof(stats_));
+}
+
+uint64_t MemoryPolicy::Now() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void MemoryPolicy::Configure(const json11::Json &config) {
+
+  if (config["idleReclaim"].is_number() && config["idleReclaim"].number_value() > 0) {
+    idle_ms_ = (uint64_t)(config["idleReclaim"].number_value() * 1000);
+  }
+  if (config["cacheTTL"].is_number() && config["cacheTTL"].number_value() > 0) {
+    cache_ttl_ = (uint32_t)config["cacheTTL"].number_value();
+  }
+  if (config["softLimit"].is_number() && config["softLimit"].number_value() > 0) {
+    soft_limit_ = (uint64_t)(config["softLimit"].number_value() * 1024 * 1024);
+  }
+  if (config["hardLimit"].is_number() && config["hardLimit"].number_value() > 0) {
+    hard_limit_ = (uint64_t)(config["hardLimit"].number_value() * 1024 * 1024);
+  }
+
+}
+
+void MemoryPolicy::Activity() {
+  last_activity_ = Now();
+  idle_reclaimed_ = false;
+}
+
+bool MemoryPolicy::Due() {
+  return (Now() - last_check_ >= MEMORY_CHECK_INTERVAL_MS);
+}
+
+MemoryAction MemoryPolicy::Check() {
+
+  uint64_t now = Now();
+  last_check_ = now;
+
+  last_rss_ = ResidentBytes();
+  if (last_rss_ > peak_rss_) peak_rss_ = last_rss_;
+
+  bool ceiling_ok = (!last_ceiling_ || now - last_ceiling_ >= MEMORY_CEILING_INTERVAL_MS);
+
+  if (hard_limit_ && last_rss_ > hard_limit_ && ceiling_ok) {
+    last_ceiling_ = now;
+    return MEMORY_ACTION_HARD;
+  }
+
+  if (soft_limit_ && last_rss_ > soft_limit_ && ceiling_ok) {
+    last_ceiling_ = now;
+    return MEMORY_ACTION_SOFT;
+  }
+
+  // idle reclamation happens once, then waits for the next call
+
+  if (idle_ms_ && !idle_reclaimed_ && now - last_activity_ >= idle_ms_) {
+    idle_reclaimed_ = true;
+    return MEMORY_ACTION_IDLE;
+  }
+
+  return MEMORY_ACTION_NONE;
+
+}
+
+void MemoryPolicy::Record(MemoryAction action, uint64_t rss_before, uint64_t elapsed_ms, uint32_t evicted) {
+
+  last_rss_ = ResidentBytes();
+
+  Stats &stats = stats_[action];
+  stats.count++;
+  stats.total_ms += elapsed_ms;
+  stats.evicted += evicted;
+  if (rss_before > last_rss_) stats.reclaimed_bytes += (rss_before - last_rss_);
+
+}
+
+std::string MemoryPolicy::Report() {
+
+  std::stringstream ss;
+  ss << "rss " << (last_rss_ / (1024 * 1024)) << " MB, peak " << (peak_rss_ / (1024 * 1024)) << " MB";
+
+  for (int i = MEMORY_ACTION_IDLE; i < MEMORY_ACTION_COUNT; i++) {
+    const Stats &stats = stats_[i];
+    ss << std::endl << action_names[i] << ": " << stats.count;
+    if (stats.count) {
+      ss << ", " << stats.total_ms << " ms, reclaimed " << (stats.reclaimed_bytes / (1024 * 1024)) << " MB";
+      if (stats.evicted) ss << ", evicted " << stats.evicted;
+    }
+  }
+
+  return ss.str();
+
+}
+
+uint64_t MemoryPolicy::ResidentBytes() {
+
+#ifdef _WIN32
+
+  // K32 is the kernel32 version, so we don't need psapi.lib
+
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return 0;
+  return (uint64_t)counters.WorkingSetSize;
+
+#else
+
+  // second field of statm is resident pages
+
+  unsigned long size = 0, resident = 0;
+  FILE *file = fopen("/proc/self/statm", "r");
+  if (!file) return 0;
+  if (fscanf(file, "%lu %lu", &size, &resident) != 2) resident = 0;
+  fclose(file);
+  return (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE);
+
+#endif
+
+}
+
+void MemoryPolicy::ReturnMemory() {
+
+#ifdef _WIN32
+
+  // CRT heap, then the process heap, then trim the working set (pages go 
+  // to the standby list; they come back if they're used again)
+
+  _heapmin();
+  HeapCompact(GetProcessHeap(), 0);
+  SetProcessWorkingSetSize(GetCurrentProcess(), (SIZE_T)-1, (SIZE_T)-1);
+
+#endif
+
+}
@@ -0,0 +1,136 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <stdint.h>
+
+#include "json11/json11.hpp"
+
+/** how often the dispatch loop checks memory, in ms */
+#define MEMORY_CHECK_INTERVAL_MS    5000
+
+/** 
+ * over a ceiling, we don't reclaim more often than this (ms). if live 
+ * data is over the ceiling, collecting again won't help.
+ */
+#define MEMORY_CEILING_INTERVAL_MS  60000
+
+/** what the dispatch loop should do about memory (see MemoryPolicy) */
+typedef enum {
+  MEMORY_ACTION_NONE = 0,
+  MEMORY_ACTION_IDLE,       // idle: evict stale cache entries, collect, trim
+  MEMORY_ACTION_SOFT,       // over the soft limit: the same, now
+  MEMORY_ACTION_HARD,       // over the hard limit: evict everything, collect, trim
+  MEMORY_ACTION_COUNT
+}
+MemoryAction;
+
+/**
+ * idle memory reclamation and RSS ceilings for the control processes. 
+ * languages don't give memory back on their own, so after a large one-off
+ * calculation the process stays big. 
+ *
+ * the dispatch loop calls Activity() when it runs a call and Check() every
+ * so often. Check() says what to do, if anything: once per idle period 
+ * (after idleReclaim seconds without calls), or when RSS is over a limit. 
+ * the loop does that in the language (evict cached objects, run a full
+ * collection), then calls ReturnMemory() and Record(). 
+ *
+ * RSS is the working set on windows. not thread safe; the dispatch loop 
+ * owns it.
+ */
+class MemoryPolicy {
+
+public:
+  MemoryPolicy();
+
+public:
+
+  /**
+   * read settings from the language's config section: idleReclaim 
+   * (seconds without calls, 0 for off), cacheTTL (seconds since a cached 
+   * object was last used), softLimit and hardLimit (RSS in MB, 0 for off)
+   */
+  void Configure(const json11::Json &config);
+
+  /** is anything on? if not, the loop doesn't need to check */
+  bool enabled() { return idle_ms_ || soft_limit_ || hard_limit_; }
+
+  /** the loop ran a call; restarts the idle clock */
+  void Activity();
+
+  /** has it been MEMORY_CHECK_INTERVAL_MS since the last check? */
+  bool Due();
+
+  /** check idle time and RSS, and return what to do */
+  MemoryAction Check();
+
+  /** 
+   * record what the loop did. rss is from before, elapsed includes the 
+   * collection, evicted is the number of cached objects released.
+   */
+  void Record(MemoryAction action, uint64_t rss_before, uint64_t elapsed_ms, uint32_t evicted);
+
+  /** cache ttl in seconds, 0 for none (idle and soft don't evict) */
+  uint32_t cache_ttl() { return cache_ttl_; }
+
+  /** telemetry: RSS (last and peak) and counts, time and bytes per action */
+  std::string Report();
+
+  /** resident set size in bytes (working set, on windows) */
+  static uint64_t ResidentBytes();
+
+  /** 
+   * give free heap pages back to the OS and trim the working set. run 
+   * the language's collector first, or there's nothing to give back.
+   */
+  static void ReturnMemory();
+
+protected:
+
+  /** monotonic clock, in ms */
+  static uint64_t Now();
+
+private:
+  uint64_t idle_ms_;
+  uint32_t cache_ttl_;
+  uint64_t soft_limit_;
+  uint64_t hard_limit_;
+
+  uint64_t last_activity_;
+  uint64_t last_check_;
+  uint64_t last_ceiling_;
+  bool idle_reclaimed_;
+
+  uint64_t last_rss_;
+  uint64_t peak_rss_;
+
+  typedef struct {
+    uint64_t count;
+    uint64_t total_ms;
+    uint64_t reclaimed_bytes;
+    uint64_t evicted;
+  }
+  Stats;
+
+  Stats stats_[MEMORY_ACTION_COUNT];
+
+};
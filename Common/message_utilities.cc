@@ -18,6 +18,9 @@
  */
  
 #include "message_utilities.h"
+#include "lz_codec.h"
+
+#include <vector>
 
 namespace MessageUtilities {
   
@@ -52,22 +55,218 @@ namespace MessageUtilities {
     return result;
   }
   
-  bool Unframe(google::protobuf::Message &message, const char *data, uint32_t len) {
-    int32_t bytes;
-    memcpy(reinterpret_cast<void*>(&bytes), data, sizeof(int32_t));
-    return message.ParseFromArray(data + sizeof(int32_t), bytes);
+  bool ReadFrameHeader(const char *data, uint32_t len, FrameHeader &header) {
+
+    uint32_t prefix;
+    if (len < sizeof(uint32_t)) return false;
+    memcpy(&prefix, data, sizeof(uint32_t));
+
+    if (prefix != FRAME_MAGIC) {
+      if (prefix & 0x80000000) return false;
+      header.magic = 0;
+      header.version = 1;
+      header.header_size = FRAME_V1_HEADER_SIZE;
+      header.flags = prefix & ~FRAME_LENGTH_MASK;
+      header.length = prefix & FRAME_LENGTH_MASK;
+      return true;
+    }
+
+    if (len < FRAME_V2_HEADER_SIZE) return false;
+    memcpy(&header, data, sizeof(FrameHeader));
+    return (header.version >= 2 && header.header_size >= FRAME_V2_HEADER_SIZE);
+  }
+
+  uint32_t FrameHeaderSize() {
+    return (FRAME_WRITE_VERSION == 1) ? FRAME_V1_HEADER_SIZE : FRAME_V2_HEADER_SIZE;
+  }
+
+  void WriteFrameHeader(char *target, uint32_t flags, uint32_t length) {
+    if (FRAME_WRITE_VERSION == 1) {
+      uint32_t prefix = (flags & ~FRAME_LENGTH_MASK) | (length & FRAME_LENGTH_MASK);
+      memcpy(target, &prefix, sizeof(uint32_t));
+    }
+    else {
+      FrameHeader header = { FRAME_MAGIC, FRAME_VERSION, FRAME_V2_HEADER_SIZE, flags, length };
+      memcpy(target, &header, sizeof(FrameHeader));
+    }
+  }
+
+  bool Unframe(google::protobuf::Message &message, const char *data, uint32_t len, SharedRing *ring) {
+
+    FrameHeader header;
+    if (!ReadFrameHeader(data, len, header)) return false;
+    if ((uint64_t)len < (uint64_t)header.header_size + header.length) return false;
+
+    const char *payload = data + header.header_size;
+
+    if (header.flags & FRAME_FLAG_SHARED_RING) {
+
+      uint64_t position;
+      uint32_t length;
+
+      if (!ring || !ring->valid() || header.length < sizeof(uint64_t) + sizeof(uint32_t)) return false;
+      memcpy(&position, payload, sizeof(uint64_t));
+      memcpy(&length, payload + sizeof(uint64_t), sizeof(uint32_t));
+
+      const char *ring_data = ring->Data(position, length);
+      if (!ring_data) return false;
+
+      bool result = message.ParseFromArray(ring_data, length);
+      ring->Release(position, length);
+      return result;
+    }
+
+    if (header.flags & FRAME_FLAG_COMPRESSED) {
+
+      uint32_t original_length;
+      if (header.length < sizeof(uint32_t)) return false;
+      memcpy(&original_length, payload, sizeof(uint32_t));
+
+      // the length comes from the sender, so don't trust it for the 
+      // allocation. nothing uncompressed can be longer than a frame.
+
+      if (original_length > FRAME_LENGTH_MASK) return false;
+
+      // the buffer is reused per thread, but (like the frame pool) we 
+      // don't hold on to anything larger than FRAME_POOL_MAX_BYTES; one 
+      // very large message shouldn't pin that much memory on the thread.
+
+      static thread_local std::vector<char> buffer;
+      if (buffer.size() < original_length) buffer.resize(original_length);
+
+      bool result = LZCodec::Decompress(payload + sizeof(uint32_t), header.length - sizeof(uint32_t), buffer.data(), original_length)
+        && message.ParseFromArray(buffer.data(), original_length);
+
+      if (buffer.size() > FRAME_POOL_MAX_BYTES) std::vector<char>().swap(buffer);
+      return result;
+    }
+
+    return message.ParseFromArray(payload, header.length);
   }
 
-  bool Unframe(google::protobuf::Message &message, const std::string &message_buffer) {
-    return Unframe(message, message_buffer.c_str(), (uint32_t)message_buffer.length());
+  bool Unframe(google::protobuf::Message &message, const std::string &message_buffer, SharedRing *ring) {
+    return Unframe(message, message_buffer.c_str(), (uint32_t)message_buffer.length(), ring);
   }
   
+  bool Frame(const google::protobuf::Message &message, std::string &target) {
+
+    // ByteSizeLong() caches sizes, so we can serialize without a stream
+
+    size_t bytes = message.ByteSizeLong();
+    if (bytes > FRAME_LENGTH_MASK) {
+      target.clear();
+      return false;
+    }
+
+    uint32_t header_size = FrameHeaderSize();
+
+    target.resize(header_size + bytes);
+    WriteFrameHeader(&(target[0]), 0, (uint32_t)bytes);
+    message.SerializeWithCachedSizesToArray(reinterpret_cast<google::protobuf::uint8*>(&(target[header_size])));
+    return true;
+
+  }
+
   std::string Frame(const google::protobuf::Message &message) {
-    int32_t bytes = message.ByteSize();
-    std::stringstream stream;
-    stream.write(reinterpret_cast<char*>(&bytes), sizeof(int32_t));
-    message.SerializeToOstream(dynamic_cast<std::ostream*>(&stream));
-    return stream.str();
+    std::string frame = AcquireFrameBuffer();
+    Frame(message, frame);
+    return frame;
+  }
+
+  static thread_local std::vector<std::string> frame_pool;
+
+  std::string AcquireFrameBuffer() {
+    std::string buffer;
+    if (frame_pool.size()) {
+      buffer.swap(frame_pool.back());
+      frame_pool.pop_back();
+    }
+    return buffer;
+  }
+
+  void ReleaseFrameBuffer(std::string &buffer) {
+    if (buffer.capacity() && buffer.capacity() <= FRAME_POOL_MAX_BYTES && frame_pool.size() < FRAME_POOL_COUNT) {
+      buffer.clear();
+      frame_pool.push_back(std::string());
+      frame_pool.back().swap(buffer);
+    }
+    else std::string().swap(buffer);
+  }
+
+  std::string Frame(const google::protobuf::Message &message, SharedRing *ring, uint32_t threshold) {
+
+    if (!ring || !ring->valid()) return Frame(message);
+
+    // the descriptor has a 32-bit length, but keep to the same limit as 
+    // a regular frame; past that, Frame() refuses the message.
+
+    size_t bytes = message.ByteSizeLong();
+    if (bytes < threshold || bytes > FRAME_LENGTH_MASK) return Frame(message);
+
+    uint32_t length = (uint32_t)bytes;
+
+    uint64_t position;
+    char *ring_data = ring->Reserve(length, position);
+    if (!ring_data) return Frame(message); // full, fall back to pipe
+
+    // ByteSizeLong() cached the sizes, so we can serialize in place
+
+    message.SerializeWithCachedSizesToArray(reinterpret_cast<google::protobuf::uint8*>(ring_data));
+    ring->Commit(position, length);
+
+    uint32_t header_size = FrameHeaderSize();
+
+    std::string descriptor;
+    descriptor.resize(header_size + sizeof(uint64_t) + sizeof(uint32_t));
+    WriteFrameHeader(&(descriptor[0]), FRAME_FLAG_SHARED_RING, sizeof(uint64_t) + sizeof(uint32_t));
+    memcpy(&(descriptor[header_size]), &position, sizeof(uint64_t));
+    memcpy(&(descriptor[header_size + sizeof(uint64_t)]), &length, sizeof(uint32_t));
+    return descriptor;
+  }
+
+  bool CompressFrame(std::string &frame, uint32_t threshold) {
+
+    FrameHeader header;
+    if (!threshold || !ReadFrameHeader(frame.c_str(), (uint32_t)frame.length(), header)) return false;
+    if (header.length < threshold || (header.flags & (FRAME_FLAG_SHARED_RING | FRAME_FLAG_COMPRESSED))) return false;
+    if (frame.length() < (size_t)header.header_size + header.length) return false;
+
+    uint32_t original_length = header.length;
+    uint32_t header_size = FrameHeaderSize();
+    size_t prefix = header_size + sizeof(uint32_t);
+
+    std::string compressed;
+    compressed.resize(prefix + LZCodec::Bound(original_length));
+
+    size_t length = LZCodec::Compress(frame.c_str() + header.header_size, original_length, &(compressed[prefix]), compressed.length() - prefix);
+    if (!length || length + sizeof(uint32_t) > original_length - (original_length / 8)) return false;
+
+    compressed.resize(prefix + length);
+
+    WriteFrameHeader(&(compressed[0]), header.flags | FRAME_FLAG_COMPRESSED, (uint32_t)(length + sizeof(uint32_t)));
+    memcpy(&(compressed[header_size]), &original_length, sizeof(uint32_t));
+
+    frame.swap(compressed);
+    return true;
+  }
+
+  void SetFrameFlags(std::string &frame, uint32_t flags) {
+    FrameHeader header;
+    if (!ReadFrameHeader(frame.c_str(), (uint32_t)frame.length(), header)) return;
+    if (header.version == 1) {
+      uint32_t prefix = header.flags | header.length | (flags & ~FRAME_LENGTH_MASK);
+      memcpy(&(frame[0]), &prefix, sizeof(uint32_t));
+    }
+    else {
+      header.flags |= flags;
+      memcpy(&(frame[0]), &header, sizeof(FrameHeader));
+    }
+  }
+
+  uint32_t FrameFlags(const char *data, uint32_t len) {
+    FrameHeader header;
+    if (!ReadFrameHeader(data, len, header)) return 0;
+    return header.flags;
   }
 
 #ifdef INCLUDE_DUMP_JSON
@@ -23,6 +23,7 @@
 #include <sstream>
 
 #include "variable.pb.h"
+#include "shared_ring.h"
 
 // #define INCLUDE_DUMP_JSON
 
@@ -34,6 +35,93 @@
  * common utilities for protocol buffer messages
  */
 
+/**
+ * frame flags. in v1 frames these are carried in the high bits of the 
+ * length prefix; v2 frames have a separate flags field (same values).
+ * a shared-ring frame carries a descriptor (position, length) instead 
+ * of the message; the message itself is in the shared ring.
+ */
+#define FRAME_FLAG_SHARED_RING    0x40000000
+#define FRAME_FLAG_STREAM         0x20000000
+#define FRAME_FLAG_COMPRESSED     0x10000000
+#define FRAME_LENGTH_MASK         0x0fffffff
+
+/**
+ * v1 frames have a 4-byte prefix (length and flags). v2 frames start with
+ * a header (FrameHeader). a v1 prefix never has the top bit set, so the
+ * magic (which does) tells them apart. readers accept both; writers use
+ * FRAME_WRITE_VERSION. the console still writes v1.
+ */
+#define FRAME_MAGIC               0xB2B2B2B2
+#define FRAME_VERSION             2
+#define FRAME_V1_HEADER_SIZE      4
+#define FRAME_V2_HEADER_SIZE      16
+
+/** version for frames we write (1 or 2) */
+#define FRAME_WRITE_VERSION       2
+
+/** 
+ * v2 frame header, little-endian. header_size is the offset of the 
+ * payload, so later versions can extend the header.
+ */
+struct FrameHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size;
+  uint32_t flags;
+  uint32_t length;
+};
+
+/**
+ * a streamed response is a header (the array shape and names, no data)
+ * followed by chunks of data in column-major order, all with the same id.
+ * every frame except the last carries FRAME_FLAG_STREAM. this is the 
+ * default chunk size, in cells.
+ */
+#define STREAM_CHUNK_CELLS        (16 * 1024)
+
+/**
+ * a compressed frame has the original (serialized) length after the
+ * prefix, then the message compressed with LZCodec. compression is 
+ * negotiated per connection; this is the default minimum message size.
+ * we only keep the compressed version if it saves at least 1/8.
+ */
+#define COMPRESSION_THRESHOLD     (32 * 1024)
+
+/**
+ * frame buffers are pooled per thread (see AcquireFrameBuffer). this is 
+ * the number of buffers we keep, and the largest buffer we'll keep.
+ */
+#define FRAME_POOL_COUNT          16
+#define FRAME_POOL_MAX_BYTES      (1024 * 1024)
+
+/** 
+ * messages smaller than this go over the pipe even if there's a ring;
+ * the descriptor round trip isn't worth it.
+ */
+#define SHARED_RING_THRESHOLD     (64 * 1024)
+
+/**
+ * function flags (FunctionDescriptor.flags, CompositeFunctionCall.flags). 
+ * the language sets these when it lists functions, and gets them back on 
+ * calls. mapped is R-specific (see UseEnvironment). thread-safe functions
+ * are registered for multithreaded recalc. async functions use excel's
+ * async protocol: they return at once and the result is posted later.
+ */
+#define FUNCTION_FLAG_MAPPED      0x01
+#define FUNCTION_FLAG_THREAD_SAFE 0x02
+#define FUNCTION_FLAG_ASYNC       0x04
+
+/**
+ * vectorized functions take vectors and return one result per element, 
+ * so a batch can be a single call. the batch flag is set by BERT (not 
+ * the language) on a call that carries several calls to one function: 
+ * each argument is an array of one call's arguments, and the result is
+ * an array with one result per call. see CallBatcher.
+ */
+#define FUNCTION_FLAG_VECTORIZED  0x08
+#define FUNCTION_FLAG_BATCH       0x10
+
 namespace MessageUtilities {
 
   typedef enum {
@@ -62,19 +150,82 @@ namespace MessageUtilities {
   TypeFlags CheckArrayType(const BERTBuffers::Array &arr, bool allow_nil = true, bool allow_missing = true);
 
   /**
-   * unframe and return message
+   * unframe and return message. if the frame is a shared-ring descriptor,
+   * the message is parsed from the ring (which must be passed) and then 
+   * released. compressed frames are decompressed (into a per-thread 
+   * buffer) and then parsed. fails if the frame is shorter than the 
+   * length in its header, or if a compressed frame claims to expand past 
+   * the frame limit.
    */
-  bool Unframe(google::protobuf::Message &message, const char *data, uint32_t len);
+  bool Unframe(google::protobuf::Message &message, const char *data, uint32_t len, SharedRing *ring = 0);
 
   /**
    * unframe passed string
    */
-  bool Unframe(google::protobuf::Message &message, const std::string &message_buffer);
+  bool Unframe(google::protobuf::Message &message, const std::string &message_buffer, SharedRing *ring = 0);
 
   /**
-   * frame and return string
+   * read a frame header, v1 or v2. for v1 the fields are filled in from 
+   * the prefix (version 1, header size 4). returns false if there's not
+   * enough data for the header, or it's not a header we understand.
+   */
+  bool ReadFrameHeader(const char *data, uint32_t len, FrameHeader &header);
+
+  /** size of the header we write (see FRAME_WRITE_VERSION) */
+  uint32_t FrameHeaderSize();
+
+  /** 
+   * write a frame header (see FRAME_WRITE_VERSION) for a payload of the 
+   * given length. there must be FrameHeaderSize() bytes at target.
+   */
+  void WriteFrameHeader(char *target, uint32_t flags, uint32_t length);
+
+  /**
+   * frame and return string. this serializes directly into the result,
+   * which comes from the frame buffer pool and is sized up front. the 
+   * result is empty if the message is too large for a frame.
    */
   std::string Frame(const google::protobuf::Message &message);
+
+  /**
+   * frame into target, reusing its capacity. callers that frame a lot 
+   * (in a loop) can hold on to a buffer and avoid allocating. returns 
+   * false, and leaves target empty, if the message is larger than 
+   * FRAME_LENGTH_MASK (the length won't fit in the header).
+   */
+  bool Frame(const google::protobuf::Message &message, std::string &target);
+
+  /**
+   * frame, using the shared ring if the message is large enough and there's
+   * room. in that case the message is serialized directly into the ring and 
+   * the returned frame is a descriptor. otherwise it's a regular frame.
+   */
+  std::string Frame(const google::protobuf::Message &message, SharedRing *ring, uint32_t threshold = SHARED_RING_THRESHOLD);
+
+  /**
+   * compress a frame in place, if it's at least threshold bytes and it 
+   * compresses well enough. shared-ring descriptors are left alone. 
+   * returns true if the frame was compressed.
+   */
+  bool CompressFrame(std::string &frame, uint32_t threshold = COMPRESSION_THRESHOLD);
+
+  /**
+   * get a buffer from this thread's pool (or a new one, if the pool is 
+   * empty). the buffer is empty but may have capacity.
+   */
+  std::string AcquireFrameBuffer();
+
+  /**
+   * return a buffer to this thread's pool, once the data has been sent.
+   * the buffer is left empty. very large buffers are just released.
+   */
+  void ReleaseFrameBuffer(std::string &buffer);
+
+  /** set flag bits in the prefix of a framed message */
+  void SetFrameFlags(std::string &frame, uint32_t flags);
+
+  /** get flag bits from the prefix of a framed message */
+  uint32_t FrameFlags(const char *data, uint32_t len);
   
 #ifdef INCLUDE_DUMP_JSON
 
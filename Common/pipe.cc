@@ -19,9 +19,148 @@
  
 #include "pipe.h"
 
+#include <chrono>
+
+HANDLE Pipe::pipe_handle() { return handle_; }
+
+DWORD Pipe::buffer_size() { return buffer_size_; }
+
+void Pipe::QueueWrites(FrameQueue &queue) {
+  write_stack_.Take(queue);
+}
+
+void Pipe::SetQueueLimit(size_t max_bytes, QueuePolicy policy, FrameQueue::MarkerFunction marker) {
+  write_stack_.set_marker(marker);
+  write_stack_.SetLimit(max_bytes, policy);
+}
+
+void Pipe::PushWrite(std::string message, FrameClass frame_class, size_t group) {
+  bool wait = write_stack_.Push(std::move(message), frame_class, group);
+  NextWrite();
+  if (wait) WaitWrites(write_stack_.max_bytes());
+}
+
+static uint64_t MonotonicMilliseconds() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Pipe::SetCoalescing(size_t max_bytes, uint32_t flush_window_ms) {
+  coalesce_bytes_ = max_bytes;
+  flush_window_ = flush_window_ms;
+}
+
+void Pipe::QueueWrite(std::string message, FrameClass frame_class, size_t group) {
+
+  if (!coalesce_bytes_) {
+    PushWrite(std::move(message), frame_class, group);
+    return;
+  }
+
+  if (write_stack_.Push(std::move(message), frame_class, group)) {
+    WaitWrites(write_stack_.max_bytes());
+    return;
+  }
+
+  // flush on size, or if the oldest deferred frame has waited long enough.
+  // checking age here (and not just on a timer) keeps steady output flowing
+  // while the caller is busy and not running its loop.
+
+  uint64_t now = MonotonicMilliseconds();
+  if (!deferred_since_) deferred_since_ = now;
+
+  if (write_stack_.bytes() >= coalesce_bytes_ || now - deferred_since_ >= flush_window_) NextWrite();
+}
+
+int64_t Pipe::FlushTimeout() {
+  if (!deferred_since_ || !write_stack_.size()) return -1;
+  uint64_t elapsed = MonotonicMilliseconds() - deferred_since_;
+  return elapsed >= flush_window_ ? 0 : (int64_t)(flush_window_ - elapsed);
+}
+
+int Pipe::Flush() {
+  return NextWrite();
+}
+
+void Pipe::FillWriteBuffer() {
+
+  size_t frames = 0;
+
+  // the last write is done, so its buffer can go back to the pool
+
+  MessageUtilities::ReleaseFrameBuffer(write_buffer_);
+
+  // simple case: take the front frame without copying
+
+  if (!coalesce_bytes_ || write_stack_.size() == 1 || write_stack_.front().length() >= coalesce_bytes_) {
+    write_stack_.PopFront(write_buffer_);
+    frames = 1;
+  }
+  else {
+    std::string message;
+    write_buffer_ = MessageUtilities::AcquireFrameBuffer();
+    while (write_stack_.size()) {
+      if (frames && write_buffer_.length() + write_stack_.front().length() > coalesce_bytes_) break;
+      write_stack_.PopFront(message);
+      write_buffer_.append(message);
+      MessageUtilities::ReleaseFrameBuffer(message);
+      frames++;
+    }
+  }
+
+  // anything left will go out when this write completes
+  deferred_since_ = 0;
+
+  write_count_++;
+  frame_count_ += frames;
+  byte_count_ += write_buffer_.length();
+
+}
+
+std::string Pipe::WriteStats() {
+  std::stringstream ss;
+  ss << "writes: " << write_count_ << ", frames: " << frame_count_ << ", bytes: " << byte_count_;
+  if (write_count_) ss << ", frames/write: " << ((double)frame_count_ / write_count_);
+  return ss.str();
+}
+
+void Pipe::ClearError() {
+  error_ = false;
+}
+
+DWORD Pipe::Read(std::string &buffer, bool block) {
+  DWORD result = ReadMessage(block);
+  if (!result) reader_.Assign(buffer);
+  return result;
+}
+
+bool Pipe::ParseMessage(google::protobuf::Message &message, SharedRing *ring) {
+  return reader_.Parse(message, ring);
+}
+
+#ifdef _WIN32
+
+#include "windows_api_functions.h"
+
+#include <set>
+#include <mutex>
+
+/** 
+ * names we've created pipes for. the first instance of a name is created 
+ * with FILE_FLAG_FIRST_PIPE_INSTANCE, so if some other process already 
+ * has a pipe by that name we fail instead of adding to it.
+ */
+static std::set<std::string> pipe_names;
+static std::mutex pipe_names_lock;
+
 Pipe::Pipe()
   : buffer_size_(DEFAULT_BUFFER_SIZE)
-  , read_buffer_(0)
+  , coalesce_bytes_(0)
+  , flush_window_(0)
+  , deferred_since_(0)
+  , write_count_(0)
+  , frame_count_(0)
+  , byte_count_(0)
   , reading_(false)
   , writing_(false)
   , connected_(false)
@@ -29,40 +168,20 @@ Pipe::Pipe()
 }
 
 Pipe::~Pipe() {
-  if (read_buffer_) delete read_buffer_;
 }
 
-HANDLE Pipe::pipe_handle() { return handle_; }
-
 HANDLE Pipe::wait_handle_read() { return read_io_.hEvent; }
 
 HANDLE Pipe::wait_handle_write() { return write_io_.hEvent; }
 
-DWORD Pipe::buffer_size() { return buffer_size_; }
-
-void Pipe::QueueWrites(std::vector<std::string> &list) {
-  for (auto entry : list) {
-    write_stack_.push_back(entry);
-  }
-}
-
-void Pipe::PushWrite(const std::string &message) {
-  write_stack_.push_back(message);
-  NextWrite();
-}
-
 int Pipe::StartRead() {
   if (reading_ || error_ || !connected_) return 0;
   reading_ = true;
   ResetEvent(read_io_.hEvent);
-  ReadFile(handle_, read_buffer_, buffer_size_, 0, &read_io_);
+  ReadFile(handle_, reader_.read_pointer(), reader_.read_size(), 0, &read_io_);
   return 0;
 }
 
-void Pipe::ClearError() {
-  error_ = false;
-}
-
 void Pipe::Connect(bool start_read) {
   connected_ = true;
   std::cout << "pipe connected (" << name_ << ")" << std::endl;
@@ -77,7 +196,7 @@ DWORD Pipe::Reset() {
   DisconnectNamedPipe(handle_);
 
   connected_ = reading_ = writing_ = error_ = false;
-  message_buffer_.clear();
+  reader_.Clear();
 
   if (ConnectNamedPipe(handle_, &read_io_)) {
     std::cerr << "ERR in connectNamedPipe" << std::endl;
@@ -99,16 +218,19 @@ DWORD Pipe::Reset() {
   return 0;
 }
 
+void Pipe::WaitWrites(size_t max_bytes) {
+  NextWrite();
+  while (writing_ && !error_ && write_stack_.bytes() > max_bytes) {
+    WaitForSingleObject(write_io_.hEvent, INFINITE);
+    NextWrite();
+  }
+}
+
 int Pipe::NextWrite() {
 
   DWORD bytes, result;
 
-  if (write_stack_.size() == 0) {
-    ResetEvent(write_io_.hEvent);
-    writing_ = false;
-    return 0; // no write
-  }
-  else if (writing_) {
+  if (writing_) {
 
     // if we are currently in a write operation, 
     // check if it's complete.
@@ -128,17 +250,23 @@ int Pipe::NextWrite() {
         return 0; // err (need a flag here)
       }
     }
+    writing_ = false;
+  }
+
+  if (write_stack_.size() == 0) {
+    ResetEvent(write_io_.hEvent);
+    return 0; // no write
   }
 
   // at this point we're safe to write. we can push more than
-  // one write if they complete immediately
+  // one write if they complete immediately. the write buffer is
+  // a member because it has to outlive a pending (overlapped) write.
 
   while (write_stack_.size()) {
 
     ResetEvent(write_io_.hEvent);
-    std::string message = write_stack_.front();
-    write_stack_.pop_front();
-    WriteFile(handle_, message.c_str(), (DWORD)message.length(), NULL, &write_io_);
+    FillWriteBuffer();
+    WriteFile(handle_, write_buffer_.c_str(), (DWORD)write_buffer_.length(), NULL, &write_io_);
     //result = GetOverlappedResultEx(handle_, &write_io_, &bytes, 0, FALSE);
     result = GetOverlappedResult(handle_, &write_io_, &bytes, FALSE);
     if (result) {
@@ -156,37 +284,25 @@ int Pipe::NextWrite() {
   return 1;
 }
 
-DWORD Pipe::Read(std::string &buf, bool block) {
+DWORD Pipe::ReadMessage(bool block) {
 
-  // FIXME: what happens in message mode when the buffer is too small? 
-  //
-  // Docs:
-  // In this situation, GetLastError returns ERROR_MORE_DATA, and the client can read the 
-  // remainder of the message using additional calls to ReadFile.
-  // 
-
-  // that implies we will need to hold on to the buffer.
+  // in message mode, if the message is larger than the read we get 
+  // ERROR_MORE_DATA and read the rest with additional calls. the frame 
+  // reader holds on to the partial message and sizes the next read.
 
   DWORD bytes = 0;
 //  DWORD success = GetOverlappedResultEx(handle_, &read_io_, &bytes, block ? INFINITE : 0, FALSE);
   DWORD success = GetOverlappedResult(handle_, &read_io_, &bytes, block ? TRUE : FALSE);
 
   if (success) {
-    if (message_buffer_.length()) {
-      // std::cout << "appending long mesage (" << bytes << "), this is the end" << std::endl;
-      buf = message_buffer_;
-      buf.append(read_buffer_, bytes);
-      message_buffer_.clear();
-    }
-    else buf.assign(read_buffer_, bytes);
+    reader_.Complete(bytes, false);
     reading_ = false;
     return 0;
   }
   else {
     DWORD err = GetLastError();
     if (err == ERROR_MORE_DATA) {
-      // std::cout << "appending long mesage (" << bytes << "), this is a chunk" << std::endl;
-      message_buffer_.append(read_buffer_, bytes);
+      reader_.Complete(bytes, true);
       reading_ = false;
       StartRead();
       return err;
@@ -203,29 +319,70 @@ std::string Pipe::full_name() {
   return pipename.str().c_str();
 }
 
-DWORD Pipe::Start(std::string name, bool wait) {
+DWORD Pipe::Open(std::string name) {
+
+  name_ = name;
+
+  handle_ = CreateFileA(full_name().c_str(), GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, 0);
+  if (!handle_ || handle_ == INVALID_HANDLE_VALUE) return GetLastError();
+
+  DWORD mode = PIPE_READMODE_MESSAGE;
+  SetNamedPipeHandleState(handle_, &mode, 0, 0);
+
+  memset(&read_io_, 0, sizeof(read_io_));
+  memset(&write_io_, 0, sizeof(write_io_));
+
+  read_io_.hEvent = CreateEvent(0, TRUE, FALSE, 0);
+  write_io_.hEvent = CreateEvent(0, TRUE, FALSE, 0);
+
+  error_ = false;
+
+  Connect(false);
+  return 0;
+}
+
+DWORD Pipe::Start(std::string name, bool wait, bool signal_ready) {
 
   name_ = name;
 
+  bool first;
+  {
+    std::lock_guard<std::mutex> lock(pipe_names_lock);
+    first = pipe_names.insert(name).second;
+  }
+
+  // only this user can open the pipe. pipe names are visible across 
+  // sessions, and the default DACL lets everyone read.
+
+  SECURITY_ATTRIBUTES attributes = { sizeof(SECURITY_ATTRIBUTES), 0, FALSE };
+  attributes.lpSecurityDescriptor = APIFunctions::CurrentUserDescriptor();
+  if (!attributes.lpSecurityDescriptor) std::cerr << "pipe security descriptor failed (" << GetLastError() << "), using default" << std::endl;
+
   handle_ = CreateNamedPipeA(full_name().c_str(),
-    PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
-    PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
-    MAX_PIPE_COUNT,
+    PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | (first ? FILE_FLAG_FIRST_PIPE_INSTANCE : 0),
+    PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS,
+    MAX_SHARED_PIPE_COUNT,
     DEFAULT_BUFFER_SIZE,
     DEFAULT_BUFFER_SIZE,
     100,
-    NULL);
+    attributes.lpSecurityDescriptor ? &attributes : NULL);
+
+  DWORD err = GetLastError();
+  if (attributes.lpSecurityDescriptor) LocalFree(attributes.lpSecurityDescriptor);
 
   if (NULL == handle_ || handle_ == INVALID_HANDLE_VALUE) {
-    std::cerr << "create pipe failed" << std::endl;
+    if (first) {
+      std::lock_guard<std::mutex> lock(pipe_names_lock);
+      pipe_names.erase(name);
+    }
+    if (first && err == ERROR_ACCESS_DENIED) std::cerr << "create pipe failed: " << name << " is in use by another process" << std::endl;
+    else std::cerr << "create pipe failed (" << err << ")" << std::endl;
     return -1;
   }
 
   read_io_.hEvent = CreateEvent(0, TRUE, FALSE, 0);
   write_io_.hEvent = CreateEvent(0, TRUE, FALSE, 0);
 
-  read_buffer_ = new char[buffer_size_];
-  
   if (ConnectNamedPipe(handle_, &read_io_)) {
     std::cerr << "ERR in connectNamedPipe" << std::endl;
   }
@@ -243,6 +400,10 @@ DWORD Pipe::Start(std::string name, bool wait) {
     }
   }
 
+  // the pipe is listening, so the parent can connect now
+
+  if (signal_ready) APIFunctions::SignalReady(name);
+
   if (!wait) return 0;
 
   while (true) {
@@ -272,5 +433,4 @@ DWORD Pipe::Start(std::string name, bool wait) {
   return -2;
 }
 
-
-
+#endif // #ifdef _WIN32
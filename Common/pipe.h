@@ -25,10 +25,21 @@
 #include <sstream>
 #include <iostream>
 
+#include "frame_reader.h"
+#include "frame_queue.h"
+
+#ifdef _WIN32
+
 #include <SDKDDKVer.h>
 #include <windows.h>
 #include <process.h>
 
+#else // #ifdef _WIN32
+
+#include "posix_compat.h"
+
+#endif // #ifdef _WIN32
+
 /**
  * FIXME:
  *
@@ -38,6 +49,12 @@
  * (2) if this becomes cross-platform we probably have to do more packet management.
  *     we can merge in the PB framing we are already doing (but maybe add
  *     signifier/magic header?)
+ *
+ * UPDATE: there are now two transports behind this interface. on windows
+ * it's overlapped named pipes in message mode (pipe.cc). everywhere else it's
+ * unix domain sockets in SOCK_SEQPACKET mode (pipe_posix.cc), which also
+ * preserves message boundaries. on posix the wait handles are file descriptors,
+ * meant to be registered with an EventLoop (event_loop.h).
  */
 
 #define DEFAULT_BUFFER_SIZE (8 * 1024)
@@ -45,25 +62,66 @@
  // we really only need 2 connections, except for dev/debug
 #define MAX_PIPE_COUNT  4
 
+ // a shared server has a client pipe and a callback pipe for each client. 
+ // this is also the instance limit for every pipe (it has to be the same
+ // for all instances of a name), and it keeps the dispatch loop's handles 
+ // (2 per pipe) under the wait limit.
+#define MAX_SHARED_PIPE_COUNT  24
+
 class Pipe {
 
 private:
   HANDLE handle_;
-  OVERLAPPED read_io_;
-  OVERLAPPED write_io_;
   DWORD buffer_size_;
   std::string name_;
 
-  /** read buffer is a single read, limited to pipe buffer size */
-  char *read_buffer_;
+#ifdef _WIN32
 
-  /**
-   * message buffer is for messages that exceed the read buffer size, they're
-   * constructed over multiple reads
+  OVERLAPPED read_io_;
+  OVERLAPPED write_io_;
+
+#else // #ifdef _WIN32
+
+  /** listening socket, shared between instances with the same name */
+  int listen_fd_;
+
+  /** offset into the front of the write stack, for partial writes */
+  size_t write_offset_;
+
+#endif // #ifdef _WIN32
+
+  /** 
+   * reads go into the frame reader's buffer. messages that exceed a single
+   * read are sized from the frame prefix and completed in place.
+   */
+  FrameReader reader_;
+
+  /** 
+   * frames waiting to be written. this can be bounded (see SetQueueLimit);
+   * by default it's not.
+   */
+  FrameQueue write_stack_;
+
+  /** data for the write in progress (one or more frames) */
+  std::string write_buffer_;
+
+  /** 
+   * coalescing: if non-zero, queued frames are packed into a single write 
+   * up to this many bytes. note that the reader has to be able to split
+   * frames out of a single message (the console can, BERT can't).
    */
-  std::string message_buffer_;
+  size_t coalesce_bytes_;
+
+  /** deferred writes are held at most this long (ms) */
+  uint32_t flush_window_;
 
-  std::deque<std::string> write_stack_;
+  /** time (ms) the oldest deferred frame was queued, or 0 */
+  uint64_t deferred_since_;
+
+  /** counters */
+  uint64_t write_count_;
+  uint64_t frame_count_;
+  uint64_t byte_count_;
 
   bool connected_;
   bool reading_;
@@ -84,19 +142,98 @@ public:
   /** accessor */
   bool error() { return error_; }
 
-  /** create pipe, accept connection and optionally block */
-  DWORD Start(std::string name, bool wait);
+  /** 
+   * create pipe, accept connection and optionally block. if signal_ready
+   * is set, we tell the parent process the pipe exists (before blocking),
+   * see APIFunctions::SignalReady. on posix there's no ready event; the 
+   * flag is ignored.
+   *
+   * on windows only the current user can open the pipe, and it's local 
+   * only. if another process already has a pipe with this name, this 
+   * fails (returns non-zero).
+   */
+  DWORD Start(std::string name, bool wait, bool signal_ready = false);
 
   /** we have a notification about connection, do any housekeeping */
   void Connect(bool start_read = true);
 
+  /** 
+   * client side: connect to an existing pipe (created by somebody else 
+   * calling Start). does not block beyond the connect call itself.
+   */
+  DWORD Open(std::string name);
+
   //DWORD BlockingRead(std::string &buf);
 
 
+  /** 
+   * read a message and copy it into buffer. returns 0 on success, 
+   * ERROR_MORE_DATA if the message is incomplete (a read is restarted),
+   * or another error.
+   */
   DWORD Read(std::string &buffer, bool block = false);
 
-  void PushWrite(const std::string &message);
-  void QueueWrites(std::vector<std::string> &list);
+  /**
+   * same as Read, but leaves the message in the reader. use ParseMessage
+   * to parse it in place (no copy).
+   */
+  DWORD ReadMessage(bool block = false);
+
+  /** parse the last message read, in place. see MessageUtilities::Unframe */
+  bool ParseMessage(google::protobuf::Message &message, SharedRing *ring = 0);
+
+  /** 
+   * turn off framing for pipes that carry raw data (text). this only affects
+   * how the read buffer is sized for large messages. 
+   */
+  void set_framed(bool framed) { reader_.set_framed(framed); }
+
+  /** 
+   * queue a message and write immediately (along with anything already queued).
+   * the frame class and group are used if the queue has the drop policy; with
+   * the block policy, this waits if the queue is over its limit. the message
+   * is moved into the queue, so pass temporaries to avoid a copy.
+   */
+  void PushWrite(std::string message, FrameClass frame_class = FRAME_CLASS_CONTROL, size_t group = 0);
+
+  /** move frames from another queue (frames buffered before we connected) */
+  void QueueWrites(FrameQueue &queue);
+
+  /**
+   * queue a message under the flush policy. if coalescing is off, this is the
+   * same as PushWrite. otherwise the write is deferred until the queue reaches
+   * the size cap or the oldest deferred frame is older than the flush window.
+   * the caller should call Flush() when FlushTimeout() says so, so the tail 
+   * doesn't get stuck.
+   */
+  void QueueWrite(std::string message, FrameClass frame_class = FRAME_CLASS_CONTROL, size_t group = 0);
+
+  /** 
+   * bound the write queue. with the block policy, producers wait for the 
+   * reader; with the drop policy, droppable frames are discarded. see 
+   * FrameQueue. max_bytes of 0 is unbounded (the default). the marker 
+   * function creates frames that stand in for dropped text.
+   */
+  void SetQueueLimit(size_t max_bytes, QueuePolicy policy, FrameQueue::MarkerFunction marker = nullptr);
+
+  /** 
+   * set the flush policy. max_bytes of 0 turns coalescing off (one frame 
+   * per write, the default).
+   */
+  void SetCoalescing(size_t max_bytes, uint32_t flush_window_ms);
+
+  /** ms until deferred writes should be flushed, 0 if overdue, -1 if none */
+  int64_t FlushTimeout();
+
+  /** write anything deferred */
+  int Flush();
+
+  /**
+   * block until no more than max_bytes are waiting behind the write in 
+   * progress. this is for producers that generate a lot of data in one 
+   * go (streamed results), so the queue doesn't hold the whole thing.
+   */
+  void WaitWrites(size_t max_bytes);
 
   /**
    * returns non-zero if data was written (without considering whether
@@ -125,6 +262,29 @@ public:
   /** accessor */
   HANDLE pipe_handle();
 
+  /** accessor: number of write calls */
+  uint64_t write_count() { return write_count_; }
+
+  /** accessor: number of frames written */
+  uint64_t frame_count() { return frame_count_; }
+
+  /** accessor: bytes written */
+  uint64_t byte_count() { return byte_count_; }
+
+  /** counters as a string, for logging */
+  std::string WriteStats();
+
+  /** write queue metrics (high water, drops) as a string, for logging */
+  std::string QueueStats() { return write_stack_.Stats(); }
+
+protected:
+
+  /** 
+   * move the next write (one frame, or as many as fit under the coalescing
+   * cap) from the write stack into the write buffer, and update counters.
+   */
+  void FillWriteBuffer();
+
 public:
   Pipe();
   ~Pipe();
@@ -0,0 +1,440 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _WIN32
+
+#include "pipe.h"
+
+#include <map>
+#include <mutex>
+#include <cstdlib>
+#include <cstring>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+
+/**
+ * posix implementation of the pipe interface, using unix domain sockets in
+ * SOCK_SEQPACKET mode. seqpacket preserves record boundaries, but a record 
+ * has to fit in the receiver's buffer (unlike a message-mode pipe, which 
+ * returns ERROR_MORE_DATA). so messages are split into records of at most 
+ * buffer_size_ bytes, each with a single header byte that says whether more 
+ * records follow. the read side reassembles and returns ERROR_MORE_DATA for 
+ * partial messages, same as the windows version.
+ *
+ * everything is nonblocking; wait handles are file descriptors for use with
+ * poll/epoll (see event_loop.h).
+ */
+
+#define RECORD_FLAG_FINAL 0x00
+#define RECORD_FLAG_MORE  0x01
+
+/**
+ * listening sockets, by path. on windows each pipe instance is a separate
+ * object with the same name; here instances with the same name share one 
+ * listening socket and each accepts its own connection. refcounted so we 
+ * can unlink the socket file when the last instance goes away.
+ */
+static std::map<std::string, std::pair<int, int>> listeners;
+
+/** pipes can be created and destroyed on any thread */
+static std::mutex listeners_lock;
+
+/**
+ * directory for socket files: BERT_PIPE_DIR if it's set, then the user's 
+ * runtime directory, then a per-user directory in /tmp.
+ */
+static std::string PipeDirectory() {
+  const char *directory = getenv("BERT_PIPE_DIR");
+  if (!directory || !directory[0]) directory = getenv("XDG_RUNTIME_DIR");
+  if (directory && directory[0]) return directory;
+  std::stringstream ss;
+  ss << "/tmp/bert-" << geteuid();
+  return ss.str();
+}
+
+/**
+ * check that the socket directory belongs to us and nobody else can get 
+ * into it (so nobody else can create, replace or connect to our sockets).
+ * the server creates it if it's missing; a client only checks.
+ */
+static bool PrivateDirectory(const std::string &directory, bool create) {
+
+  if (create && mkdir(directory.c_str(), 0700) < 0 && errno != EEXIST) {
+    std::cerr << "mkdir failed: " << directory << " (" << errno << ")" << std::endl;
+    return false;
+  }
+
+  struct stat info;
+  if (lstat(directory.c_str(), &info) < 0) return false;
+
+  if (!S_ISDIR(info.st_mode) || info.st_uid != geteuid() || (info.st_mode & 077)) {
+    std::cerr << "pipe directory is not private: " << directory << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static int AcquireListener(const std::string &path) {
+
+  std::lock_guard<std::mutex> lock(listeners_lock);
+
+  auto iter = listeners.find(path);
+  if (iter != listeners.end()) {
+    iter->second.second++;
+    return iter->second.first;
+  }
+
+  struct sockaddr_un address;
+  if (path.length() >= sizeof(address.sun_path)) {
+    std::cerr << "socket path too long: " << path << std::endl;
+    return -1;
+  }
+
+  int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  // a socket file can be left behind by a previous (crashed) process; 
+  // nothing is listening, so connecting is refused. if a connection goes
+  // through (or would block) there's a live server with this name, and
+  // we leave it alone. anything else, bind will report.
+
+  int probe = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (probe < 0) {
+    close(fd);
+    return -1;
+  }
+
+  int probe_error = connect(probe, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0 ? errno : 0;
+  close(probe);
+
+  if (!probe_error || probe_error == EAGAIN || probe_error == EINPROGRESS) {
+    std::cerr << "pipe name in use: " << path << std::endl;
+    close(fd);
+    return -1;
+  }
+
+  if (probe_error == ECONNREFUSED) unlink(path.c_str());
+
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0
+    || listen(fd, MAX_PIPE_COUNT) < 0) {
+    std::cerr << "bind/listen failed: " << path << " (" << errno << ")" << std::endl;
+    close(fd);
+    return -1;
+  }
+
+  listeners[path] = { fd, 1 };
+  return fd;
+}
+
+static void ReleaseListener(const std::string &path) {
+  std::lock_guard<std::mutex> lock(listeners_lock);
+  auto iter = listeners.find(path);
+  if (iter == listeners.end()) return;
+  if (--iter->second.second > 0) return;
+  close(iter->second.first);
+  unlink(path.c_str());
+  listeners.erase(iter);
+}
+
+Pipe::Pipe()
+  : handle_(INVALID_HANDLE_VALUE)
+  , buffer_size_(DEFAULT_BUFFER_SIZE)
+  , listen_fd_(-1)
+  , write_offset_(0)
+  , coalesce_bytes_(0)
+  , flush_window_(0)
+  , deferred_since_(0)
+  , write_count_(0)
+  , frame_count_(0)
+  , byte_count_(0)
+  , connected_(false)
+  , reading_(false)
+  , writing_(false)
+  , error_(false)
+{
+}
+
+Pipe::~Pipe() {
+  if (handle_ >= 0) close(handle_);
+  if (listen_fd_ >= 0) ReleaseListener(full_name());
+}
+
+/** 
+ * before a client connects, the read handle is the listening socket 
+ * (readable == pending connection), which maps to the connect event on 
+ * windows. after that it's the connection itself.
+ */
+HANDLE Pipe::wait_handle_read() { return handle_ >= 0 ? handle_ : listen_fd_; }
+
+HANDLE Pipe::wait_handle_write() { return handle_; }
+
+std::string Pipe::full_name() {
+  return PipeDirectory() + "/" + name_;
+}
+
+int Pipe::StartRead() {
+
+  // reads are readiness-based, so there's nothing to start. we keep 
+  // the flag for parity with callers that check it.
+
+  if (reading_ || error_ || !connected_) return 0;
+  reading_ = true;
+  return 0;
+}
+
+void Pipe::Connect(bool start_read) {
+
+  if (handle_ < 0) {
+    handle_ = accept4(listen_fd_, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (handle_ < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        std::cerr << "accept failed (" << errno << ")" << std::endl;
+        error_ = true;
+      }
+      return;
+    }
+  }
+
+  connected_ = true;
+  std::cout << "pipe connected (" << name_ << ")" << std::endl;
+  if (start_read) StartRead();
+}
+
+DWORD Pipe::Reset() {
+
+  if (handle_ >= 0) close(handle_);
+  handle_ = INVALID_HANDLE_VALUE;
+
+  reader_.Clear();
+  write_offset_ = 0;
+
+  connected_ = false;
+  writing_ = false;
+  reading_ = false;
+  error_ = false;
+
+  // the listening socket stays open; the next connection is picked
+  // up by Connect() when the listener is readable.
+
+  return 0;
+}
+
+DWORD Pipe::ReadMessage(bool block) {
+
+  if (block) {
+    struct pollfd pfd = { handle_, POLLIN, 0 };
+    while (poll(&pfd, 1, -1) < 0 && errno == EINTR);
+  }
+
+  // records are at most buffer_size_ (plus the header byte), and a record
+  // that doesn't fit is truncated, so make sure there's room for one.
+
+  reader_.Reserve(buffer_size_);
+
+  char header = RECORD_FLAG_FINAL;
+  struct iovec iov[2];
+  iov[0].iov_base = &header;
+  iov[0].iov_len = 1;
+  iov[1].iov_base = reader_.read_pointer();
+  iov[1].iov_len = reader_.read_size();
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = iov;
+  msg.msg_iovlen = 2;
+
+  ssize_t bytes = recvmsg(handle_, &msg, 0);
+
+  if (bytes < 0) {
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return WAIT_TIMEOUT;
+    std::cerr << "recvmsg failed (" << errno << ")" << std::endl;
+    error_ = true;
+    return ERROR_BROKEN_PIPE;
+  }
+
+  if (bytes == 0) {
+    // orderly shutdown from the other side
+    error_ = true;
+    return ERROR_BROKEN_PIPE;
+  }
+
+  // the writer never sends a record larger than the buffer size, so a 
+  // truncated record means the two sides disagree about the protocol (or
+  // the buffer size). the rest of the record is gone, so the stream can't
+  // be resynchronized; treat it as a broken connection.
+
+  if (msg.msg_flags & MSG_TRUNC) {
+    std::cerr << "record truncated, protocol error (" << name_ << ")" << std::endl;
+    error_ = true;
+    return ERROR_BROKEN_PIPE;
+  }
+
+  uint32_t length = static_cast<uint32_t>(bytes) - 1;
+  reading_ = false;
+
+  if (header == RECORD_FLAG_MORE) {
+    reader_.Complete(length, true);
+    StartRead();
+    return ERROR_MORE_DATA;
+  }
+
+  reader_.Complete(length, false);
+  return 0;
+}
+
+void Pipe::WaitWrites(size_t max_bytes) {
+  NextWrite();
+  while (writing_ && !error_ && write_stack_.bytes() > max_bytes) {
+    struct pollfd pfd = { handle_, POLLOUT, 0 };
+    while (poll(&pfd, 1, -1) < 0 && errno == EINTR);
+    NextWrite();
+  }
+}
+
+int Pipe::NextWrite() {
+
+  if (!writing_ && !write_stack_.size()) return 0;
+
+  while (writing_ || write_stack_.size()) {
+
+    // writing_ means the write buffer holds a partially-sent message
+    if (!writing_) {
+      FillWriteBuffer();
+      write_offset_ = 0;
+      writing_ = true;
+    }
+
+    // an empty message is still one (final) record
+    do {
+      size_t remaining = write_buffer_.length() - write_offset_;
+      size_t chunk = remaining > buffer_size_ ? buffer_size_ : remaining;
+      char header = (remaining > chunk) ? RECORD_FLAG_MORE : RECORD_FLAG_FINAL;
+
+      struct iovec iov[2];
+      iov[0].iov_base = &header;
+      iov[0].iov_len = 1;
+      iov[1].iov_base = const_cast<char*>(write_buffer_.c_str() + write_offset_);
+      iov[1].iov_len = chunk;
+
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = iov;
+      msg.msg_iovlen = 2;
+
+      ssize_t bytes = sendmsg(handle_, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+      if (bytes < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+          // wait for the write handle to become writable, then call again
+          return 0;
+        }
+        std::cerr << "sendmsg failed (" << errno << ")" << std::endl;
+        error_ = true;
+        writing_ = false;
+        return 0;
+      }
+
+      write_offset_ += chunk;
+
+    } while (write_offset_ < write_buffer_.length());
+
+    writing_ = false;
+  }
+
+  return 1;
+}
+
+DWORD Pipe::Open(std::string name) {
+
+  name_ = name;
+
+  struct sockaddr_un address;
+  std::string path = full_name();
+  if (path.length() >= sizeof(address.sun_path)) return ENAMETOOLONG;
+  if (!PrivateDirectory(PipeDirectory(), false)) return EACCES;
+
+  int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (fd < 0) return errno;
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0) {
+    DWORD err = errno;
+    close(fd);
+    return err;
+  }
+
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  handle_ = fd;
+
+  error_ = false;
+
+  Connect(false);
+  return 0;
+}
+
+DWORD Pipe::Start(std::string name, bool wait, bool /* signal_ready */) {
+
+  // there's no ready event on posix. clients can connect as soon as the
+  // listening socket is bound, which happens before we return (or block).
+
+  name_ = name;
+  std::string path = full_name();
+
+  if (!PrivateDirectory(PipeDirectory(), true)) return -1;
+
+  listen_fd_ = AcquireListener(path);
+  if (listen_fd_ < 0) {
+    std::cerr << "create socket failed: " << path << std::endl;
+    return -1;
+  }
+
+  error_ = false;
+
+  if (wait) {
+
+    // block until a client connects. as on windows, the caller still
+    // calls Connect() for housekeeping; the connection is already accepted.
+
+    struct pollfd pfd = { listen_fd_, POLLIN, 0 };
+    while (poll(&pfd, 1, -1) < 0 && errno == EINTR);
+
+    handle_ = accept4(listen_fd_, 0, 0, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (handle_ < 0) {
+      std::cerr << "accept failed (" << errno << ")" << std::endl;
+      return -1;
+    }
+  }
+
+  return 0;
+}
+
+#endif // #ifndef _WIN32
@@ -0,0 +1,44 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+/**
+ * minimal set of win32 names used by the shared (Common) interfaces, so
+ * that headers like pipe.h can be used unchanged on posix. this is not 
+ * an emulation layer; it only covers types and the error codes that callers
+ * switch on. values match the win32 definitions.
+ */
+
+#include <stdint.h>
+
+typedef int HANDLE;        // file descriptor
+typedef uint32_t DWORD;
+
+#define INVALID_HANDLE_VALUE  (-1)
+
+#define WAIT_TIMEOUT          258
+#define ERROR_BROKEN_PIPE     109
+#define ERROR_MORE_DATA       234
+#define ERROR_IO_PENDING      997
+#define ERROR_PIPE_CONNECTED  535
+
+#endif // #ifndef _WIN32
@@ -22,6 +22,7 @@
 
 #define PROCESS_ERROR_UNSUPPORTED_VERSION 100
 #define PROCESS_ERROR_CONFIGURATION_ERROR 101
+#define PROCESS_ERROR_PIPE_ERROR 102
 
 #endif // #ifndef __PROCESS_EXIT_CODES_H
 
@@ -0,0 +1,71 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * in-process host API. the R core (rinterface_common and friends) can be 
+ * built as a library (ControlRHost) instead of the controlR process, and 
+ * BERT can load it and call R directly, without the pipe round trip.
+ *
+ * calls and responses are serialized CallResponse messages (not framed).
+ * the library links its own copy of protobuf, so we can't pass message 
+ * objects across; serializing is cheap next to a pipe round trip.
+ *
+ * R is single-threaded. calls are serialized on a lock, and can come from
+ * any thread. there's no console and no callbacks into Excel; the host is
+ * for functions that don't need either (thread-safe functions). the 
+ * process is still the default, and handles everything else.
+ */
+
+#ifdef CONTROLR_HOST
+#define RHOST_EXPORT extern "C" __declspec(dllexport)
+#else
+#define RHOST_EXPORT extern "C" __declspec(dllimport)
+#endif
+
+/** receives console output (text is not null-terminated) */
+typedef void (*RHostConsoleFunction)(const char *text, int32_t length, int32_t flag);
+
+/** 
+ * start R. rhome is the R installation, bert_home is BERT's home directory 
+ * (for the config file). returns 0 on success, or a process error code 
+ * (see process_exit_codes.h). calling it again does nothing.
+ */
+RHOST_EXPORT int32_t RHostInitialize(const char *rhome, const char *bert_home, RHostConsoleFunction console);
+
+/** 
+ * run a call. on success (0) response points to the serialized response,
+ * which the caller passes back to RHostRelease. 
+ */
+RHOST_EXPORT int32_t RHostCall(const char *call, uint32_t call_length, char **response, uint32_t *response_length);
+
+/** release a response */
+RHOST_EXPORT void RHostRelease(char *response);
+
+/** shut down R. the library can't be unloaded or restarted after this. */
+RHOST_EXPORT void RHostShutdown();
+
+/** for GetProcAddress */
+typedef int32_t(*RHostInitializeProcedure)(const char *rhome, const char *bert_home, RHostConsoleFunction console);
+typedef int32_t(*RHostCallProcedure)(const char *call, uint32_t call_length, char **response, uint32_t *response_length);
+typedef void(*RHostReleaseProcedure)(char *response);
+typedef void(*RHostShutdownProcedure)();
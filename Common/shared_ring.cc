@@ -0,0 +1,235 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "shared_ring.h"
+
+#include <iostream>
+#include <cstring>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// align message starts so the descriptor positions stay 8-byte aligned
+#define RING_ALIGNMENT 8
+
+SharedRing::SharedRing()
+  : header_(0)
+  , data_(0)
+  , mapped_size_(0)
+  , owner_(false)
+#ifdef _WIN32
+  , mapping_handle_(0)
+#endif
+{
+}
+
+SharedRing::~SharedRing() {
+  Close();
+}
+
+#ifdef _WIN32
+
+bool SharedRing::Map(const std::string &name, uint64_t size, bool create) {
+
+  std::string full_name = "Local\\";
+  full_name.append(name);
+
+  if (create) {
+    mapping_handle_ = CreateFileMappingA(INVALID_HANDLE_VALUE, 0, PAGE_READWRITE,
+      (DWORD)(size >> 32), (DWORD)(size & 0xffffffff), full_name.c_str());
+  }
+  else {
+    mapping_handle_ = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, full_name.c_str());
+  }
+
+  if (!mapping_handle_) {
+    std::cerr << "shared ring: mapping failed (" << GetLastError() << ")" << std::endl;
+    return false;
+  }
+
+  // when opening, size is unknown (0 maps the whole section)
+  void *view = MapViewOfFile(mapping_handle_, FILE_MAP_ALL_ACCESS, 0, 0, create ? (SIZE_T)size : 0);
+  if (!view) {
+    std::cerr << "shared ring: map view failed (" << GetLastError() << ")" << std::endl;
+    CloseHandle(mapping_handle_);
+    mapping_handle_ = 0;
+    return false;
+  }
+
+  header_ = reinterpret_cast<Header*>(view);
+  mapped_size_ = size;
+  return true;
+}
+
+void SharedRing::Close() {
+  if (header_) UnmapViewOfFile(header_);
+  if (mapping_handle_) CloseHandle(mapping_handle_);
+  header_ = 0;
+  data_ = 0;
+  mapping_handle_ = 0;
+  owner_ = false;
+}
+
+#else // #ifdef _WIN32
+
+bool SharedRing::Map(const std::string &name, uint64_t size, bool create) {
+
+  std::string full_name = "/";
+  full_name.append(name);
+
+  int fd = shm_open(full_name.c_str(), create ? (O_CREAT | O_RDWR | O_TRUNC) : O_RDWR, 0600);
+  if (fd < 0) {
+    std::cerr << "shared ring: shm_open failed (" << errno << ")" << std::endl;
+    return false;
+  }
+
+  if (create) {
+    if (ftruncate(fd, (off_t)size) < 0) {
+      std::cerr << "shared ring: ftruncate failed (" << errno << ")" << std::endl;
+      close(fd);
+      shm_unlink(full_name.c_str());
+      return false;
+    }
+  }
+  else {
+    struct stat st;
+    if (fstat(fd, &st) < 0 || (uint64_t)st.st_size < sizeof(Header)) {
+      close(fd);
+      return false;
+    }
+    size = (uint64_t)st.st_size;
+  }
+
+  void *view = mmap(0, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+
+  if (view == MAP_FAILED) {
+    std::cerr << "shared ring: mmap failed (" << errno << ")" << std::endl;
+    if (create) shm_unlink(full_name.c_str());
+    return false;
+  }
+
+  header_ = reinterpret_cast<Header*>(view);
+  mapped_size_ = size;
+  return true;
+}
+
+void SharedRing::Close() {
+  if (header_) {
+    munmap(header_, (size_t)mapped_size_);
+    if (owner_) {
+      std::string full_name = "/";
+      full_name.append(name_);
+      shm_unlink(full_name.c_str());
+    }
+  }
+  header_ = 0;
+  data_ = 0;
+  owner_ = false;
+}
+
+#endif // #ifdef _WIN32
+
+bool SharedRing::Create(const std::string &name, uint64_t capacity) {
+
+  Close();
+
+  capacity = (capacity + RING_ALIGNMENT - 1) & ~(uint64_t)(RING_ALIGNMENT - 1);
+  if (!Map(name, sizeof(Header) + capacity, true)) return false;
+
+  name_ = name;
+  owner_ = true;
+
+  header_->magic = kMagic;
+  header_->reserved = 0;
+  header_->capacity = capacity;
+  header_->head.store(0);
+  header_->tail.store(0);
+
+  data_ = reinterpret_cast<char*>(header_) + sizeof(Header);
+  return true;
+}
+
+bool SharedRing::Open(const std::string &name) {
+
+  Close();
+
+  if (!Map(name, 0, false)) return false;
+
+  if (header_->magic != kMagic) {
+    std::cerr << "shared ring: bad magic" << std::endl;
+    Close();
+    return false;
+  }
+
+  name_ = name;
+  owner_ = false;
+  data_ = reinterpret_cast<char*>(header_) + sizeof(Header);
+  return true;
+}
+
+char *SharedRing::Reserve(uint32_t length, uint64_t &position) {
+
+  if (!header_ || !length) return 0;
+
+  uint64_t capacity = header_->capacity;
+  uint64_t aligned = (length + RING_ALIGNMENT - 1) & ~(uint64_t)(RING_ALIGNMENT - 1);
+  if (aligned > capacity) return 0;
+
+  uint64_t head = header_->head.load(std::memory_order_relaxed);
+  uint64_t tail = header_->tail.load(std::memory_order_acquire);
+
+  // skip to the start of the buffer if the message would wrap. the 
+  // skipped bytes are implicitly released along with this message.
+
+  uint64_t offset = head % capacity;
+  if (offset + aligned > capacity) head += (capacity - offset);
+
+  if (head + aligned - tail > capacity) return 0; // full
+
+  position = head;
+  return data_ + (head % capacity);
+}
+
+void SharedRing::Commit(uint64_t position, uint32_t length) {
+  uint64_t aligned = (length + RING_ALIGNMENT - 1) & ~(uint64_t)(RING_ALIGNMENT - 1);
+  header_->head.store(position + aligned, std::memory_order_release);
+}
+
+const char *SharedRing::Data(uint64_t position, uint32_t length) {
+
+  if (!header_) return 0;
+
+  uint64_t capacity = header_->capacity;
+  uint64_t head = header_->head.load(std::memory_order_acquire);
+  uint64_t offset = position % capacity;
+
+  if (offset + length > capacity || position + length > head) return 0;
+  return data_ + offset;
+}
+
+void SharedRing::Release(uint64_t position, uint32_t length) {
+  uint64_t aligned = (length + RING_ALIGNMENT - 1) & ~(uint64_t)(RING_ALIGNMENT - 1);
+  header_->tail.store(position + aligned, std::memory_order_release);
+}
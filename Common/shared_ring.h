@@ -0,0 +1,119 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+/**
+ * single-producer, single-consumer byte ring in shared memory. this is
+ * the bulk data plane for large messages: the producer serializes directly
+ * into the ring and sends a small descriptor (position, length) over the 
+ * pipe; the consumer parses directly out of the ring and releases. that's 
+ * one copy on each side, instead of frame -> pipe chunks -> reassembly.
+ *
+ * there's one ring per direction. the process that creates the ring owns
+ * it (BERT); the other side opens it by name. messages are contiguous (if 
+ * a message won't fit before the end of the buffer we skip to the start), 
+ * and releases must be in order. that matches the pipe semantics, since 
+ * messages on a given connection are consumed in order.
+ *
+ * positions are monotonic byte counts; the offset into the buffer is 
+ * position % capacity.
+ */
+class SharedRing {
+
+public:
+  static const uint32_t kMagic = 0x52545242; // "BRTR"
+
+  /** layout at the start of the mapping */
+  struct Header {
+    uint32_t magic;
+    uint32_t reserved;
+    uint64_t capacity;
+    std::atomic<uint64_t> head;  // producer: end of the last reserved message
+    std::atomic<uint64_t> tail;  // consumer: end of the last released message
+  };
+
+public:
+  SharedRing();
+  ~SharedRing();
+
+public:
+
+  /** create (and own) a ring with the given capacity, in bytes */
+  bool Create(const std::string &name, uint64_t capacity);
+
+  /** open a ring created by the other process */
+  bool Open(const std::string &name);
+
+  /** unmap, and remove if we're the owner */
+  void Close();
+
+  /** accessor */
+  bool valid() { return header_ != 0; }
+
+  /** accessor */
+  uint64_t capacity() { return header_ ? header_->capacity : 0; }
+
+  /** accessor */
+  std::string name() { return name_; }
+
+  /**
+   * producer: reserve contiguous space for a message. returns a pointer to
+   * the space and sets position, or returns 0 if there's not enough room 
+   * (the caller should fall back to the pipe).
+   */
+  char *Reserve(uint32_t length, uint64_t &position);
+
+  /** producer: publish a reserved message */
+  void Commit(uint64_t position, uint32_t length);
+
+  /** 
+   * consumer: get a pointer to the message at position. returns 0 if the 
+   * descriptor doesn't make sense for this ring.
+   */
+  const char *Data(uint64_t position, uint32_t length);
+
+  /** consumer: release a message (and anything before it) */
+  void Release(uint64_t position, uint32_t length);
+
+protected:
+
+  /** map the region; size includes the header */
+  bool Map(const std::string &name, uint64_t size, bool create);
+
+private:
+  std::string name_;
+  Header *header_;
+  char *data_;
+  uint64_t mapped_size_;
+  bool owner_;
+
+#ifdef _WIN32
+  HANDLE mapping_handle_;
+#endif
+
+};
@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "message_utilities.h"
+
+#include <iostream>
+#include <cstring>
+
+/**
+ * tests for framing that don't need a transport: compressed frames, and 
+ * frames with headers that don't match their payload.
+ */
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+  if (!(condition)) { \
+    std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+    failures++; \
+  } \
+} while(0)
+
+/** a compressed frame, with the original length overwritten */
+static std::string CompressedFrame(const BERTBuffers::CallResponse &message, uint32_t original_length) {
+
+  std::string frame = MessageUtilities::Frame(message);
+  if (!MessageUtilities::CompressFrame(frame)) return std::string();
+
+  uint32_t header_size = MessageUtilities::FrameHeaderSize();
+  memcpy(&(frame[header_size]), &original_length, sizeof(uint32_t));
+  return frame;
+}
+
+/** compressed round trip, then the same frame with corrupt lengths */
+static void TestCompressedLength() {
+
+  BERTBuffers::CallResponse message, received;
+  message.set_id(23);
+  message.mutable_result()->set_str(std::string(256 * 1024, 'x'));
+
+  std::string frame = MessageUtilities::Frame(message);
+  uint32_t original_length = (uint32_t)(frame.length() - MessageUtilities::FrameHeaderSize());
+
+  std::string compressed = CompressedFrame(message, original_length);
+  CHECK(compressed.length() && compressed.length() < frame.length());
+  CHECK(MessageUtilities::Unframe(received, compressed));
+  CHECK(received.id() == 23);
+  CHECK(received.result().str() == message.result().str());
+
+  // past the frame limit. these must fail before allocating anything
+
+  CHECK(!MessageUtilities::Unframe(received, CompressedFrame(message, 0xffffffff)));
+  CHECK(!MessageUtilities::Unframe(received, CompressedFrame(message, FRAME_LENGTH_MASK + 1)));
+
+  // within the limit but wrong, so the codec rejects it
+
+  CHECK(!MessageUtilities::Unframe(received, CompressedFrame(message, original_length - 1)));
+  CHECK(!MessageUtilities::Unframe(received, CompressedFrame(message, original_length + 1)));
+
+}
+
+int main(int argc, char **argv) {
+
+  TestCompressedLength();
+
+  if (failures) std::cerr << failures << " check(s) failed" << std::endl;
+  else std::cout << "ok" << std::endl;
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,225 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pipe.h"
+#include "message_utilities.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+/**
+ * loopback tests for the posix transport: a server and a client pipe in
+ * the same process, exchanging messages larger than the record (buffer) 
+ * size so they have to be split and reassembled.
+ */
+
+#define TEST_PIPE_NAME "bert-loopback-test"
+#define TEST_LISTENER_NAME "bert-listener-test"
+
+static int failures = 0;
+
+#define CHECK(condition) do { \
+  if (!(condition)) { \
+    std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+    failures++; \
+  } \
+} while(0)
+
+/** 
+ * pump writes on one side and reads on the other until a message is 
+ * complete. we're single-threaded, so the writer can't block. if text is
+ * set, the message is copied out; otherwise it's left in the reader.
+ */
+static DWORD Transfer(Pipe &writer, Pipe &reader, std::string *text = 0) {
+  for (int i = 0; i < 100000; i++) {
+    writer.NextWrite();
+    DWORD result = text ? reader.Read(*text) : reader.ReadMessage(false);
+    if (result == 0) return 0;
+    if (result != WAIT_TIMEOUT && result != ERROR_MORE_DATA) return result;
+  }
+  return WAIT_TIMEOUT;
+}
+
+/** framed protobuf message, server to client */
+static void TestFramedMessage(Pipe &server, Pipe &client) {
+
+  BERTBuffers::CallResponse response;
+  response.set_id(17);
+  response.set_timeout(1500);
+  response.mutable_result()->set_str(std::string(1024 * 1024 + 13, 'x'));
+
+  std::string frame = MessageUtilities::Frame(response);
+  CHECK(frame.length() > server.buffer_size() * 4);
+
+  server.PushWrite(frame);
+  CHECK(Transfer(server, client) == 0);
+
+  BERTBuffers::CallResponse received;
+  CHECK(client.ParseMessage(received));
+  CHECK(received.id() == 17);
+  CHECK(received.timeout() == 1500);
+  CHECK(received.result().str() == response.result().str());
+}
+
+/** raw (unframed) text, client to server */
+static void TestRawMessage(Pipe &server, Pipe &client) {
+
+  std::string text;
+  for (int i = 0; text.length() < 50000; i++) text.append(std::to_string(i)).append(" ");
+
+  server.set_framed(false);
+  client.PushWrite(text);
+  std::string received;
+  CHECK(Transfer(client, server, &received) == 0);
+  CHECK(received == text);
+  server.set_framed(true);
+}
+
+/** 
+ * a record larger than the buffer can't come from a well-behaved writer. 
+ * the reader should fail the connection instead of returning a partial 
+ * message.
+ */
+static void TestTruncatedRecord() {
+
+  Pipe server;
+  CHECK(server.Start(TEST_PIPE_NAME, false) == 0);
+
+  int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+  CHECK(fd >= 0);
+
+  std::string path = server.full_name();
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  CHECK(connect(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) == 0);
+
+  std::string record(server.buffer_size() + 100, 'z');
+  record[0] = 0; // final record
+  CHECK(send(fd, record.c_str(), record.length(), 0) == (ssize_t)record.length());
+
+  server.Connect();
+  CHECK(server.connected());
+  CHECK(server.ReadMessage(true) == ERROR_BROKEN_PIPE);
+  CHECK(server.error());
+
+  close(fd);
+}
+
+/** a raw socket bound to path, listening or not */
+static int BindSocket(const std::string &path, bool listening) {
+  int fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  if (fd < 0 || bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) < 0
+    || (listening && listen(fd, 4) < 0)) {
+    if (fd >= 0) close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/** 
+ * a socket file with a live server behind it must be left alone; one left
+ * behind by a process that's gone is replaced.
+ */
+static void TestExistingSocket(const std::string &directory) {
+
+  std::string path = directory + "/" + TEST_LISTENER_NAME;
+
+  int fd = BindSocket(path, true);
+  CHECK(fd >= 0);
+  {
+    Pipe server;
+    CHECK(server.Start(TEST_LISTENER_NAME, false) != 0);
+
+    // still the other server's
+    Pipe client;
+    CHECK(client.Open(TEST_LISTENER_NAME) == 0);
+  }
+  close(fd);
+
+  // closed without unlinking: the file is there, but connecting is refused
+
+  CHECK(access(path.c_str(), F_OK) == 0);
+  {
+    Pipe server;
+    CHECK(server.Start(TEST_LISTENER_NAME, false) == 0);
+    Pipe client;
+    CHECK(client.Open(TEST_LISTENER_NAME) == 0);
+    server.Connect();
+    CHECK(server.connected());
+  }
+  CHECK(access(path.c_str(), F_OK) != 0);
+}
+
+/** servers and clients refuse a socket directory other users can get into */
+static void TestPrivateDirectory(const std::string &directory) {
+
+  CHECK(chmod(directory.c_str(), 0755) == 0);
+  {
+    Pipe server;
+    CHECK(server.Start(TEST_LISTENER_NAME, false) != 0);
+    Pipe client;
+    CHECK(client.Open(TEST_LISTENER_NAME) == EACCES);
+  }
+  CHECK(chmod(directory.c_str(), 0700) == 0);
+}
+
+int main(int argc, char **argv) {
+
+  char directory[] = "/tmp/bert-test-XXXXXX";
+  if (!mkdtemp(directory)) {
+    std::cerr << "mkdtemp failed" << std::endl;
+    return 1;
+  }
+  setenv("BERT_PIPE_DIR", directory, 1);
+
+  {
+    Pipe server;
+    Pipe client;
+
+    CHECK(server.Start(TEST_PIPE_NAME, false) == 0);
+    CHECK(client.Open(TEST_PIPE_NAME) == 0);
+    server.Connect();
+    CHECK(server.connected());
+
+    TestFramedMessage(server, client);
+    TestRawMessage(server, client);
+    TestTruncatedRecord();
+  }
+
+  TestExistingSocket(directory);
+  TestPrivateDirectory(directory);
+
+  rmdir(directory);
+
+  if (failures) std::cerr << failures << " check(s) failed" << std::endl;
+  else std::cout << "ok" << std::endl;
+
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "timer_wheel.h"
+
+#include <chrono>
+
+uint64_t TimerWheel::Now() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TimerWheel::TimerWheel(uint32_t tick_ms, uint32_t slot_count)
+  : tick_ms_(tick_ms ? tick_ms : 1)
+  , start_ms_(Now())
+  , current_tick_(0)
+  , next_id_(1)
+  , count_(0)
+  , slots_(slot_count ? slot_count : 1)
+{
+}
+
+uint64_t TimerWheel::TickFor(uint64_t time_ms) {
+  if (time_ms <= start_ms_) return 0;
+  return (time_ms - start_ms_) / tick_ms_;
+}
+
+void TimerWheel::Insert(Entry &entry) {
+
+  // anything due at or before the current tick goes in the next slot,
+  // so it runs on the next Advance()
+
+  if (entry.deadline_tick <= current_tick_) entry.deadline_tick = current_tick_ + 1;
+  slots_[entry.deadline_tick % slots_.size()].push_back(entry);
+  count_++;
+}
+
+uint32_t TimerWheel::Schedule(uint32_t delay_ms, Task task, uint32_t period_ms) {
+
+  Entry entry;
+  entry.id = next_id_++;
+  if (!next_id_) next_id_ = 1;
+
+  // round up, so we never fire early
+  entry.deadline_tick = TickFor(Now() + delay_ms + tick_ms_ - 1);
+  entry.period_ms = period_ms;
+  entry.task = task;
+
+  Insert(entry);
+  return entry.id;
+}
+
+void TimerWheel::Cancel(uint32_t id) {
+  for (auto &slot : slots_) {
+    for (auto iter = slot.begin(); iter != slot.end(); iter++) {
+      if (iter->id == id) {
+        slot.erase(iter);
+        count_--;
+        return;
+      }
+    }
+  }
+}
+
+bool TimerWheel::Pending(uint32_t id) {
+  for (auto &slot : slots_) {
+    for (const auto &entry : slot) if (entry.id == id) return true;
+  }
+  return false;
+}
+
+int TimerWheel::Advance() {
+
+  uint64_t target_tick = TickFor(Now());
+  if (target_tick <= current_tick_) return 0;
+
+  std::vector<Entry> expired;
+
+  // if we slept longer than one revolution, every slot is a candidate;
+  // otherwise just the slots we passed.
+
+  uint64_t ticks = target_tick - current_tick_;
+  size_t slot_count = slots_.size();
+  size_t visit = ticks >= slot_count ? slot_count : (size_t)ticks;
+
+  for (size_t i = 1; i <= visit; i++) {
+    auto &slot = slots_[(current_tick_ + i) % slot_count];
+    for (auto iter = slot.begin(); iter != slot.end(); ) {
+      if (iter->deadline_tick <= target_tick) {
+        expired.push_back(*iter);
+        iter = slot.erase(iter);
+        count_--;
+      }
+      else iter++;
+    }
+  }
+
+  current_tick_ = target_tick;
+
+  // run after removing, so tasks can schedule or cancel freely. periodic
+  // tasks are rescheduled from their deadline, not from now, so they don't
+  // drift (but we skip missed intervals rather than running them all).
+
+  for (auto &entry : expired) {
+    entry.task();
+    if (entry.period_ms) {
+      uint64_t period_ticks = (entry.period_ms + tick_ms_ - 1) / tick_ms_;
+      if (!period_ticks) period_ticks = 1;
+      entry.deadline_tick += period_ticks;
+      if (entry.deadline_tick <= current_tick_) entry.deadline_tick = current_tick_ + period_ticks;
+      Insert(entry);
+    }
+  }
+
+  return (int)expired.size();
+}
+
+int64_t TimerWheel::NextTimeout() {
+
+  if (!count_) return -1;
+
+  uint64_t earliest = UINT64_MAX;
+  for (const auto &slot : slots_) {
+    for (const auto &entry : slot) {
+      if (entry.deadline_tick < earliest) earliest = entry.deadline_tick;
+    }
+  }
+
+  uint64_t due_ms = start_ms_ + earliest * tick_ms_;
+  uint64_t now = Now();
+  return due_ms > now ? (int64_t)(due_ms - now) : 0;
+}
@@ -0,0 +1,103 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <list>
+#include <functional>
+#include <cstddef>
+#include <stdint.h>
+
+/**
+ * hashed timing wheel for periodic and one-shot work in the dispatch 
+ * loops. the idea is that loops wait on their handles with a timeout of
+ * NextTimeout(), instead of a fixed polling interval, and call Advance()
+ * when they wake up. if nothing is scheduled, NextTimeout() returns -1 
+ * and the loop can wait forever.
+ *
+ * schedule and cancel are O(1) (amortized); NextTimeout() scans pending 
+ * timers, which is fine for the handful we use. not thread safe: use it
+ * from the thread that runs the loop.
+ */
+class TimerWheel {
+
+public:
+  typedef std::function<void()> Task;
+
+protected:
+  typedef struct {
+    uint32_t id;
+    uint64_t deadline_tick;
+    uint32_t period_ms;
+    Task task;
+  }
+  Entry;
+
+public:
+
+  /** 
+   * tick is the resolution, in milliseconds. timers never fire early, but 
+   * may fire up to one tick late.
+   */
+  TimerWheel(uint32_t tick_ms = 10, uint32_t slot_count = 64);
+
+public:
+
+  /** 
+   * schedule a task to run after delay milliseconds. if period is non-zero, 
+   * the task repeats at that interval until cancelled. returns a timer id.
+   */
+  uint32_t Schedule(uint32_t delay_ms, Task task, uint32_t period_ms = 0);
+
+  /** cancel by id. safe to call from a task (including the running one) */
+  void Cancel(uint32_t id);
+
+  /** check if a timer is pending */
+  bool Pending(uint32_t id);
+
+  /** run any expired timers. returns the number of tasks run */
+  int Advance();
+
+  /**
+   * milliseconds until the next timer is due (0 if something is overdue),
+   * or -1 if there are no timers. 
+   */
+  int64_t NextTimeout();
+
+  /** monotonic clock in milliseconds */
+  static uint64_t Now();
+
+protected:
+
+  /** tick index for a point in time */
+  uint64_t TickFor(uint64_t time_ms);
+
+  /** insert into the right slot */
+  void Insert(Entry &entry);
+
+private:
+  uint32_t tick_ms_;
+  uint64_t start_ms_;
+  uint64_t current_tick_;
+  uint32_t next_id_;
+  size_t count_;
+  std::vector<std::list<Entry>> slots_;
+
+};
@@ -19,6 +19,8 @@
  
 #include "windows_api_functions.h"
 
+#include <sddl.h>
+
 namespace APIFunctions {
 
   std::vector<std::pair<std::string, FILETIME>> APIFunctions::ListDirectory(const std::string &directory) {
@@ -146,6 +148,69 @@ namespace APIFunctions {
     }
   }
 
+  std::string APIFunctions::ReadyEventName(const std::string &pipe_name) {
+    std::string name = pipe_name;
+    name.append("-READY");
+    return name;
+  }
+
+  void APIFunctions::SignalReady(const std::string &pipe_name) {
+    HANDLE event_handle = OpenEventA(EVENT_MODIFY_STATE, FALSE, ReadyEventName(pipe_name).c_str());
+    if (!event_handle) return;
+    SetEvent(event_handle);
+    CloseHandle(event_handle);
+  }
+
+  bool APIFunctions::ProcessUser(std::vector<char> &token_user, HANDLE process) {
+
+    HANDLE token = 0;
+    if (!OpenProcessToken(process, TOKEN_QUERY, &token)) return false;
+
+    DWORD length = 0;
+    GetTokenInformation(token, TokenUser, 0, 0, &length);
+    token_user.resize(length);
+
+    bool result = length && GetTokenInformation(token, TokenUser, &(token_user[0]), length, &length);
+    CloseHandle(token);
+    return result;
+
+  }
+
+  bool APIFunctions::SameUser(DWORD process_id) {
+
+    std::vector<char> ours, theirs;
+    if (!ProcessUser(ours, GetCurrentProcess())) return false;
+
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, process_id);
+    if (!process) return false;
+    bool result = ProcessUser(theirs, process);
+    CloseHandle(process);
+
+    return result && EqualSid(((TOKEN_USER*)&(ours[0]))->User.Sid, ((TOKEN_USER*)&(theirs[0]))->User.Sid);
+
+  }
+
+  PSECURITY_DESCRIPTOR APIFunctions::CurrentUserDescriptor() {
+
+    std::vector<char> token_user;
+    if (!ProcessUser(token_user, GetCurrentProcess())) return 0;
+
+    LPSTR sid = 0;
+    if (!ConvertSidToStringSidA(((TOKEN_USER*)&(token_user[0]))->User.Sid, &sid)) return 0;
+
+    // protected DACL, full access for this user only
+
+    std::string sddl = "D:P(A;;GA;;;";
+    sddl.append(sid);
+    sddl.append(")");
+    LocalFree(sid);
+
+    PSECURITY_DESCRIPTOR descriptor = 0;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorA(sddl.c_str(), SDDL_REVISION_1, &descriptor, 0)) return 0;
+    return descriptor;
+
+  }
+
 }
 
 
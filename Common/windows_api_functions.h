@@ -74,4 +74,33 @@ namespace APIFunctions {
   /** read a file and return contents */
   FileError FileContents(std::string &contents, const std::string &path);
 
+  /** 
+   * name of the event a child process sets once its pipe exists. the 
+   * parent creates it before starting the child, so it can wait on that 
+   * instead of polling for the pipe.
+   */
+  std::string ReadyEventName(const std::string &pipe_name);
+
+  /** 
+   * child side: set the ready event. if the parent didn't create one 
+   * (an older version), this does nothing.
+   */
+  void SignalReady(const std::string &pipe_name);
+
+  /** 
+   * the user (SID) a process runs as, from its token; the buffer holds a
+   * TOKEN_USER. false if we can't open the process or its token.
+   */
+  bool ProcessUser(std::vector<char> &token_user, HANDLE process);
+
+  /** true if the process runs as the same user as this one */
+  bool SameUser(DWORD process_id);
+
+  /** 
+   * security descriptor with a DACL that only allows the current user. 
+   * for pipes and other objects that shouldn't be open to other users 
+   * (or other sessions). 0 on failure; free with LocalFree.
+   */
+  PSECURITY_DESCRIPTOR CurrentUserDescriptor();
+
 };
@@ -5711,6 +5711,7 @@ proto.BERTBuffers.CallResponse.toObject = function(includeInstance, msg) {
   var f, obj = {
     id: jspb.Message.getFieldWithDefault(msg, 1, 0),
     wait: jspb.Message.getFieldWithDefault(msg, 2, false),
+    timeout: jspb.Message.getFieldWithDefault(msg, 11, 0),
     err: jspb.Message.getFieldWithDefault(msg, 3, ""),
     result: (f = msg.getResult()) && proto.BERTBuffers.Variable.toObject(includeInstance, f),
     console: (f = msg.getConsole()) && proto.BERTBuffers.Console.toObject(includeInstance, f),
@@ -5763,6 +5764,10 @@ proto.BERTBuffers.CallResponse.deserializeBinaryFromReader = function(msg, reade
       var value = /** @type {boolean} */ (reader.readBool());
       msg.setWait(value);
       break;
+    case 11:
+      var value = /** @type {number} */ (reader.readUint32());
+      msg.setTimeout(value);
+      break;
     case 3:
       var value = /** @type {string} */ (reader.readString());
       msg.setErr(value);
@@ -5843,6 +5848,13 @@ proto.BERTBuffers.CallResponse.serializeBinaryToWriter = function(message, write
       f
     );
   }
+  f = message.getTimeout();
+  if (f !== 0) {
+    writer.writeUint32(
+      11,
+      f
+    );
+  }
   f = /** @type {string} */ (jspb.Message.getField(message, 3));
   if (f != null) {
     writer.writeString(
@@ -5939,6 +5951,21 @@ proto.BERTBuffers.CallResponse.prototype.setWait = function(value) {
 };
 
 
+/**
+ * optional uint32 timeout = 11;
+ * @return {number}
+ */
+proto.BERTBuffers.CallResponse.prototype.getTimeout = function() {
+  return /** @type {number} */ (jspb.Message.getFieldWithDefault(this, 11, 0));
+};
+
+
+/** @param {number} value */
+proto.BERTBuffers.CallResponse.prototype.setTimeout = function(value) {
+  jspb.Message.setProto3IntField(this, 11, value);
+};
+
+
 /**
  * optional string err = 3;
  * @return {string}
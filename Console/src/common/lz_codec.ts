@@ -0,0 +1,87 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * decoder for frames compressed on the native side (see Common/lz_codec.h).
+ * the format is the LZ4 block format. we only decode; the console doesn't
+ * send anything large enough to be worth compressing.
+ */
+export class LZCodec {
+
+  /** 
+   * decompress into a new array of the original length (which the frame 
+   * carries). returns null if the data is malformed.
+   */
+  static Decompress(source: Uint8Array, target_length: number): Uint8Array {
+
+    let target = new Uint8Array(target_length);
+    let ip = 0;
+    let op = 0;
+
+    while (ip < source.length) {
+
+      let token = source[ip++];
+
+      let literal_length = token >> 4;
+      if (literal_length === 15) {
+        let b;
+        do {
+          if (ip >= source.length) return null;
+          b = source[ip++];
+          literal_length += b;
+        } while (b === 255);
+      }
+
+      if (ip + literal_length > source.length || op + literal_length > target_length) return null;
+      target.set(source.subarray(ip, ip + literal_length), op);
+      ip += literal_length;
+      op += literal_length;
+
+      if (ip >= source.length) break; // last sequence has no match
+
+      if (ip + 2 > source.length) return null;
+      let offset = source[ip] | (source[ip + 1] << 8);
+      ip += 2;
+      if (!offset || offset > op) return null;
+
+      let match_length = token & 15;
+      if (match_length === 15) {
+        let b;
+        do {
+          if (ip >= source.length) return null;
+          b = source[ip++];
+          match_length += b;
+        } while (b === 255);
+      }
+      match_length += 4;
+
+      if (op + match_length > target_length) return null;
+
+      // matches can overlap (offset < length), so copy forward
+      let match = op - offset;
+      if (offset >= match_length) target.copyWithin(op, match, match + match_length);
+      else for (let i = 0; i < match_length; i++) target[op + i] = target[match + i];
+      op += match_length;
+
+    }
+
+    return (op === target_length) ? target : null;
+  }
+
+}
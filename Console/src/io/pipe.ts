@@ -22,6 +22,16 @@ import * as messages from "../../generated/variable_pb.js";
 import * as Rx from "rxjs";
 
 import { MessageUtilities } from '../common/message_utilities';
+import { LZCodec } from '../common/lz_codec';
+
+// frame flags are in the high bits of the length prefix (see 
+// Common/message_utilities.h). the console only sees compression.
+// v2 frames start with a header (magic, version, header size, flags, 
+// length) instead of the prefix. we read both, but still write v1.
+
+const FRAME_FLAG_COMPRESSED = 0x10000000;
+const FRAME_LENGTH_MASK = 0x0fffffff;
+const FRAME_MAGIC = 0xB2B2B2B2;
 
 enum Channel {
   INTERNAL,
@@ -353,10 +363,26 @@ export class Pipe {
       // to keep a buffer around
 
       while (array && array.length) {
-        let byte_length = new Int32Array(array.buffer.slice(0, 4))[0];
-        let response = messages.CallResponse.deserializeBinary(array.slice(4, byte_length + 4));
+        let view = new DataView(array.buffer, array.byteOffset, array.byteLength);
+        let prefix = view.getUint32(0, true);
+        let header_size = 4;
+        let flags = prefix & ~FRAME_LENGTH_MASK;
+        let byte_length = prefix & FRAME_LENGTH_MASK;
+        if (prefix === FRAME_MAGIC) {
+          header_size = view.getUint16(6, true);
+          flags = view.getUint32(8, true);
+          byte_length = view.getUint32(12, true);
+        }
+        if (array.length < header_size + byte_length) throw("invalid frame length");
+        let payload = array.slice(header_size, byte_length + header_size);
+        if (flags & FRAME_FLAG_COMPRESSED) {
+          let original_length = new Uint32Array(payload.buffer.slice(0, 4))[0];
+          payload = LZCodec.Decompress(payload.subarray(4), original_length);
+          if (!payload) throw("invalid compressed frame");
+        }
+        let response = messages.CallResponse.deserializeBinary(payload);
         stack.push(response);
-        array = array.slice(byte_length + 4);
+        array = array.slice(byte_length + header_size);
       }
 
       stack.forEach(response => {
@@ -465,6 +491,12 @@ export class Pipe {
       console.info("calling console");
       this.Control("console").then(() => {
         console.info("registered as console client");
+
+        // large messages (mostly raster graphics) can be compressed. if the
+        // service doesn't support it, that's fine, we just don't get them.
+
+        return this.Control("compression");
+      }).then(() => {
         resolve();
       });
     });
@@ -38,4 +38,10 @@
 #include "variable.pb.h"
 #include "message_utilities.h"
 #include "pipe.h"
+#include "active_calls.h"
+#include "memory_policy.h"
 #include "process_exit_codes.h"
+
+// console output is buffered until a console connects, and then queued 
+// on the console pipe. text is dropped past this limit.
+#define CONSOLE_QUEUE_BYTES     (16 * 1024 * 1024)
@@ -47,12 +47,19 @@ typedef enum {
 }
 ExecResult;
 
-/** startup */
-void JuliaInit();
+/** 
+ * startup. if there's an image path and the file exists, we load that 
+ * image (built with Build/sysimage/build-sysimage.jl) instead of the 
+ * default. returns true if we loaded the custom image.
+ */
+bool JuliaInit(const std::string &image_path = "");
 
 /** shutdown */
 void JuliaShutdown();
 
+/** full garbage collection (see MemoryPolicy) */
+void JuliaCollectGarbage();
+
 /** get version so we can gate/limit */
 void JuliaGetVersion(int32_t *major, int32_t *minor, int32_t *patch);
 
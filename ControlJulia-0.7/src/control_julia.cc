@@ -19,6 +19,7 @@
 
 #include "control_julia.h"
 #include "julia_interface.h"
+#include "windows_api_functions.h"
 #include "io_redirector.h"
 
 // handle for signaling break (ctrl+c); set as first
@@ -27,11 +28,36 @@ HANDLE break_event_handle = CreateEvent(0, TRUE, FALSE, 0);
 std::vector<HANDLE> handles = { break_event_handle };
 
 std::vector<Pipe*> pipes;
-std::vector<std::string> console_buffer;
+
+/**
+ * calls in progress, for targeted cancellation and deadlines (both handled
+ * by the management thread). the event wakes the management thread when a
+ * call with a deadline starts, so it can adjust its wait.
+ */
+ActiveCalls active_calls;
+HANDLE call_deadline_event = CreateEvent(0, FALSE, FALSE, 0);
+
+/** 
+ * console frames are held here until a console client connects. this is
+ * bounded; text is dropped (oldest first) if there's too much.
+ */
+FrameQueue console_buffer;
 
 std::string pipename;
 int console_client = -1;
 
+/** custom image (-i), see JuliaInit */
+std::string image_path;
+
+/** we log the time of the first function call, which includes jit */
+bool first_call = true;
+
+/** 
+ * idle reclamation and RSS ceilings (see MemoryPolicy), from the config.
+ * there's no object cache, so this is collection and trimming only.
+ */
+MemoryPolicy memory_policy;
+
 HANDLE prompt_event_handle;
 
 Pipe stdout_pipe, stderr_pipe;
@@ -40,9 +66,21 @@ extern void JuliaRunUVLoop(bool until_done);
 
 std::string language_tag;
 
+/** 
+ * register a call with active_calls, with its timeout (if any). callers 
+ * remove it when the call returns.
+ */
+void EnterCall(const BERTBuffers::CallResponse &call) {
+  uint32_t timeout = call.timeout();
+  active_calls.Enter(call.id(), timeout);
+  if (timeout) SetEvent(call_deadline_event);
+}
+
 void NextPipeInstance(bool block, std::string &name) {
   Pipe *pipe = new Pipe;
-  int rslt = pipe->Start(name, block);
+  // the blocking instance is the first client pipe, which BERT is 
+  // waiting for; tell it the pipe is ready
+  int rslt = pipe->Start(name, block, block);
   handles.push_back(pipe->wait_handle_read());
   handles.push_back(pipe->wait_handle_write());
   pipes.push_back(pipe);
@@ -66,6 +104,8 @@ void CloseClient(int index) {
   {
     pipes[index]->Reset();
     if (index == console_client) {
+      std::cout << "console queue: " << pipes[index]->QueueStats() << std::endl;
+      pipes[index]->SetQueueLimit(0, QUEUE_POLICY_NONE);
       console_client = -1;
     }
   }
@@ -99,12 +139,24 @@ std::string GetLastErrorAsString(DWORD err = -1)
 * no console client is connected
 */
 void PushConsoleMessage(google::protobuf::Message &message) {
+
+  // console text can be dropped if the queue is full; everything else is kept
+
+  FrameClass frame_class = FRAME_CLASS_CONTROL;
+  const BERTBuffers::CallResponse *response = dynamic_cast<const BERTBuffers::CallResponse*>(&message);
+  if (response && response->operation_case() == BERTBuffers::CallResponse::OperationCase::kConsole) {
+    auto message_case = response->console().message_case();
+    if (message_case == BERTBuffers::Console::MessageCase::kText || message_case == BERTBuffers::Console::MessageCase::kErr) {
+      frame_class = FRAME_CLASS_TEXT;
+    }
+  }
+
   std::string framed = MessageUtilities::Frame(message);
   if (console_client >= 0) {
-    pipes[console_client]->PushWrite(framed);
+    pipes[console_client]->PushWrite(std::move(framed), frame_class);
   }
   else {
-    console_buffer.push_back(framed);
+    console_buffer.Push(framed, frame_class);
   }
 }
 
@@ -113,10 +165,19 @@ void PushConsoleString(const std::string &str) {
     pipes[console_client]->PushWrite(str);
   }
   else {
-    console_buffer.push_back(str);
+    console_buffer.Push(str);
   }
 }
 
+/** creates the marker that replaces dropped console text */
+std::string ConsoleTruncationMarker(uint64_t dropped_bytes) {
+  std::stringstream ss;
+  ss << "\n[console output truncated: " << dropped_bytes << " bytes]\n";
+  BERTBuffers::CallResponse message;
+  message.mutable_console()->set_err(ss.str());
+  return MessageUtilities::Frame(message);
+}
+
 /*
 void ConsoleMessage(const char *buf, int len, int flag) {
   BERTBuffers::CallResponse message;
@@ -138,8 +199,8 @@ void ConsolePrompt(const char *prompt, uint32_t id) {
 }
 
 void QueueConsoleWrites() {
+  pipes[console_client]->SetQueueLimit(CONSOLE_QUEUE_BYTES, QUEUE_POLICY_DROP, ConsoleTruncationMarker);
   pipes[console_client]->QueueWrites(console_buffer);
-  console_buffer.clear();
 }
 
 /**
@@ -192,6 +253,13 @@ bool SystemCall(BERTBuffers::CallResponse &response, const BERTBuffers::CallResp
     //translated_call.mutable_function_call()->set_function("BERT.ListFunctions");
     //JuliaCall(response, translated_call);
   }
+  else if (!function.compare("memory-stats")) {
+
+    // check first so the RSS is current (this doesn't reclaim)
+
+    memory_policy.Check();
+    response.mutable_result()->set_str(memory_policy.Report());
+  }
   else if (!function.compare("shutdown")) {
 
   }
@@ -217,6 +285,21 @@ bool SystemCall(BERTBuffers::CallResponse &response, const BERTBuffers::CallResp
 //std::vector< std::string > shell_buffer;
 std::string shell_buffer;
 
+/** check memory, and reclaim if the policy says so */
+void ReclaimMemory() {
+
+  MemoryAction action = memory_policy.Check();
+  if (action == MEMORY_ACTION_NONE) return;
+
+  uint64_t start = GetTickCount64();
+  uint64_t rss = MemoryPolicy::ResidentBytes();
+
+  JuliaCollectGarbage();
+  MemoryPolicy::ReturnMemory();
+  memory_policy.Record(action, rss, GetTickCount64() - start, 0);
+
+}
+
 void pipe_loop() {
 
   char default_prompt[] = "> ";
@@ -232,7 +315,9 @@ void pipe_loop() {
 
   while (true) {
 
-    result = WaitForMultipleObjects((DWORD)handles.size(), &(handles[0]), FALSE, 100);
+    // with a memory policy, wake up now and then so it can run when we're idle
+
+    result = WaitForMultipleObjects((DWORD)handles.size(), &(handles[0]), FALSE, memory_policy.enabled() ? MEMORY_CHECK_INTERVAL_MS : INFINITE);
 
     if (result == WAIT_OBJECT_0) {
 
@@ -273,6 +358,7 @@ void pipe_loop() {
 
           if (success) {
 
+            memory_policy.Activity();
             response.set_id(call.id());
 
             switch (call.operation_case()) {
@@ -285,7 +371,15 @@ void pipe_loop() {
                 SystemCall(response, call, index);
                 break;
               default:
-                JuliaCall(response, call);
+                EnterCall(call);
+                if (first_call) {
+                  uint64_t call_start = GetTickCount64();
+                  JuliaCall(response, call);
+                  std::cout << "first call: " << (GetTickCount64() - call_start) << " ms" << std::endl;
+                  first_call = false;
+                }
+                else JuliaCall(response, call);
+                active_calls.Leave(call.id());
                 break;
               }
               if (call.wait()) pipe->PushWrite(MessageUtilities::Frame(response));
@@ -293,7 +387,9 @@ void pipe_loop() {
 
             case BERTBuffers::CallResponse::kCode:
               // std::cout << "code" << std::endl;
+              EnterCall(call);
               JuliaExec(response, call);
+              active_calls.Leave(call.id());
               if (call.wait()) pipe->PushWrite(MessageUtilities::Frame(response));
               break;
 
@@ -346,6 +442,9 @@ void pipe_loop() {
       std::cerr << "ERR " << result << ": " << GetLastErrorAsString(result) << std::endl;
       break;
     }
+
+    if (memory_policy.enabled() && memory_policy.Due()) ReclaimMemory();
+
   }
 
 }
@@ -375,7 +474,7 @@ unsigned __stdcall StdioThreadFunction(void *data) {
 
   HANDLE handles[] = { pipes_array[0]->wait_handle_read(), pipes_array[1]->wait_handle_read(), stdout_pipe.wait_handle_read(), stderr_pipe.wait_handle_read() };
   while (true) {
-    DWORD wait_result = WaitForMultipleObjects(4, handles, FALSE, 1000);
+    DWORD wait_result = WaitForMultipleObjects(4, handles, FALSE, INFINITE);
     int index = wait_result - WAIT_OBJECT_0;
 
     if (index == 2) {
@@ -466,7 +565,7 @@ unsigned __stdcall StdioThreadFunction(void *data) {
 
   HANDLE handles[] = { io_redirectors[0]->data_available_, io_redirectors[1]->data_available_, stdout_pipe.wait_handle_read(), stderr_pipe.wait_handle_read() };
   while (true) {
-    DWORD wait_result = WaitForMultipleObjects(4, handles, FALSE, 1000);
+    DWORD wait_result = WaitForMultipleObjects(4, handles, FALSE, INFINITE);
     int index = wait_result - WAIT_OBJECT_0;
 
     if (index == 2) {
@@ -567,62 +666,101 @@ void SetBreak() {
 
 }
 
+void ManagementCommand(const BERTBuffers::CallResponse &call) {
+
+  //std::string command = call.control_message();
+  std::string command = call.function_call().function();
+  if (!command.length()) return;
+
+  if (!command.compare("break")) {
+    SetBreak();
+  }
+  else if (!command.compare("cancel")) {
+
+    // cancel a specific call, if it's still running. this is the same
+    // interrupt as break (there's only one julia thread to interrupt).
+
+    uint32_t id = 0;
+    if (call.function_call().arguments_size() > 0) id = (uint32_t)call.function_call().arguments(0).integer();
+    if (active_calls.Active(id)) {
+      std::cout << "cancel call " << id << std::endl;
+      SetBreak();
+    }
+  }
+  else {
+    std::cerr << "unexpected system command (management pipe): " << command << std::endl;
+  }
+
+}
+
 unsigned __stdcall ManagementThreadFunction(void *data) {
 
   DWORD result;
-  Pipe pipe;
   char *name = reinterpret_cast<char*>(data);
+  std::string pipe_name = name;
+
+  std::cout << "start management pipe on " << pipe_name << std::endl;
+
+  // the console and BERT both connect, so we run more than one instance
+  // (same as the main pipes). the deadline event is first.
 
-  std::cout << "start management pipe on " << name << std::endl;
+  std::vector<Pipe*> management_pipes;
+  std::vector<HANDLE> management_handles = { call_deadline_event };
 
-  int rslt = pipe.Start(name, false);
+  auto next_instance = [&]() {
+    Pipe *pipe = new Pipe;
+    pipe->Start(pipe_name, false);
+    management_pipes.push_back(pipe);
+    management_handles.push_back(pipe->wait_handle_read());
+  };
+
+  next_instance();
   std::string message;
 
   while (true) {
-    result = WaitForSingleObject(pipe.wait_handle_read(), 1000);
-    if (result == WAIT_OBJECT_0) {
-      ResetEvent(pipe.wait_handle_read());
-      if (!pipe.connected()) {
+
+    int64_t timeout = active_calls.NextTimeout();
+    result = WaitForMultipleObjects((DWORD)management_handles.size(), &(management_handles[0]), FALSE, timeout < 0 ? INFINITE : (DWORD)timeout);
+
+    if (result == WAIT_TIMEOUT || result == WAIT_OBJECT_0) {
+
+      // deadline event just means "check the timeout again"
+
+      uint32_t id = active_calls.Expired();
+      if (id) {
+        std::cout << "call " << id << " timed out" << std::endl;
+        SetBreak();
+      }
+    }
+    else if (result > WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + management_handles.size()) {
+      Pipe *pipe = management_pipes[result - WAIT_OBJECT_0 - 1];
+      ResetEvent(pipe->wait_handle_read());
+      if (!pipe->connected()) {
         std::cout << "connect management pipe" << std::endl;
-        pipe.Connect(); // this will start reading
+        pipe->Connect(); // this will start reading
+        if (management_pipes.size() < MAX_PIPE_COUNT) next_instance();
       }
       else {
-        result = pipe.Read(message);
+        result = pipe->Read(message);
         if (!result) {
           BERTBuffers::CallResponse call;
           bool success = MessageUtilities::Unframe(call, message);
-          if (success) {
-            //std::string command = call.control_message();
-            std::string command = call.function_call().function();
-            if (command.length()) {
-              if (!command.compare("break")) {
-
-                SetBreak();
-
-                //user_break_flag = true;
-                // RSetUserBreak();
-              }
-              else {
-                std::cerr << "unexpected system command (management pipe): " << command << std::endl;
-              }
-            }
-          }
+          if (success) ManagementCommand(call);
           else {
             std::cerr << "error parsing management message" << std::endl;
           }
-          pipe.StartRead();
+          pipe->StartRead();
         }
         else {
           if (result == ERROR_BROKEN_PIPE) {
             std::cerr << "broken pipe in management thread" << std::endl;
-            pipe.Reset();
+            pipe->Reset();
           }
         }
       }
     }
-    else if (result != WAIT_TIMEOUT) {
+    else {
       std::cerr << "error in management thread: " << GetLastError() << std::endl;
-      pipe.Reset();
       break;
     }
   }
@@ -696,6 +834,9 @@ int main(int argc, char **argv) {
     if (!strncmp(argv[i], "-p", 2) && i < argc - 1) {
       pipename = argv[++i];
     }
+    else if (!strncmp(argv[i], "-i", 2) && i < argc - 1) {
+      image_path = argv[++i];
+    }
   }
 
   if (!pipename.length()) {
@@ -705,6 +846,22 @@ int main(int argc, char **argv) {
 
   std::cout << "pipe: " << pipename << std::endl;
 
+  // memory policy, from the config file in BERT_HOME (same as R)
+
+  {
+    char home[MAX_PATH];
+    GetEnvironmentVariableA("BERT_HOME", home, MAX_PATH);
+    std::string config_data;
+    std::string config_path(home);
+    config_path.append("bert-config.json");
+    if (APIFunctions::FileContents(config_data, config_path) == APIFunctions::FileError::Success) {
+      std::string err;
+      json11::Json config = json11::Json::parse(config_data, err, json11::COMMENTS);
+      memory_policy.Configure(config["BERT"]["Julia"]);
+      if (memory_policy.enabled()) std::cout << "memory policy on" << std::endl;
+    }
+  }
+
   char buffer[MAX_PATH];
   sprintf_s(buffer, "%s-M", pipename.c_str());
   uintptr_t management_thread_handle = _beginthreadex(0, 0, ManagementThreadFunction, buffer, 0, 0);
@@ -733,9 +890,11 @@ int main(int argc, char **argv) {
   {
     char buf2[MAX_PATH];
     sprintf_s(buf2, "%s-STDOUT", pipename.c_str());
+    stdout_pipe.set_framed(false); // raw text
     stdout_pipe.Start(buf2, false);
 
     sprintf_s(buf2, "%s-STDERR", pipename.c_str());
+    stderr_pipe.set_framed(false);
     stderr_pipe.Start(buf2, false);
   }
 
@@ -767,6 +926,9 @@ int main(int argc, char **argv) {
   io_redirectors[1]->Start(stderr);
   uintptr_t io_thread_handle = _beginthreadex(0, 0, StdioThreadFunction, io_redirectors, 0, 0);
 
+  console_buffer.SetLimit(CONSOLE_QUEUE_BYTES, QUEUE_POLICY_DROP);
+  console_buffer.set_marker(ConsoleTruncationMarker);
+
   // start the callback pipe first. doesn't block.
 
   std::string callback_pipe_name = pipename;
@@ -779,7 +941,10 @@ int main(int argc, char **argv) {
 
   std::cout << "first pipe connected" << std::endl;
 
-  JuliaInit();
+  uint64_t init_start = GetTickCount64();
+  bool loaded_image = JuliaInit(image_path);
+  std::cout << "julia init: " << (GetTickCount64() - init_start) << " ms (" 
+    << (loaded_image ? "custom" : "default") << " image)" << std::endl;
 
   pipe_loop();
   // julia_exec();
@@ -27,6 +27,9 @@
 
 jl_ptls_t ptls; 
 
+/** set if we loaded a custom image (see JuliaInit) */
+bool custom_image = false;
+
 jl_value_t * VariableToJlValue(const BERTBuffers::Variable *variable) {
 
   jl_value_t* value = jl_nothing;
@@ -466,7 +469,7 @@ void JuliaGetVersion(int32_t *major, int32_t *minor, int32_t *patch) {
   *patch = jl_ver_patch();
 }
 
-void JuliaInit() {
+bool JuliaInit(const std::string &image_path) {
 
   char buffer[MAX_PATH];
   GetEnvironmentVariableA("BERT_HOME", buffer, MAX_PATH);
@@ -513,11 +516,33 @@ void JuliaInit() {
 
   ptls = jl_get_ptls_states();
 
+  // the image has to be matched to the julia binaries, which are wherever
+  // we loaded libjulia from. if the image is missing, fall back to the 
+  // default so a stale config doesn't break startup.
+
+  if (image_path.length() && GetFileAttributesA(image_path.c_str()) != INVALID_FILE_ATTRIBUTES) {
+    char bindir[MAX_PATH];
+    HMODULE module = GetModuleHandleA("libjulia.dll");
+    if (module && GetModuleFileNameA(module, bindir, MAX_PATH)) {
+      char *separator = strrchr(bindir, '\\');
+      if (separator) *separator = 0;
+      std::cout << "loading image: " << image_path << std::endl;
+      jl_init_with_image(bindir, image_path.c_str());
+      custom_image = true;
+      return true;
+    }
+  }
+
   // [from docs] required: setup the Julia context 
   jl_init();
+  return false;
 
 }
 
+void JuliaCollectGarbage() {
+  jl_gc_collect(1);
+}
+
 void JuliaShutdown() {
 
   // [from docs]
@@ -1219,6 +1244,22 @@ void JuliaExec(BERTBuffers::CallResponse &response, const BERTBuffers::CallRespo
     composite += "\n";
   }
 
+  // if the image already has the BERT module, don't redefine it (that 
+  // would throw away the compiled code). run the rest of the startup 
+  // file (settings, using, banners) as usual.
+
+  if (call.code().startup() && custom_image) {
+    jl_value_t *module = jl_get_global(jl_main_module, jl_symbol("BERT"));
+    if (module && jl_is_module(module)) {
+      std::string::size_type start = composite.find("\nmodule BERT");
+      std::string::size_type end = composite.find("\nend # module BERT");
+      if (start != std::string::npos && end != std::string::npos && end > start) {
+        end = composite.find('\n', end + 1);
+        composite.erase(start + 1, (end == std::string::npos) ? std::string::npos : end - start);
+      }
+    }
+  }
+
   JL_TRY{
 
     jl_value_t *val = (jl_value_t*)jl_load_file_string(composite.c_str(), composite.length(), "inline");
@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <stdint.h>
+
+/**
+ * cache of byte-compiled R code, for the startup code and source files.
+ * entries are compiled with compiler::cmpfile and loaded (evaluated) with 
+ * compiler::loadcmp, so functions are compiled once, not by the JIT on 
+ * their first call, and we skip the parse on a hit.
+ *
+ * entries are keyed by a hash of the source text, and live in a directory
+ * per R version, so editing a file or changing R misses. stale entries are
+ * left in place; the directory can be deleted at any time. several 
+ * processes (workers) can share a directory: entries are written to a 
+ * temp file and renamed.
+ */
+class BytecodeCache {
+
+private:
+
+  /** cache directory, with a trailing separator. empty if we're off */
+  std::string directory_;
+
+  uint32_t hits_;
+  uint32_t misses_;
+
+public:
+
+  BytecodeCache();
+
+public:
+
+  /** 
+   * turn on the cache. entries go in a subdirectory of directory, named
+   * for version; both are created if necessary. returns false if we 
+   * can't create the directory, in which case the cache stays off.
+   */
+  bool Open(const std::string &directory, const std::string &version);
+
+  /** accessor */
+  bool enabled() { return directory_.length() > 0; }
+
+  /**
+   * evaluate R code (contents) in the global environment, through the 
+   * cache. if the code came from a file, pass the path; otherwise it's 
+   * written to a temp file to compile. 
+   *
+   * returns false if the cache can't be used (it's off, or the code 
+   * doesn't compile). in that case nothing was evaluated, and the caller
+   * should parse and evaluate as usual (which will report the problem). 
+   * otherwise err is set from the evaluation.
+   */
+  bool Evaluate(const std::string &contents, const std::string &source_file, int &err);
+
+  /** status, for the log */
+  std::string Report();
+
+protected:
+
+  /** FNV-1a, 64 bit */
+  static uint64_t Hash(const std::string &data);
+
+};
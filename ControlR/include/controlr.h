@@ -27,12 +27,17 @@
 #include <string>
 #include <vector>
 #include <stack>
+#include <functional>
 
 #include "variable.pb.h"
 #include "string_utilities.h"
 #include "pipe.h"
 #include "message_utilities.h"
 #include "process_exit_codes.h"
+#include "timer_wheel.h"
+#include "active_calls.h"
+#include "call_scheduler.h"
+#include "memory_policy.h"
 
 // pipe index of callback
 #define CALLBACK_INDEX          0
@@ -44,11 +49,55 @@
 #define SYSTEMCALL_OK           0
 #define SYSTEMCALL_SHUTDOWN    -1
 
+// interval for R event processing (polled handlers). window messages
+// are handled as they arrive, this is just for R's own housekeeping.
+#define R_TICK_INTERVAL_MS      100
+
+// the dispatch loop reads ahead into the scheduler, up to this many calls
+// per pipe; past that, messages wait in the pipe. it runs something at 
+// least every SCHEDULER_MAX_INTAKE reads, even if more input is ready.
+#define SCHEDULER_READ_AHEAD    256
+#define SCHEDULER_MAX_INTAKE    16
+
+// a shared server exits once it has had no clients for this long
+#define SHARED_SERVER_LINGER_MS 30000
+
+// spreadsheet graphics are checked this long after the last call 
+// completes, so a burst of calls results in a single update
+#define GRAPHICS_UPDATE_DELAY_MS 100
+
+// console writes are packed into a single pipe write up to this size, 
+// and held at most this long. the console splits frames on its end.
+#define CONSOLE_COALESCE_BYTES  (32 * 1024)
+#define CONSOLE_FLUSH_WINDOW_MS 10
+
+// when streaming a result, wait for the pipe once this much is queued
+#define STREAM_QUEUE_BYTES      (1024 * 1024)
+
+// write queue limits. responses can't be dropped, so client pipes block
+// the producer. console output is dropped (oldest first) by default; this
+// can be changed in the config (BERT.R.outputQueue, BERT.R.outputPolicy).
+#define PIPE_QUEUE_BYTES        (64 * 1024 * 1024)
+#define CONSOLE_QUEUE_BYTES     (16 * 1024 * 1024)
+
 /**
- * calls an R function, by name, possibly with arguments
+ * calls an R function, by name, possibly with arguments. a batch call 
+ * (FUNCTION_FLAG_BATCH) runs the function once per set of arguments, or
+ * once in total if it's vectorized, and returns an array of results.
  */
 BERTBuffers::CallResponse& RCall(BERTBuffers::CallResponse &rsp, const BERTBuffers::CallResponse &call);
 
+/**
+ * calls an R function and streams the result, if it's large enough and of a 
+ * type we can stream (matrices, vectors and data frames of simple types). 
+ * the response header (shape and names) and then chunks of about chunk_cells
+ * values are passed to emit as they're converted; more is set for all but 
+ * the last. returns false if the result wasn't streamed, in which case rsp 
+ * holds it as with RCall.
+ */
+bool RCallStreamed(BERTBuffers::CallResponse &rsp, const BERTBuffers::CallResponse &call, uint32_t chunk_cells,
+  const std::function<void(const BERTBuffers::CallResponse &message, bool more)> &emit);
+
 /**
  * callback from user control ("button")
  */
@@ -65,9 +114,11 @@ BERTBuffers::CallResponse& RExec(BERTBuffers::CallResponse &rsp, const BERTBuffe
 BERTBuffers::CallResponse& ListScriptFunctions(BERTBuffers::CallResponse &message);
 
 /**
- * send a message to the console. this includes stdio as well as graphics and notifications
+ * send a message to the console. this includes stdio as well as graphics and notifications.
+ * by default messages are coalesced (see CONSOLE_COALESCE_BYTES); prompts and control 
+ * messages should be immediate.
  */
-void PushConsoleMessage(google::protobuf::Message &message);
+void PushConsoleMessage(google::protobuf::Message &message, bool immediate = false);
 
 /**
  * callback _from_ the console
@@ -75,10 +126,48 @@ void PushConsoleMessage(google::protobuf::Message &message);
 bool ConsoleCallback(const BERTBuffers::CallResponse &call, BERTBuffers::CallResponse &response);
 
 /** 
- * reads source file. in R, this uses `source`.
+ * reads source file. in R, this uses `source`, or the bytecode cache if
+ * it's on.
  */
 bool ReadSourceFile(const std::string &file, bool notify = false);
 
+/**
+ * turn on the bytecode cache (see BytecodeCache) for the startup code and
+ * source files. version names the subdirectory, so it should change with R.
+ */
+bool OpenBytecodeCache(const std::string &directory, const std::string &version);
+
+/** bytecode cache hits and misses, for the log */
+std::string BytecodeCacheReport();
+
+/**
+ * set the active client (shared server). each client gets an environment,
+ * created on first use; calls, source files, function lists and code run
+ * there. client 0 is the global environment (not shared, or the console).
+ */
+void SetActiveClient(uint32_t client);
+
+/** drop a client's environment, when the client goes away */
+void ReleaseClient(uint32_t client);
+
+/** objects and memory in each client environment, one line per client */
+std::string ClientMemoryReport();
+
+/** 
+ * drop cached objects (see BERT$return.cache.reference) that haven't been
+ * used in age_seconds, or all of them for 0. returns the number dropped.
+ */
+uint32_t EvictCachedObjects(uint32_t age_seconds);
+
+/** full garbage collection */
+void RCollectGarbage();
+
+/** 
+ * install the application pointer in the active client's environment, 
+ * instead of on the search path (where all clients would share it)
+ */
+void InstallClientApplicationPointer(BERTBuffers::CallResponse &response, const BERTBuffers::CallResponse &call);
+
 /**
  *
  */
@@ -118,6 +207,12 @@ void ConsoleMessage(const char *buf, int len = -1, int flag = 0);
  */
 int RLoop(const char *rhome, const char *ruser, int argc, char **argv);
 
+/**
+ * start R without running the repl (RLoop calls this first). the 
+ * in-process host (rhost.cc) uses this directly, non-interactive.
+ */
+int RInitialize(const char *rhome, const char *ruser, int argc, char **argv, bool interactive = true);
+
 /**
  * break uses signals on linux, flag on windows
  */
@@ -0,0 +1,135 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "controlr.h"
+#include "controlr_common.h"
+#include "bytecode_cache.h"
+
+#include <fstream>
+
+/** compiler::name, as a function we can call (unprotected) */
+static SEXP CompilerFunction(const char *name) {
+  return Rf_lang3(Rf_install("::"), Rf_install("compiler"), Rf_install(name));
+}
+
+BytecodeCache::BytecodeCache()
+  : hits_(0)
+  , misses_(0)
+{
+}
+
+bool BytecodeCache::Open(const std::string &directory, const std::string &version) {
+
+  std::string path = directory;
+  if (path.length() && path.back() != '\\' && path.back() != '/') path.append("\\");
+
+  // two levels; ok if they're already there
+
+  CreateDirectoryA(path.c_str(), 0);
+  path.append(version);
+  CreateDirectoryA(path.c_str(), 0);
+
+  DWORD attributes = GetFileAttributesA(path.c_str());
+  if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY)) {
+    std::cerr << "bytecode cache: can't create " << path << std::endl;
+    return false;
+  }
+
+  directory_ = path + "\\";
+  std::cout << "bytecode cache: " << directory_ << std::endl;
+  return true;
+}
+
+uint64_t BytecodeCache::Hash(const std::string &data) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool BytecodeCache::Evaluate(const std::string &contents, const std::string &source_file, int &err) {
+
+  if (!enabled()) return false;
+
+  char key[32];
+  sprintf_s(key, "%016llx", (unsigned long long)Hash(contents));
+  std::string path = directory_ + key + ".Rc";
+
+  if (GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES) hits_++;
+  else {
+
+    // compile to a temp file and then move it into place. if somebody 
+    // else (another worker) got there first, that's fine.
+
+    std::stringstream ss;
+    ss << path << "." << GetCurrentProcessId();
+    std::string temp_path = ss.str();
+
+    std::string input = source_file;
+    if (!input.length()) {
+      input = temp_path + ".R";
+      std::ofstream stream(input, std::ios::binary);
+      stream.write(contents.c_str(), contents.length());
+    }
+
+    // cmpfile(input, output). each allocation can collect, so protect
+
+    int compile_err = 0;
+    SEXP input_sexp = PROTECT(Rf_mkString(input.c_str()));
+    SEXP output_sexp = PROTECT(Rf_mkString(temp_path.c_str()));
+    SEXP function = PROTECT(CompilerFunction("cmpfile"));
+    SEXP call = PROTECT(Rf_lang3(function, input_sexp, output_sexp));
+    R_tryEvalSilent(call, R_GlobalEnv, &compile_err);
+    UNPROTECT(4);
+
+    if (!source_file.length()) DeleteFileA(input.c_str());
+
+    if (compile_err) {
+      DeleteFileA(temp_path.c_str());
+      return false;
+    }
+
+    if (!MoveFileExA(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+      DeleteFileA(temp_path.c_str());
+      if (GetFileAttributesA(path.c_str()) == INVALID_FILE_ATTRIBUTES) return false;
+    }
+
+    misses_++;
+  }
+
+  // loadcmp(path, envir = globalenv()). errors from the code itself go
+  // to the console, as they would from source.
+
+  SEXP path_sexp = PROTECT(Rf_mkString(path.c_str()));
+  SEXP function = PROTECT(CompilerFunction("loadcmp"));
+  SEXP call = PROTECT(Rf_lang3(function, path_sexp, R_GlobalEnv));
+  SET_TAG(CDDR(call), Rf_install("envir"));
+  R_tryEval(call, R_GlobalEnv, &err);
+  UNPROTECT(3);
+
+  return true;
+}
+
+std::string BytecodeCache::Report() {
+  std::stringstream ss;
+  ss << "bytecode cache: " << hits_ << " hits, " << misses_ << " misses";
+  return ss.str();
+}
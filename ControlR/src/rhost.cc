@@ -0,0 +1,201 @@
+/**
+ * Copyright (c) 2017-2018 Structured Data, LLC
+ * 
+ * This file is part of BERT.
+ *
+ * BERT is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * BERT is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with BERT.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "controlr.h"
+#include "controlr_common.h"
+#include "rhost_api.h"
+#include "windows_api_functions.h"
+#include "json11/json11.hpp"
+
+#include <mutex>
+
+/**
+ * in-process host (see rhost_api.h). this replaces controlr.cc in the 
+ * library build: it provides the functions the R core calls for console
+ * and callbacks, and a dispatch function in place of the pipe loop.
+ */
+
+extern "C" {
+
+  // we're called on whatever thread the caller is on, not the one that
+  // started R, so R's stack checks would fail. see "Threading issues" in
+  // R-exts; this turns them off.
+  LibExtern uintptr_t R_CStackLimit;
+
+};
+
+/** one call at a time; R is single-threaded */
+static std::mutex host_mutex;
+
+static bool host_initialized = false;
+static bool host_shutdown = false;
+
+static RHostConsoleFunction console_function = 0;
+
+// --- functions the R core calls (controlr.cc in the process) ----------------
+
+void ConsoleMessage(const char *buf, int len, int flag) {
+  if (!console_function) return;
+  if (len < 0) len = (int)strlen(buf);
+  console_function(buf, len, flag);
+}
+
+/** there's no console client in-process, so graphics and prompts are dropped */
+void PushConsoleMessage(google::protobuf::Message &message, bool immediate) {}
+
+bool ConsoleCallback(const BERTBuffers::CallResponse &call, BERTBuffers::CallResponse &response) {
+  return false;
+}
+
+/** no callbacks into Excel from the host (see rhost_api.h) */
+bool Callback(const BERTBuffers::CallResponse &call, BERTBuffers::CallResponse &response) {
+  response.set_err("callbacks are not available in-process");
+  return false;
+}
+
+void DirectCallback(const char *channel, const char *data, bool buffered) {}
+
+/** 
+ * we never run the repl, so this only happens if something asks for 
+ * input (browser, readline). there's nobody to answer; end of input.
+ */
+int InputStreamRead(const char *prompt, char *buf, int len, int addtohistory, bool is_continuation) {
+  return 0;
+}
+
+// --- dispatch ---------------------------------------------------------------
+
+/** 
+ * same handling as the process for the calls that make sense here. the 
+ * pipe-specific system calls (rings, streaming, console) don't.
+ */
+static void HostDispatch(BERTBuffers::CallResponse &response, const BERTBuffers::CallResponse &call) {
+
+  response.set_id(call.id());
+
+  switch (call.operation_case()) {
+
+  case BERTBuffers::CallResponse::kFunctionCall:
+    if (call.function_call().target() == BERTBuffers::CallTarget::system) {
+      const std::string &function = call.function_call().function();
+      if (!function.compare("list-functions")) {
+        ListScriptFunctions(response);
+      }
+      else if (!function.compare("read-source-file") && call.function_call().arguments_size() > 0) {
+        std::string file = call.function_call().arguments(0).str();
+        response.mutable_result()->set_boolean(file.length() ? ReadSourceFile(file, false) : false);
+      }
+      else if (!function.compare("bytecode-cache-stats")) {
+        response.mutable_result()->set_str(BytecodeCacheReport());
+      }
+      else response.mutable_result()->set_boolean(false);
+    }
+    else RCall(response, call);
+    break;
+
+  case BERTBuffers::CallResponse::kCode:
+    RExec(response, call);
+    break;
+
+  default:
+    response.set_err("unsupported in-process");
+  }
+
+}
+
+// --- API --------------------------------------------------------------------
+
+RHOST_EXPORT int32_t RHostInitialize(const char *rhome, const char *bert_home, RHostConsoleFunction console) {
+
+  std::lock_guard<std::mutex> lock(host_mutex);
+  if (host_initialized) return 0;
+  if (host_shutdown) return PROCESS_ERROR_CONFIGURATION_ERROR;
+
+  int major, minor, patch;
+  RGetVersion(&major, &minor, &patch);
+  if (major != 3 || minor != 5) return PROCESS_ERROR_UNSUPPORTED_VERSION;
+
+  console_function = console;
+
+  // same settings as the process (see main in controlr.cc): library 
+  // path and the bytecode cache
+
+  std::string config_data;
+  std::string home(bert_home ? bert_home : "");
+  if (APIFunctions::FileContents(config_data, home + "bert-config.json") == APIFunctions::FileError::Success) {
+
+    std::string err;
+    json11::Json config = json11::Json::parse(config_data, err, json11::COMMENTS);
+
+    if (config["BERT"]["R"]["lib"].is_string()) {
+      char buffer[MAX_PATH];
+      ExpandEnvironmentStringsA(config["BERT"]["R"]["lib"].string_value().c_str(), buffer, MAX_PATH);
+      SetEnvironmentVariableA("R_LIBS", buffer);
+    }
+
+    if (config["BERT"]["R"]["bytecodeCache"].bool_value()) {
+      std::stringstream version;
+      version << "R-" << major << "." << minor << "." << patch;
+      OpenBytecodeCache(home + "cache", version.str());
+    }
+  }
+
+  char* args[] = { "controlr", "--no-save", "--no-restore", "--encoding=UTF-8" };
+  int result = RInitialize(rhome, "", 4, args, false);
+  if (result) return result;
+
+  R_CStackLimit = (uintptr_t)-1;
+
+  host_initialized = true;
+  return 0;
+
+}
+
+RHOST_EXPORT int32_t RHostCall(const char *call_data, uint32_t call_length, char **response_data, uint32_t *response_length) {
+
+  BERTBuffers::CallResponse call, response;
+  if (!call.ParseFromArray(call_data, call_length)) return -1;
+
+  {
+    std::lock_guard<std::mutex> lock(host_mutex);
+    if (!host_initialized) return -1;
+    HostDispatch(response, call);
+  }
+
+  uint32_t length = (uint32_t)response.ByteSizeLong();
+  char *data = new char[length ? length : 1];
+  response.SerializeWithCachedSizesToArray(reinterpret_cast<google::protobuf::uint8*>(data));
+
+  *response_data = data;
+  *response_length = length;
+  return 0;
+
+}
+
+RHOST_EXPORT void RHostRelease(char *response_data) {
+  delete[] response_data;
+}
+
+RHOST_EXPORT void RHostShutdown() {
+  std::lock_guard<std::mutex> lock(host_mutex);
+  if (!host_initialized) return;
+  Rf_endEmbeddedR(0);
+  host_initialized = false;
+  host_shutdown = true;
+}
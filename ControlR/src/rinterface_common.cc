@@ -24,6 +24,10 @@
 #include "convert.h"
 
 #include "gdi_graphics_device.h"
+#include "bytecode_cache.h"
+#include "windows_api_functions.h"
+
+#include <map>
 
 // try to store fuel now, you jerks
 #undef clear
@@ -309,6 +313,108 @@ SEXP ResolveCacheReference(uint32_t reference) {
 
 }
 
+/**
+ * client environments (shared server), by client id. these are children
+ * of the global environment, so anything in there (and the BERT env) is 
+ * still visible. the active environment is 0 for the global environment.
+ */
+static std::map<uint32_t, SEXP> client_environments;
+static SEXP active_environment = 0;
+
+static SEXP ActiveEnvironment() {
+  return active_environment ? active_environment : R_GlobalEnv;
+}
+
+void SetActiveClient(uint32_t client) {
+
+  if (!client) {
+    active_environment = 0;
+    return;
+  }
+
+  auto iter = client_environments.find(client);
+  if (iter != client_environments.end()) {
+    active_environment = iter->second;
+    return;
+  }
+
+  int err = 0;
+  SEXP env = R_tryEvalSilent(Rf_lang3(Rf_install("new.env"), Rf_ScalarLogical(1), R_GlobalEnv), R_GlobalEnv, &err);
+  if (err || !Rf_isEnvironment(env)) {
+    std::cerr << "failed to create environment for client " << client << std::endl;
+    active_environment = 0;
+    return;
+  }
+
+  R_PreserveObject(env);
+  client_environments[client] = env;
+  active_environment = env;
+
+}
+
+void ReleaseClient(uint32_t client) {
+  auto iter = client_environments.find(client);
+  if (iter == client_environments.end()) return;
+  if (active_environment == iter->second) active_environment = 0;
+  R_ReleaseObject(iter->second);
+  client_environments.erase(iter);
+}
+
+std::string ClientMemoryReport() {
+
+  // object count and total size, from R. object.size doesn't count shared
+  // things (like environments) twice, but it's an estimate anyway.
+
+  static const char size_function[] = "function(e){ n <- ls(envir=e, all.names=T); "
+    "c(length(n), sum(vapply(n, function(x){ as.numeric(utils::object.size(get(x, envir=e))) }, 0))) }";
+
+  std::stringstream ss;
+  ParseStatus ps;
+  int err = 0;
+
+  SEXP parsed = PROTECT(R_ParseVector(Rf_mkString(size_function), -1, &ps, R_NilValue));
+  SEXP function = (ps == PARSE_OK) ? R_tryEvalSilent(VECTOR_ELT(parsed, 0), R_GlobalEnv, &err) : R_NilValue;
+  PROTECT(function);
+
+  for (auto entry : client_environments) {
+    if (ss.tellp() > 0) ss << std::endl;
+    ss << "client " << entry.first << ": ";
+    SEXP result = R_NilValue;
+    int call_err = 0;
+    if (!err && Rf_isFunction(function)) result = R_tryEvalSilent(Rf_lang2(function, entry.second), R_GlobalEnv, &call_err);
+    if (!err && !call_err && Rf_isReal(result) && Rf_length(result) == 2) {
+      ss << (uint64_t)(REAL(result)[0]) << " objects, " << (uint64_t)(REAL(result)[1] / 1024) << " KB";
+    }
+    else ss << "unknown";
+  }
+
+  UNPROTECT(2);
+  return ss.str();
+
+}
+
+void InstallClientApplicationPointer(BERTBuffers::CallResponse &response, const BERTBuffers::CallResponse &call) {
+
+  // install.application.pointer attaches EXCEL to the search path, which
+  // every client would share. for a client, it goes in the client env.
+
+  int err = 0;
+  SEXP env = R_tryEvalSilent(Rf_lang2(Rf_install("get"), Rf_mkString("BERT")), R_GlobalEnv, &err);
+  if (err || !Rf_isEnvironment(env) || call.function_call().arguments_size() < 1) {
+    response.set_err("R error");
+    return;
+  }
+
+  SEXP lang = PROTECT(Rf_lang3(Rf_install("install.application.pointer"), VariableToSEXP(call.function_call().arguments(0)), ActiveEnvironment()));
+  SET_TAG(CDDR(lang), Rf_install("envir"));
+  R_tryEval(lang, env, &err);
+  UNPROTECT(1);
+
+  if (err) response.set_err("R error");
+  else response.mutable_result()->set_boolean(true);
+
+}
+
 SEXP RCallSEXP(const BERTBuffers::CompositeFunctionCall &fc, bool wait, int &err) {
 
   // auto fc = call.function_call();
@@ -316,7 +422,7 @@ SEXP RCallSEXP(const BERTBuffers::CompositeFunctionCall &fc, bool wait, int &err
   int len = fc.arguments().size();
   int flags = fc.flags();
 
-  if (flags == 1) {
+  if (flags & FUNCTION_FLAG_MAPPED) {
 
     // this is a mapped function, use special calling syntax...
 
@@ -360,7 +466,7 @@ SEXP RCallSEXP(const BERTBuffers::CompositeFunctionCall &fc, bool wait, int &err
 
     SetNames(sargs, names);
     
-    SEXP env = R_GlobalEnv;
+    SEXP env = ActiveEnvironment();
     std::vector<std::string> parts;
     StringUtilities::Split(fc.function().c_str(), '$', 0, parts, true);
 
@@ -391,6 +497,35 @@ SEXP RCallSEXP(const BERTBuffers::CompositeFunctionCall &fc, bool wait, int &err
 
 }
 
+uint32_t EvictCachedObjects(uint32_t age_seconds) {
+
+  int err = 0;
+  SEXP env = R_tryEvalSilent(Rf_lang2(Rf_install("get"), Rf_mkString("BERT")), R_GlobalEnv, &err);
+
+  if (!err && Rf_isEnvironment(env)) {
+    SEXP result = R_tryEvalSilent(Rf_lang2(Rf_install(".evict.cached.objects"), Rf_ScalarReal(age_seconds)), env, &err);
+    if (!err && (Rf_isInteger(result) || Rf_isReal(result))) return (uint32_t)Rf_asInteger(result);
+  }
+
+  return 0;
+
+}
+
+void RCollectGarbage() {
+  R_gc();
+}
+
+/** startup code and source files, if it's on */
+static BytecodeCache bytecode_cache;
+
+bool OpenBytecodeCache(const std::string &directory, const std::string &version) {
+  return bytecode_cache.Open(directory, version);
+}
+
+std::string BytecodeCacheReport() {
+  return bytecode_cache.Report();
+}
+
 bool ReadSourceFile(const std::string &file, bool notify) {
   int err = 0;
   if (notify) {
@@ -399,16 +534,39 @@ bool ReadSourceFile(const std::string &file, bool notify) {
     message.append("\n");
     R_tryEval(Rf_lang2(Rf_install("cat"), Rf_mkString(message.c_str())), R_GlobalEnv, &err);
   }
+
+  // a client's files go in its environment. the cache evaluates in the 
+  // global environment, so it's only for the global case.
+
+  if (active_environment) {
+    SEXP lang = PROTECT(Rf_lang3(Rf_install("source"), Rf_mkString(file.c_str()), active_environment));
+    SET_TAG(CDDR(lang), Rf_install("local"));
+    R_tryEval(lang, R_GlobalEnv, &err);
+    UNPROTECT(1);
+    return !err;
+  }
+
+  if (bytecode_cache.enabled()) {
+    std::string contents;
+    err = 0;
+    if (APIFunctions::FileContents(contents, file) == APIFunctions::FileError::Success
+      && bytecode_cache.Evaluate(contents, file, err)) return !err;
+  }
+
   R_tryEval(Rf_lang2(Rf_install("source"), Rf_mkString(file.c_str())), R_GlobalEnv, &err);
 
   return !err;
 }
 
-__inline bool HandleSimpleTypes(SEXP sexp, int len, int rtype, BERTBuffers::Array *arr, BERTBuffers::Variable *var) { // , const std::vector<std::string> &levels = {}) {
+/**
+ * converts elements [start, len) of a vector of simple type. start is 
+ * nonzero when streaming a result in chunks.
+ */
+__inline bool HandleSimpleTypes(SEXP sexp, int len, int rtype, BERTBuffers::Array *arr, BERTBuffers::Variable *var, int start = 0) { // , const std::vector<std::string> &levels = {}) {
 
   if (Rf_isLogical(sexp) || rtype == LGLSXP)
   {
-    for (int i = 0; i < len; i++) {
+    for (int i = start; i < len; i++) {
       auto ptr = arr ? arr->add_data() : var;
       int lgl = (INTEGER(sexp))[i];
       if( NA_LOGICAL == lgl ){
@@ -433,7 +591,7 @@ __inline bool HandleSimpleTypes(SEXP sexp, int len, int rtype, BERTBuffers::Arra
     }
 
     int levels_count = level_strings.size();
-    for (int i = 0; i < len; i++) {
+    for (int i = start; i < len; i++) {
       auto ptr = arr ? arr->add_data() : var;
       int level = INTEGER(sexp)[i];
       if (level == NA_INTEGER) {
@@ -446,7 +604,7 @@ __inline bool HandleSimpleTypes(SEXP sexp, int len, int rtype, BERTBuffers::Arra
   else if (Rf_isComplex(sexp)) {
 
     // handle complex before the catchall rf_isnumber below
-    for (int i = 0; i < len; i++) {
+    for (int i = start; i < len; i++) {
       auto ptr = arr ? arr->add_data() : var;
       auto complex = ptr->mutable_cpx();
       if (ISNA(COMPLEX(sexp)[i].i) || ISNA(COMPLEX(sexp)[i].r)) {
@@ -461,7 +619,7 @@ __inline bool HandleSimpleTypes(SEXP sexp, int len, int rtype, BERTBuffers::Arra
   }
   else if (Rf_isInteger(sexp) || rtype == INTSXP)
   {
-    for (int i = 0; i < len; i++) {
+    for (int i = start; i < len; i++) {
       auto ptr = arr ? arr->add_data() : var;
       if (NA_INTEGER == INTEGER(sexp)[i]) {
         ptr->mutable_err()->set_type(BERTBuffers::ErrorType::NA);
@@ -471,7 +629,7 @@ __inline bool HandleSimpleTypes(SEXP sexp, int len, int rtype, BERTBuffers::Arra
   }
   else if (isReal(sexp) || Rf_isNumber(sexp) || rtype == REALSXP)
   {
-    for (int i = 0; i < len; i++) {
+    for (int i = start; i < len; i++) {
       auto ptr = arr ? arr->add_data() : var;
       if (ISNA(REAL(sexp)[i])) {
         ptr->mutable_err()->set_type(BERTBuffers::ErrorType::NA);
@@ -481,7 +639,7 @@ __inline bool HandleSimpleTypes(SEXP sexp, int len, int rtype, BERTBuffers::Arra
   }
   else if (isString(sexp) || rtype == STRSXP)
   {
-    for (int i = 0; i < len; i++) {
+    for (int i = start; i < len; i++) {
       auto ptr = arr ? arr->add_data() : var;
       SEXP strsxp = STRING_ELT(sexp, i);
       if (NA_STRING == strsxp){
@@ -758,8 +916,11 @@ BERTBuffers::CallResponse& ListScriptFunctions(BERTBuffers::CallResponse &respon
   
   ParseStatus ps;
 
+  // this runs in the active environment, so environment() is the client's
+  // environment (or the global environment, which is the default)
+
   SEXP cmds = PROTECT(Rf_allocVector(STRSXP, 1));
-  SET_STRING_ELT(cmds, 0, Rf_mkChar("BERT$list.functions()"));
+  SET_STRING_ELT(cmds, 0, Rf_mkChar("BERT$list.functions(envir=environment())"));
 
   SEXP parsed = PROTECT(R_ParseVector(cmds, -1, &ps, R_NilValue));
 
@@ -771,7 +932,7 @@ BERTBuffers::CallResponse& ListScriptFunctions(BERTBuffers::CallResponse &respon
     int err = 0, len = Rf_length(parsed);
     for (int i = 0; !err && i < Rf_length(parsed); i++) {
       SEXP cmd = VECTOR_ELT(parsed, i);
-      result = R_tryEval(cmd, R_GlobalEnv, &err);
+      result = R_tryEval(cmd, ActiveEnvironment(), &err);
     }
     if (err) response.set_err("R error");
     else {
@@ -868,8 +1029,117 @@ BERTBuffers::CallResponse& ExecUserCommand(BERTBuffers::CallResponse &response,
   return response;
 }
 
+/**
+ * is this a simple value (one cell)? vectorized calls only take those.
+ */
+static bool ScalarVariable(const BERTBuffers::Variable &var) {
+  switch (var.value_case()) {
+  case BERTBuffers::Variable::ValueCase::kInteger:
+  case BERTBuffers::Variable::ValueCase::kReal:
+  case BERTBuffers::Variable::ValueCase::kStr:
+  case BERTBuffers::Variable::ValueCase::kBoolean:
+  case BERTBuffers::Variable::ValueCase::kNil:
+    return true;
+  }
+  return false;
+}
+
+/**
+ * call a vectorized function once for a whole batch: each argument is a 
+ * vector of that argument across the calls. returns false if we can't 
+ * (calls have different arguments, or arguments that aren't scalars) or 
+ * the result doesn't have one element per call; the caller then loops.
+ */
+static bool RCallVectorized(BERTBuffers::Array *results, const BERTBuffers::CompositeFunctionCall &batch) {
+
+  int count = batch.arguments_size();
+  int argument_count = batch.arguments(0).arr().data_size();
+
+  BERTBuffers::CompositeFunctionCall vector_call;
+  vector_call.set_function(batch.function());
+  vector_call.set_flags(batch.flags() & ~(FUNCTION_FLAG_BATCH | FUNCTION_FLAG_VECTORIZED));
+
+  for (int j = 0; j < argument_count; j++) {
+    auto argument = vector_call.add_arguments();
+    argument->set_name(batch.arguments(0).arr().data(j).name());
+    auto arr = argument->mutable_arr();
+    arr->set_rows(count);
+    arr->set_cols(1);
+  }
+
+  for (int i = 0; i < count; i++) {
+    const auto &arguments = batch.arguments(i).arr();
+    if (arguments.data_size() != argument_count) return false;
+    for (int j = 0; j < argument_count; j++) {
+      const auto &argument = arguments.data(j);
+      if (!ScalarVariable(argument) || argument.name() != vector_call.arguments(j).name()) return false;
+      auto element = vector_call.mutable_arguments(j)->mutable_arr()->add_data();
+      *element = argument;
+      element->clear_name();
+    }
+  }
+
+  int err = 0;
+  SEXP result = PROTECT(RCallSEXP(vector_call, true, err));
+
+  BERTBuffers::Variable var;
+  if (!err) SEXPToVariable(&var, result);
+  UNPROTECT(1);
+
+  if (err || var.value_case() != BERTBuffers::Variable::ValueCase::kArr || var.arr().data_size() != count) return false;
+
+  results->mutable_data()->Swap(var.mutable_arr()->mutable_data());
+  return true;
+
+}
+
+/**
+ * batched call: one argument per call, each an array holding that call's
+ * arguments. the result is an array with one element per call; calls that
+ * fail get an error element, the rest of the batch still runs.
+ */
+static BERTBuffers::CallResponse& RCallBatch(BERTBuffers::CallResponse &rsp, const BERTBuffers::CallResponse &call) {
+
+  const auto &batch = call.function_call();
+  int count = batch.arguments_size();
+
+  auto results = rsp.mutable_result()->mutable_arr();
+  results->set_rows(count);
+  results->set_cols(1);
+
+  if (!count) return rsp;
+  if ((batch.flags() & FUNCTION_FLAG_VECTORIZED) && RCallVectorized(results, batch)) return rsp;
+
+  BERTBuffers::CompositeFunctionCall single;
+  single.set_function(batch.function());
+  single.set_flags(batch.flags() & ~(FUNCTION_FLAG_BATCH | FUNCTION_FLAG_VECTORIZED));
+
+  for (int i = 0; i < count; i++) {
+
+    single.clear_arguments();
+    for (const auto &argument : batch.arguments(i).arr().data()) *(single.add_arguments()) = argument;
+
+    int err = 0;
+    SEXP result = PROTECT(RCallSEXP(single, true, err));
+
+    auto element = results->add_data();
+    if (err) {
+      element->mutable_err()->set_type(BERTBuffers::ErrorType::EXECUTION);
+      element->mutable_err()->set_message("parse error");
+    }
+    else SEXPToVariable(element, result);
+    UNPROTECT(1);
+
+  }
+
+  return rsp;
+
+}
+
 BERTBuffers::CallResponse& RCall(BERTBuffers::CallResponse &rsp, const BERTBuffers::CallResponse &call) {
 
+  if (call.function_call().flags() & FUNCTION_FLAG_BATCH) return RCallBatch(rsp, call);
+
   int err = 0;
   bool wait = call.wait();
 
@@ -888,6 +1158,146 @@ BERTBuffers::CallResponse& RCall(BERTBuffers::CallResponse &rsp, const BERTBuffe
   return rsp;
 }
 
+/**
+ * can we stream this vector? we only stream atomic types that convert one
+ * element at a time (see HandleSimpleTypes).
+ */
+bool StreamableVector(SEXP sexp) {
+  switch (TYPEOF(sexp)) {
+  case LGLSXP:
+  case INTSXP:
+  case REALSXP:
+  case CPLXSXP:
+  case STRSXP:
+    return true;
+  }
+  return false;
+}
+
+/**
+ * get the vectors to stream (one, or one per data frame column) and fill in
+ * the array header. returns the total cell count, or 0 if we can't stream.
+ */
+int StreamHeader(BERTBuffers::Array *arr, SEXP sexp, std::vector<SEXP> &columns) {
+
+  int len = Rf_length(sexp);
+
+  if (Rf_isFrame(sexp) && TYPEOF(sexp) == VECSXP) {
+
+    int nrow = len ? Rf_length(VECTOR_ELT(sexp, 0)) : 0;
+    for (int col = 0; col < len; col++) {
+      SEXP column = VECTOR_ELT(sexp, col);
+      if (!StreamableVector(column) || Rf_length(column) != nrow) return 0;
+      columns.push_back(column);
+    }
+
+    arr->set_rows(nrow);
+    arr->set_cols(len);
+
+    SEXP names = getAttrib(sexp, R_NamesSymbol);
+    if (names && Rf_length(names) && isString(names)) {
+      for (int i = 0; i < Rf_length(names); i++) arr->add_colnames()->assign(CHAR(Rf_asChar(STRING_ELT(names, i))));
+    }
+
+    names = getAttrib(sexp, R_RowNamesSymbol);
+    if (names && Rf_length(names) && isString(names)) {
+      for (int i = 0; i < Rf_length(names); i++) arr->add_rownames()->assign(CHAR(Rf_asChar(STRING_ELT(names, i))));
+    }
+
+    return nrow * len;
+  }
+
+  // element names go on each element, so we can't send them up front
+
+  if (!StreamableVector(sexp) || TYPEOF(getAttrib(sexp, R_NamesSymbol)) != NILSXP) return 0;
+
+  columns.push_back(sexp);
+
+  if (Rf_isMatrix(sexp)) {
+    arr->set_rows(Rf_nrows(sexp));
+    arr->set_cols(Rf_ncols(sexp));
+
+    SEXP dimnames = getAttrib(sexp, R_DimNamesSymbol);
+    if (TYPEOF(dimnames) == VECSXP) {
+      int dimnames_length = Rf_length(dimnames);
+      if (dimnames_length > 0) {
+        SEXP name_list = VECTOR_ELT(dimnames, 0);
+        for (int i = 0; i < Rf_length(name_list); i++) arr->add_rownames(CHAR(Rf_asChar(STRING_ELT(name_list, i))));
+      }
+      if (dimnames_length > 1) {
+        SEXP name_list = VECTOR_ELT(dimnames, 1);
+        for (int i = 0; i < Rf_length(name_list); i++) arr->add_colnames(CHAR(Rf_asChar(STRING_ELT(name_list, i))));
+      }
+    }
+  }
+  else {
+    arr->set_rows(len);
+    arr->set_cols(1);
+  }
+
+  return len;
+}
+
+bool RCallStreamed(BERTBuffers::CallResponse &rsp, const BERTBuffers::CallResponse &call, uint32_t chunk_cells,
+  const std::function<void(const BERTBuffers::CallResponse &message, bool more)> &emit) {
+
+  int err = 0;
+  bool streamed = false;
+
+  SEXP result = PROTECT(RCallSEXP(call.function_call(), true, err));
+
+  if (err) {
+    rsp.set_err("parse error");
+  }
+  else {
+
+    std::vector<SEXP> columns;
+    int remaining = StreamHeader(rsp.mutable_result()->mutable_arr(), result, columns);
+
+    if (remaining > (int)chunk_cells) {
+
+      // header first, so the other side can allocate
+
+      emit(rsp, true);
+      streamed = true;
+
+      // chunks are column-major, matching the array data. the chunk message 
+      // is reused; clearing it keeps the allocated elements.
+
+      BERTBuffers::CallResponse chunk;
+      BERTBuffers::Array *arr = chunk.mutable_result()->mutable_arr();
+      int pending = 0;
+
+      for (auto column : columns) {
+        int len = Rf_length(column);
+        for (int start = 0; start < len; ) {
+          int count = (int)chunk_cells - pending;
+          if (count > len - start) count = len - start;
+          HandleSimpleTypes(column, start + count, TYPEOF(column), arr, 0, start);
+          start += count;
+          pending += count;
+          remaining -= count;
+          if (pending >= (int)chunk_cells || !remaining) {
+            chunk.set_id(rsp.id());
+            emit(chunk, remaining > 0);
+            chunk.Clear();
+            arr = chunk.mutable_result()->mutable_arr();
+            pending = 0;
+          }
+        }
+      }
+
+    }
+    else {
+      rsp.clear_result();
+      SEXPToVariable(rsp.mutable_result(), result);
+    }
+  }
+
+  UNPROTECT(1);
+  return streamed;
+}
+
 BERTBuffers::CallResponse& RExec(BERTBuffers::CallResponse &rsp, const BERTBuffers::CallResponse &call) {
 
   auto code = call.code();
@@ -901,6 +1311,24 @@ BERTBuffers::CallResponse& RExec(BERTBuffers::CallResponse &rsp, const BERTBuffe
     return rsp;
   }
 
+  // the startup code is the same every time, so it can come from the 
+  // bytecode cache. it doesn't return a value.
+
+  if (code.startup() && bytecode_cache.enabled()) {
+    std::string contents;
+    for (int i = 0; i < count; i++) {
+      contents.append(code.line(i));
+      contents.append("\n");
+    }
+    int err = 0;
+    if (bytecode_cache.Evaluate(contents, "", err)) {
+      if (err) rsp.set_err("R error");
+      else rsp.mutable_result()->set_boolean(true);
+      std::cout << BytecodeCacheReport() << std::endl;
+      return rsp;
+    }
+  }
+
   SEXP cmds = PROTECT(Rf_allocVector(STRSXP, count));
 
   for (int i = 0; i < count; i++) {
@@ -915,11 +1343,16 @@ BERTBuffers::CallResponse& RExec(BERTBuffers::CallResponse &rsp, const BERTBuffe
     rsp.set_err("R parse error");
   }
   else {
+
+    // the startup code sets up the global environment; other code runs
+    // in the active client's environment (if there is one)
+
+    SEXP env = code.startup() ? R_GlobalEnv : ActiveEnvironment();
     SEXP result = R_NilValue;
     int err = 0, len = Rf_length(parsed);
     for (int i = 0; !err && i < Rf_length(parsed); i++) {
       SEXP cmd = VECTOR_ELT(parsed, i);
-      result = R_tryEval(cmd, R_GlobalEnv, &err);
+      result = R_tryEval(cmd, env, &err);
     }
     if (err) rsp.set_err("R error");
     else if (call.wait()) SEXPToVariable(rsp.mutable_result(), result);
@@ -135,17 +135,20 @@ void RGetVersion(int32_t *major, int32_t *minor, int32_t *patch) {
 }
 
 /**
- * runs the main R loop; the rest of the code interacts via callbacks
+ * sets up R and registers our routines. R holds on to the home paths, so 
+ * they're static (R only starts once per process).
  */
-int RLoop(const char *rhome, const char *ruser, int argc, char ** argv) {
+int RInitialize(const char *rhome, const char *ruser, int argc, char **argv, bool interactive) {
 
-  Rstart Rp = new structRstart;
+  static structRstart Rstruct;
+  static char local_rhome[MAX_PATH];
+  static char local_ruser[MAX_PATH];
+
+  Rstart Rp = &Rstruct;
 
-  char *local_rhome = new char[MAX_PATH];
   if(rhome) strcpy_s(local_rhome, MAX_PATH, rhome);
   else local_rhome[0] = 0;
 
-  char *local_ruser = new char[MAX_PATH];
   if(ruser) strcpy_s(local_ruser, MAX_PATH, ruser);
   else local_ruser[0] = 0;
 
@@ -158,7 +161,7 @@ int RLoop(const char *rhome, const char *ruser, int argc, char ** argv) {
   // typedef enum {RGui, RTerm, LinkDLL} UImode;
   // Rp->CharacterMode = LinkDLL;
   Rp->CharacterMode = RTerm;
-  Rp->R_Interactive = TRUE;
+  Rp->R_Interactive = interactive ? TRUE : FALSE;
 
   Rp->ReadConsole = R_ReadConsole;
   Rp->WriteConsole = NULL;
@@ -196,14 +199,20 @@ int RLoop(const char *rhome, const char *ruser, int argc, char ** argv) {
   R_RegisterCCallable("BERTControlR", "Callback", (DL_FUNC)RCallback);
   R_RegisterCCallable("BERTControlR", "COMCallback", (DL_FUNC)COMCallback);
 
-  // now run the loop
-  run_Rmainloop();
+  return 0;
 
-  // clean up
-  delete[] local_ruser;
-  delete[] local_rhome;
+}
 
-  delete Rp;
+/**
+ * runs the main R loop; the rest of the code interacts via callbacks
+ */
+int RLoop(const char *rhome, const char *ruser, int argc, char ** argv) {
+
+  int result = RInitialize(rhome, ruser, argc, argv, true);
+  if (result) return result;
+
+  // now run the loop
+  run_Rmainloop();
 
   Rf_endEmbeddedR(0);
 
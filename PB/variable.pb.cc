@@ -733,6 +733,7 @@ const ::google::protobuf::uint32 TableStruct::offsets[] GOOGLE_PROTOBUF_ATTRIBUT
   ~0u,  // no _weak_field_map_
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::BERTBuffers::CallResponse, id_),
   GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::BERTBuffers::CallResponse, wait_),
+  GOOGLE_PROTOBUF_GENERATED_MESSAGE_FIELD_OFFSET(::BERTBuffers::CallResponse, timeout_),
   offsetof(::BERTBuffers::CallResponseDefaultTypeInternal, err_),
   offsetof(::BERTBuffers::CallResponseDefaultTypeInternal, result_),
   offsetof(::BERTBuffers::CallResponseDefaultTypeInternal, console_),
@@ -876,25 +877,25 @@ void AddDescriptorsImpl() {
       "ace_name\030\001 \001(\t\022\017\n\007pointer\030\002 \001(\004\0222\n\tfunct"
       "ions\030\003 \003(\0132\037.BERTBuffers.FunctionDescrip"
       "tor\022$\n\005enums\030\004 \003(\0132\025.BERTBuffers.EnumTyp"
-      "e\"\333\002\n\014CallResponse\022\n\n\002id\030\001 \001(\r\022\014\n\004wait\030\002"
-      " \001(\010\022\r\n\003err\030\003 \001(\tH\000\022\'\n\006result\030\004 \001(\0132\025.BE"
-      "RTBuffers.VariableH\000\022\'\n\007console\030\005 \001(\0132\024."
-      "BERTBuffers.ConsoleH\000\022!\n\004code\030\006 \001(\0132\021.BE"
-      "RTBuffers.CodeH\000\022\027\n\rshell_command\030\007 \001(\tH"
-      "\000\022;\n\rfunction_call\030\010 \001(\0132\".BERTBuffers.C"
-      "ompositeFunctionCallH\000\0222\n\rfunction_list\030"
-      "\t \001(\0132\031.BERTBuffers.FunctionListH\000\022\026\n\014us"
-      "er_command\030\n \001(\rH\000B\013\n\toperation*N\n\tError"
-      "Type\022\013\n\007GENERIC\020\000\022\006\n\002NA\020\001\022\007\n\003INF\020\002\022\t\n\005PA"
-      "RSE\020\003\022\r\n\tEXECUTION\020\004\022\t\n\005OTHER\020\017*(\n\010CallT"
-      "ype\022\n\n\006method\020\000\022\007\n\003get\020\001\022\007\n\003put\020\002*=\n\nCal"
-      "lTarget\022\014\n\010language\020\000\022\007\n\003COM\020\001\022\n\n\006system"
-      "\020\002\022\014\n\010graphics\020\003*3\n\025GraphicsUpdateComman"
-      "d\022\n\n\006update\020\000\022\016\n\nquery_size\020\001B\002H\001b\006proto"
-      "3"
+      "e\"\354\002\n\014CallResponse\022\n\n\002id\030\001 \001(\r\022\014\n\004wait\030\002"
+      " \001(\010\022\017\n\007timeout\030\013 \001(\r\022\r\n\003err\030\003 \001(\tH\000\022\'\n\006"
+      "result\030\004 \001(\0132\025.BERTBuffers.VariableH\000\022\'\n"
+      "\007console\030\005 \001(\0132\024.BERTBuffers.ConsoleH\000\022!"
+      "\n\004code\030\006 \001(\0132\021.BERTBuffers.CodeH\000\022\027\n\rshe"
+      "ll_command\030\007 \001(\tH\000\022;\n\rfunction_call\030\010 \001("
+      "\0132\".BERTBuffers.CompositeFunctionCallH\000\022"
+      "2\n\rfunction_list\030\t \001(\0132\031.BERTBuffers.Fun"
+      "ctionListH\000\022\026\n\014user_command\030\n \001(\rH\000B\013\n\to"
+      "peration*N\n\tErrorType\022\013\n\007GENERIC\020\000\022\006\n\002NA"
+      "\020\001\022\007\n\003INF\020\002\022\t\n\005PARSE\020\003\022\r\n\tEXECUTION\020\004\022\t\n"
+      "\005OTHER\020\017*(\n\010CallType\022\n\n\006method\020\000\022\007\n\003get\020"
+      "\001\022\007\n\003put\020\002*=\n\nCallTarget\022\014\n\010language\020\000\022\007"
+      "\n\003COM\020\001\022\n\n\006system\020\002\022\014\n\010graphics\020\003*3\n\025Gra"
+      "phicsUpdateCommand\022\n\n\006update\020\000\022\016\n\nquery_"
+      "size\020\001B\002H\001b\006proto3"
   };
   ::google::protobuf::DescriptorPool::InternalAddGeneratedFile(
-      descriptor, 3201);
+      descriptor, 3218);
   ::google::protobuf::MessageFactory::InternalRegisterGeneratedFile(
     "variable.proto", &protobuf_RegisterTypes);
 }
@@ -9469,6 +9470,7 @@ void CallResponse::set_allocated_function_list(::BERTBuffers::FunctionList* func
 #if !defined(_MSC_VER) || _MSC_VER >= 1900
 const int CallResponse::kIdFieldNumber;
 const int CallResponse::kWaitFieldNumber;
+const int CallResponse::kTimeoutFieldNumber;
 const int CallResponse::kErrFieldNumber;
 const int CallResponse::kResultFieldNumber;
 const int CallResponse::kConsoleFieldNumber;
@@ -9493,8 +9495,8 @@ CallResponse::CallResponse(const CallResponse& from)
       _cached_size_(0) {
   _internal_metadata_.MergeFrom(from._internal_metadata_);
   ::memcpy(&id_, &from.id_,
-    static_cast<size_t>(reinterpret_cast<char*>(&wait_) -
-    reinterpret_cast<char*>(&id_)) + sizeof(wait_));
+    static_cast<size_t>(reinterpret_cast<char*>(&timeout_) -
+    reinterpret_cast<char*>(&id_)) + sizeof(timeout_));
   clear_has_operation();
   switch (from.operation_case()) {
     case kErr: {
@@ -9538,8 +9540,8 @@ CallResponse::CallResponse(const CallResponse& from)
 
 void CallResponse::SharedCtor() {
   ::memset(&id_, 0, static_cast<size_t>(
-      reinterpret_cast<char*>(&wait_) -
-      reinterpret_cast<char*>(&id_)) + sizeof(wait_));
+      reinterpret_cast<char*>(&timeout_) -
+      reinterpret_cast<char*>(&id_)) + sizeof(timeout_));
   clear_has_operation();
   _cached_size_ = 0;
 }
@@ -9628,8 +9630,8 @@ void CallResponse::Clear() {
   (void) cached_has_bits;
 
   ::memset(&id_, 0, static_cast<size_t>(
-      reinterpret_cast<char*>(&wait_) -
-      reinterpret_cast<char*>(&id_)) + sizeof(wait_));
+      reinterpret_cast<char*>(&timeout_) -
+      reinterpret_cast<char*>(&id_)) + sizeof(timeout_));
   clear_operation();
   _internal_metadata_.Clear();
 }
@@ -9779,6 +9781,20 @@ bool CallResponse::MergePartialFromCodedStream(
         break;
       }
 
+      // uint32 timeout = 11;
+      case 11: {
+        if (static_cast< ::google::protobuf::uint8>(tag) ==
+            static_cast< ::google::protobuf::uint8>(88u /* 88 & 0xFF */)) {
+
+          DO_((::google::protobuf::internal::WireFormatLite::ReadPrimitive<
+                   ::google::protobuf::uint32, ::google::protobuf::internal::WireFormatLite::TYPE_UINT32>(
+                 input, &timeout_)));
+        } else {
+          goto handle_unusual;
+        }
+        break;
+      }
+
       default: {
       handle_unusual:
         if (tag == 0) {
@@ -9870,6 +9886,11 @@ void CallResponse::SerializeWithCachedSizes(
     ::google::protobuf::internal::WireFormatLite::WriteUInt32(10, this->user_command(), output);
   }
 
+  // uint32 timeout = 11;
+  if (this->timeout() != 0) {
+    ::google::protobuf::internal::WireFormatLite::WriteUInt32(11, this->timeout(), output);
+  }
+
   if ((_internal_metadata_.have_unknown_fields() &&  ::google::protobuf::internal::GetProto3PreserveUnknownsDefault())) {
     ::google::protobuf::internal::WireFormat::SerializeUnknownFields(
         (::google::protobuf::internal::GetProto3PreserveUnknownsDefault()   ? _internal_metadata_.unknown_fields()   : _internal_metadata_.default_instance()), output);
@@ -9956,6 +9977,11 @@ void CallResponse::SerializeWithCachedSizes(
     target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(10, this->user_command(), target);
   }
 
+  // uint32 timeout = 11;
+  if (this->timeout() != 0) {
+    target = ::google::protobuf::internal::WireFormatLite::WriteUInt32ToArray(11, this->timeout(), target);
+  }
+
   if ((_internal_metadata_.have_unknown_fields() &&  ::google::protobuf::internal::GetProto3PreserveUnknownsDefault())) {
     target = ::google::protobuf::internal::WireFormat::SerializeUnknownFieldsToArray(
         (::google::protobuf::internal::GetProto3PreserveUnknownsDefault()   ? _internal_metadata_.unknown_fields()   : _internal_metadata_.default_instance()), target);
@@ -9985,6 +10011,13 @@ size_t CallResponse::ByteSizeLong() const {
     total_size += 1 + 1;
   }
 
+  // uint32 timeout = 11;
+  if (this->timeout() != 0) {
+    total_size += 1 +
+      ::google::protobuf::internal::WireFormatLite::UInt32Size(
+        this->timeout());
+  }
+
   switch (operation_case()) {
     // string err = 3;
     case kErr: {
@@ -10081,6 +10114,9 @@ void CallResponse::MergeFrom(const CallResponse& from) {
   if (from.wait() != 0) {
     set_wait(from.wait());
   }
+  if (from.timeout() != 0) {
+    set_timeout(from.timeout());
+  }
   switch (from.operation_case()) {
     case kErr: {
       set_err(from.err());
@@ -10146,6 +10182,7 @@ void CallResponse::InternalSwap(CallResponse* other) {
   using std::swap;
   swap(id_, other->id_);
   swap(wait_, other->wait_);
+  swap(timeout_, other->timeout_);
   swap(operation_, other->operation_);
   swap(_oneof_case_[0], other->_oneof_case_[0]);
   _internal_metadata_.Swap(&other->_internal_metadata_);
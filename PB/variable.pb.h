@@ -3217,6 +3217,12 @@ class CallResponse : public ::google::protobuf::Message /* @@protoc_insertion_po
   bool wait() const;
   void set_wait(bool value);
 
+  // uint32 timeout = 11;
+  void clear_timeout();
+  static const int kTimeoutFieldNumber = 11;
+  ::google::protobuf::uint32 timeout() const;
+  void set_timeout(::google::protobuf::uint32 value);
+
   // string err = 3;
   private:
   bool has_err() const;
@@ -3324,6 +3330,7 @@ class CallResponse : public ::google::protobuf::Message /* @@protoc_insertion_po
   ::google::protobuf::internal::InternalMetadataWithArena _internal_metadata_;
   ::google::protobuf::uint32 id_;
   bool wait_;
+  ::google::protobuf::uint32 timeout_;
   union OperationUnion {
     OperationUnion() {}
     ::google::protobuf::internal::ArenaStringPtr err_;
@@ -6724,6 +6731,20 @@ inline void CallResponse::set_wait(bool value) {
   // @@protoc_insertion_point(field_set:BERTBuffers.CallResponse.wait)
 }
 
+// uint32 timeout = 11;
+inline void CallResponse::clear_timeout() {
+  timeout_ = 0u;
+}
+inline ::google::protobuf::uint32 CallResponse::timeout() const {
+  // @@protoc_insertion_point(field_get:BERTBuffers.CallResponse.timeout)
+  return timeout_;
+}
+inline void CallResponse::set_timeout(::google::protobuf::uint32 value) {
+  
+  timeout_ = value;
+  // @@protoc_insertion_point(field_set:BERTBuffers.CallResponse.timeout)
+}
+
 // string err = 3;
 inline bool CallResponse::has_err() const {
   return operation_case() == kErr;